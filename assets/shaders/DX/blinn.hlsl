@@ -4,9 +4,10 @@ cbuffer viewConstants : register(b0) {
     float4x4 proj;  
 }
 
+// one run of instances: each is its world matrix followed by its bones, instanceInfo.x matrices apart
 cbuffer cbPerObject : register(b1) {
-    float4x4 world : WORLD;
-	float4x4 boneOffsets[255];
+    uint4 instanceInfo;
+	float4x4 instanceMatrices[1023];
 }
 
 cbuffer material : register ( b2 ) {
@@ -35,13 +36,16 @@ struct VS_OUTPUT {
     float4 vPosition : SV_POSITION;
 };
 
-VS_OUTPUT VSMain( VS_INPUT Input ) {  
+VS_OUTPUT VSMain( VS_INPUT Input, uint instanceId : SV_InstanceID ) {  
     VS_OUTPUT output;
 	
-	float4x4 skin = Input.vBoneWeights.x * boneOffsets[Input.vBoneIds.x];
-	skin += Input.vBoneWeights.y * boneOffsets[Input.vBoneIds.y];
-	skin += Input.vBoneWeights.z * boneOffsets[Input.vBoneIds.z];
-	skin += Input.vBoneWeights.w * boneOffsets[Input.vBoneIds.w];
+	uint base = instanceId * instanceInfo.x;
+	float4x4 world = instanceMatrices[base];
+	uint4 bones = base + 1 + Input.vBoneIds;
+	float4x4 skin = Input.vBoneWeights.x * instanceMatrices[bones.x];
+	skin += Input.vBoneWeights.y * instanceMatrices[bones.y];
+	skin += Input.vBoneWeights.z * instanceMatrices[bones.z];
+	skin += Input.vBoneWeights.w * instanceMatrices[bones.w];
 	
 
 	float4 worldPos = mul(world, mul(float4(Input.vPos, 1.f), skin));
@@ -15,9 +15,10 @@ layout(std140) uniform _b0_viewConstants {
     mat4 b0_proj;
 };
 
+// one run of instances: each is its world matrix followed by its bones, b1_instanceInfo.x matrices apart
 layout(std140) uniform _b1_objectConstants {
-    mat4 b1_world;    
-	mat4 b1_boneOffsets[255];
+    uvec4 b1_instanceInfo;
+	mat4 b1_instanceMatrices[1023];
 };
 
 // output
@@ -32,12 +33,15 @@ out gl_PerVertex {
 ////////////////////////////////////////////////////////
 
 void main() {	
-    mat4 BoneTransform = b1_boneOffsets[a_boneIds.x] * a_boneWeights.x;
-    BoneTransform     += b1_boneOffsets[a_boneIds.y] * a_boneWeights.y;
-    BoneTransform     += b1_boneOffsets[a_boneIds.z] * a_boneWeights.z;
-    BoneTransform     += b1_boneOffsets[a_boneIds.w] * a_boneWeights.w;
-
-    vec4 worldPosition = b1_world * ( vec4(a_pos, 1.0) * BoneTransform);
+    uint  base  = uint(gl_InstanceID) * b1_instanceInfo.x;
+    mat4  world = b1_instanceMatrices[base];
+    uvec4 bones = base + 1u + a_boneIds;
+    mat4 BoneTransform = b1_instanceMatrices[bones.x] * a_boneWeights.x;
+    BoneTransform     += b1_instanceMatrices[bones.y] * a_boneWeights.y;
+    BoneTransform     += b1_instanceMatrices[bones.z] * a_boneWeights.z;
+    BoneTransform     += b1_instanceMatrices[bones.w] * a_boneWeights.w;
+
+    vec4 worldPosition = world * ( vec4(a_pos, 1.0) * BoneTransform);
 
     o_tex = a_tex;
     o_normal = a_norm; //normalize((invWV * vec4(norm, 1.0)).xyz);
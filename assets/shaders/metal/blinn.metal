@@ -24,9 +24,10 @@ struct ViewConstants {
     float4x4 proj;
 };
 
+// one run of instances: each is its world matrix followed by its bones, instanceInfo.x matrices apart
 struct ObjectConstants {
-    float4x4 world;
-	float4x4 boneOffsets[255];
+    uint4    instanceInfo;
+	float4x4 instanceMatrices[1023];
 };
 
 struct MaterialConstants {
@@ -37,13 +38,17 @@ struct MaterialConstants {
     float  ns;
 };
 
-vertex VertexOut blinn_vertex(VertexIn attributes[[stage_in]], constant ViewConstants& view[[buffer(1)]], constant ObjectConstants& obj[[buffer(2)]]) {
-    float4x4 BoneTransform = obj.boneOffsets[attributes.boneIds.x] * attributes.boneWeights.x;
-    BoneTransform     += obj.boneOffsets[attributes.boneIds.y] * attributes.boneWeights.y;
-    BoneTransform     += obj.boneOffsets[attributes.boneIds.z] * attributes.boneWeights.z;
-    BoneTransform     += obj.boneOffsets[attributes.boneIds.w] * attributes.boneWeights.w;
+vertex VertexOut blinn_vertex(VertexIn attributes[[stage_in]], constant ViewConstants& view[[buffer(1)]], constant ObjectConstants& obj[[buffer(2)]],
+                              uint instanceId[[instance_id]]) {
+    uint     base  = instanceId * obj.instanceInfo.x;
+    float4x4 world = obj.instanceMatrices[base];
+    uint4    bones = base + 1 + attributes.boneIds;
+    float4x4 BoneTransform = obj.instanceMatrices[bones.x] * attributes.boneWeights.x;
+    BoneTransform     += obj.instanceMatrices[bones.y] * attributes.boneWeights.y;
+    BoneTransform     += obj.instanceMatrices[bones.z] * attributes.boneWeights.z;
+    BoneTransform     += obj.instanceMatrices[bones.w] * attributes.boneWeights.w;
 	
-    float4 worldPos = obj.world * (float4(attributes.position.x, attributes.position.y, attributes.position.z, 1.f) * BoneTransform);
+    float4 worldPos = world * (float4(attributes.position.x, attributes.position.y, attributes.position.z, 1.f) * BoneTransform);
 
     VertexOut outputValue;
     outputValue.texture  = attributes.texture;
@@ -1,5 +1,7 @@
 #include "App.h"
+#include "Benchmarks.h"
 #include "Camera.h"
+#include "CaptureCommands.h"
 #include "Helpers.h"
 #include "Log.h"
 #include "RenderEngine.h"
@@ -17,6 +19,7 @@
 #include "PlayerCtrlManager.h"
 #include "SimulationManager.h"
 #include "EventManager.h"
+#include "FramePipeline.h"
 #include "SkyRenderer.h"
 #include "MeshRenderer.h"
 #include "Spatial.h"
@@ -26,13 +29,15 @@
 #include "MeshGeneration.h"
 #include "AnimationManager.h"
 #include "SkinnedMesh.h"
+#include "StateGroupEncoder.h"
 #include "AnimationComponent.h"
 #include "ComponentManager.h"
 
 uint32_t frame_count = 0;
 double taccumulate = 0;
 double total_frame_count = 0;
-Camera cam;
+Camera cam;       // simulation side, moved by PlayerCtrlManager
+Camera renderCam; // what gets rendered, updated from frame snapshots
 input::InputManager* inputManager;
 RenderEngine* renderEngine;
 RenderView* playerView;
@@ -40,6 +45,7 @@ Viewport* playerViewport;
 
 SimulationManager* simulationManager;
 EventManager* eventManager;
+FramePipeline* framePipeline;
 
 ui::ConsoleUI* consoleUI;
 ui::DebugUI* debugUI;
@@ -148,9 +154,6 @@ void SetupUI(gfx::RenderDevice* renderDevice, Viewport* viewport) {
 
     // Show/Hide sample text test with this call
     ui::LabelUI::AttachLabel(ui, "hey look im a label");
-
-    simulationManager->RegisterManager<ui::UIManager>({ ComponentType::UI, ComponentType::Spatial }, eventManager, inputManager->GetKeyboardManager(), inputManager->GetDebugContext(), *viewport,
-        renderEngine->Renderers().text.get(), renderEngine->Renderers().ui.get(), renderEngine->debugDraw());
 }
 
 void AddWorldText() {
@@ -203,7 +206,7 @@ void App::OnStart() {
     playerViewport                = new Viewport();
     playerViewport->width         = static_cast<float>(windowSize.width);
     playerViewport->height        = static_cast<float>(windowSize.height);
-    playerView                    = new RenderView(&cam, playerViewport);
+    playerView                    = new RenderView(&renderCam, playerViewport);
     renderEngine                  = new RenderEngine(renderDevice, swapchain, playerView);
     eventManager                  = new EventManager();
     inputManager                  = new input::InputManager(eventManager);
@@ -213,11 +216,15 @@ void App::OnStart() {
     AddWorldText();
 
     SetupInputBindings();
+    bench::RegisterConsoleCommand();
+    gfx::capture::RegisterConsoleCommands(renderDevice);
 
     // cam.MoveTo(-2826, 1620, 1600);
     cam.MoveTo(0, 0, 2000);
     cam.LookAt(0, 0, 0);
 
+    framePipeline = new FramePipeline(FramePipeline::PipelinedFromConfig(), renderEngine->Renderers().mesh.get(), &cam, &renderCam);
+
     SkyboxRenderObj* skybox = CreateSkybox();
 //    renderEngine->Renderers().sky->Register(skybox);
 
@@ -227,13 +234,21 @@ void App::OnStart() {
     //AddArthas();
     AddRoxas();
 
-    simulationManager->RegisterManager<PlayerCtrlManager>({ ComponentType::PlayerControlled, ComponentType::Spatial, ComponentType::Animation }, &cam, inputContextPlayer);
+    simulationManager->RegisterManager<PlayerCtrlManager>(ComponentAccess({ ComponentType::PlayerControlled }, { ComponentType::Spatial, ComponentType::Animation }), &cam, inputContextPlayer);
+
+    // managers only wait on earlier conflicting ones. player control writes what the other two read, after it animation
+    // (worker) and ui (frame thread) only read spatial and run side by side
+    simulationManager->RegisterManager<AnimationManager>(ComponentAccess({ ComponentType::SkinnedMesh, ComponentType::Spatial, ComponentType::Animation }, {}),
+        eventManager, framePipeline, renderEngine->animationCache());
 
-    simulationManager->RegisterManager<AnimationManager>({ ComponentType::SkinnedMesh, ComponentType::Spatial, ComponentType::Animation },
-        eventManager, renderEngine->Renderers().mesh.get(), renderEngine->animationCache());
+    simulationManager->RegisterManager<ui::UIManager>(ComponentAccess({ ComponentType::Spatial }, { ComponentType::UI }), eventManager, inputManager->GetKeyboardManager(), inputManager->GetDebugContext(), *playerViewport,
+        renderEngine->Renderers().text.get(), renderEngine->Renderers().ui.get(), renderEngine->debugDraw());
 }
 
 void App::OnFrame(const std::vector<float>& inputValues, float dt) {
+    // when pipelined this waits on last frame's simulation, nothing below may touch sim state before it
+    framePipeline->BeginFrame();
+
     // TODO:: Maybe have system pump events instead of polling?
     sys::SysWindowSize windowSize = sys::GetWindowSize();
     if (windowSize.width != static_cast<uint32_t>(playerViewport->width) || windowSize.height != static_cast<uint32_t>(playerViewport->height)) {
@@ -248,9 +263,16 @@ void App::OnFrame(const std::vector<float>& inputValues, float dt) {
     inputManager->ProcessInputs(inputValues, dt * 1000);
     sys::ShowCursor(inputManager->ShouldShowCursor());
 
-    simulationManager->DoUpdate(dt * 1000);
+    if (framePipeline->IsPipelined()) {
+        simulationManager->DoFrameThreadUpdate(dt * 1000);
+        framePipeline->Simulate([dt]() { simulationManager->DoWorkerUpdate(dt * 1000); });
+    } else {
+        // one graph, frame thread managers run here while the rest run on workers
+        framePipeline->Simulate([dt]() { simulationManager->DoUpdate(dt * 1000); });
+    }
 
     // render
+    // pipelined, this draws last frame's snapshot while the worker simulates this one
     // todo: link skinnedmesh's somehow to this correctly
     RenderScene scene;
 //    scene.renderObjects.push_back(terrain.get());
@@ -264,22 +286,37 @@ void App::OnFrame(const std::vector<float>& inputValues, float dt) {
 
     if (taccumulate > 1.0) {
         debugUI->AddKeyValue("FPS", std::to_string(frame_count));
-//        debugUI->AddKeyValue("DrawCalls", std::to_string(renderDevice->DrawCallCount()));
-        debugUI->AddKeyValue("U", ToString(cam.up));
-        debugUI->AddKeyValue("L", ToString(cam.look));
-        debugUI->AddKeyValue("R", ToString(cam.right));
+        const RenderQueueStats& frameStats = renderEngine->FrameStats();
+        debugUI->AddKeyValue("DrawCalls", std::to_string(frameStats.drawCalls) + " (" + std::to_string(frameStats.instances) + " instances)");
+        debugUI->AddKeyValue("PipelineChanges", std::to_string(frameStats.pipelineStateChanges));
+        debugUI->AddKeyValue("SkippedBinds", std::to_string(frameStats.redundantBindsSkipped));
+        PipelineStateCache::Stats psoStats = renderEngine->pipelineStateCache()->GetStats();
+        debugUI->AddKeyValue("PipelineStates", std::to_string(psoStats.pipelineStates) + " (" + std::to_string(psoStats.hits) + " hits/" +
+                                                   std::to_string(psoStats.misses) + " misses)");
+        VertexLayoutCache::Stats layoutStats = renderEngine->vertexLayoutCache()->GetStats();
+        debugUI->AddKeyValue("VertexLayouts", std::to_string(layoutStats.vertexLayouts) + " (" + std::to_string(layoutStats.hits) + " hits/" +
+                                                  std::to_string(layoutStats.misses) + " misses)");
+        gfx::StateGroupEncoder::TransientStats mergeStats = gfx::StateGroupEncoder::GetTransientStats();
+        debugUI->AddKeyValue("StateGroupMerges", std::to_string(mergeStats.merges) + " (" + std::to_string(mergeStats.hits) + " cached, " +
+                                                     std::to_string(mergeStats.arenaBytes) + " bytes)");
+        const TransientBufferRing::Stats& ringStats = renderEngine->transientConstants()->GetStats();
+        debugUI->AddKeyValue("TransientConstants", std::to_string(ringStats.bytesUsed) + "/" + std::to_string(ringStats.frameSize) + " bytes (" +
+                                                       std::to_string(ringStats.allocations) + " allocs)");
+        debugUI->AddKeyValue("U", ToString(renderCam.up));
+        debugUI->AddKeyValue("L", ToString(renderCam.look));
+        debugUI->AddKeyValue("R", ToString(renderCam.right));
 
         std::stringstream ss;
         ss << "gfx Device: " << renderDevice->DeviceConfig.DeviceAbbreviation;
         ss << " | FPS: " << frame_count << " | Frame: " << total_frame_count;
-        ss << " | Pos: " << cam.pos;
+        ss << " | Pos: " << renderCam.pos;
         sys::SetWindowTitle(ss.str().c_str());
         frame_count = 0;
         taccumulate = 0.0;
     }
 }
 
-void App::OnShutdown() {}
+void App::OnShutdown() { framePipeline->Flush(); }
 
 void App::OnWindowResize(uint32_t width, uint32_t height)
 {
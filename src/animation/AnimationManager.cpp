@@ -3,7 +3,8 @@
 #include "AnimationComponent.h"
 #include "AnimationData.h"
 #include "SimObj.h"
-#include "MeshRenderer.h"
+#include "FramePipeline.h"
+#include "TaskScheduler.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtx/compatibility.hpp>
@@ -13,7 +14,6 @@
 #include <glm/gtx/transform.hpp>
 
 #include <algorithm>
-#include <queue>
 
 void AnimationManager::AddAnimationObj(uint64_t key, SkinnedMesh* skinnedMesh, AnimationComponent* anim, Spatial* spatial) {
     dg_assert_nm(skinnedMesh != nullptr);
@@ -23,6 +23,11 @@ void AnimationManager::AddAnimationObj(uint64_t key, SkinnedMesh* skinnedMesh, A
     AnimationPtr cache = m_animationCache->Get(anim->cacheKey);
     dg_assert(cache != nullptr, "animation not found in cache");
 
+    auto existing = m_managedAnimations.find(key);
+    if (existing != m_managedAnimations.end()) {
+        RetireRenderObj(&existing->second);
+    }
+
     ManagedAnimation managedAnim;
     managedAnim.meshRenderObj = std::make_unique<MeshRenderObj>(skinnedMesh->mesh, skinnedMesh->mat);
     managedAnim.animation = cache;
@@ -33,103 +38,84 @@ void AnimationManager::AddAnimationObj(uint64_t key, SkinnedMesh* skinnedMesh, A
     managedAnim.dir = spatial->direction;
     managedAnim.pos = spatial->pos;
 
-    managedAnim.meshRenderObj->transform()->scale(skinnedMesh->scale);
+    managedAnim.skeleton = GetSkeleton(skinnedMesh->mesh);
+    managedAnim.clips = GetClipSet(skinnedMesh->mesh, cache);
 
-    // This should help a bit with speed at the cost of more memory usage
-    size_t idx = 0;
-    for (const auto &bone : skinnedMesh->mesh->GetBones()) {
-        managedAnim.boneMapping[bone.first] = idx;
-        idx++;
-    }
+    managedAnim.transform.scale(skinnedMesh->scale);
 
-    m_meshRenderer->Register(managedAnim.meshRenderObj.get());
+    m_framePipeline->SimSnapshot()->newMeshRenderObjs.push_back(managedAnim.meshRenderObj.get());
     m_managedAnimations[key] = std::move(managedAnim);
 }
 
-void AnimationManager::UpdateAnimationObj(uint64_t key, SkinnedMesh* skinnedMesh, AnimationComponent* anim, Spatial* spatial) {
-    dg_assert_nm(skinnedMesh != nullptr);
+void AnimationManager::UpdateAnimationObj(ManagedAnimation* managedAnim, AnimationComponent* anim, Spatial* spatial) {
+    dg_assert_nm(managedAnim != nullptr);
     dg_assert_nm(anim != nullptr);
     dg_assert_nm(spatial != nullptr);
 
-    auto& managedAnim = m_managedAnimations[key];
-
-    if (managedAnim.cacheKey != anim->cacheKey) {
-        AddAnimationObj(key, skinnedMesh, anim, spatial);
-        return;
-    }
-
-    managedAnim.dir = spatial->direction;
-    managedAnim.pos = spatial->pos;
+    managedAnim->dir = spatial->direction;
+    managedAnim->pos = spatial->pos;
 
-    managedAnim.meshRenderObj->transform()->translate(spatial->pos);
+    managedAnim->transform.translate(spatial->pos);
     if (glm::length(spatial->direction) > 0.0)
-        managedAnim.meshRenderObj->transform()->lookAt(spatial->pos, spatial->pos + spatial->direction, glm::vec3(0, 1, 0));
+        managedAnim->transform.lookAt(spatial->pos, spatial->pos + spatial->direction, glm::vec3(0, 1, 0));
 
-    if (managedAnim.type != anim->animationType) {
-        managedAnim.type = anim->animationType;
-        managedAnim.runningTime = 0.f;
+    if (managedAnim->type != anim->animationType) {
+        managedAnim->type = anim->animationType;
+        managedAnim->runningTime = 0.f;
     }
 }
 
-glm::vec3 AnimationManager::CalcInterpolatedScaling(float animTime, const AnimationData::AnimationNode& animNode) {
-    if (animNode.scales.size() == 1)
-        return animNode.scales[0].scale;
-
-    size_t scaleIdx = GetAnimKeyframeItemIdx(animNode.scales, animTime);
-    size_t nextIdx = scaleIdx + 1;
-
-    float deltaTime = (float)animNode.scales[nextIdx].time - (float)animNode.scales[scaleIdx].time;
-
-    return glm::lerp(animNode.scales[scaleIdx].scale, animNode.scales[nextIdx].scale, (float)((animTime - animNode.scales[scaleIdx].time) / deltaTime));
+// the renderer may still be drawing it, the snapshot keeps it alive until it's been unregistered
+void AnimationManager::RetireRenderObj(ManagedAnimation* managedAnim) {
+    if (managedAnim->meshRenderObj != nullptr) {
+        m_framePipeline->SimSnapshot()->retiredMeshRenderObjs.push_back(std::move(managedAnim->meshRenderObj));
+    }
 }
 
-glm::quat AnimationManager::CalcInterpolatedRotation(float animTime, const AnimationData::AnimationNode& animNode) {
-    if (animNode.rotations.size() == 1)
-        return animNode.rotations[0].rot;
-
-    size_t idx = GetAnimKeyframeItemIdx(animNode.rotations, animTime);
-    size_t nextIdx = idx + 1;
-
-    float deltaTime = (float)animNode.rotations[nextIdx].time - (float)animNode.rotations[idx].time;
-
-    return glm::normalize(glm::slerp(animNode.rotations[idx].rot, animNode.rotations[nextIdx].rot, (float)((animTime - animNode.rotations[idx].time) / deltaTime)));
+const Skeleton* AnimationManager::GetSkeleton(const MeshPtr& mesh) {
+    CachedSkeleton& cached = m_skeletons[mesh.get()];
+    if (cached.skeleton == nullptr) {
+        cached.mesh = mesh;
+        cached.skeleton = Skeleton::Build(*mesh);
+    }
+    return cached.skeleton.get();
 }
 
-glm::vec3 AnimationManager::CalcInterpolatedTrans(float animTime, const AnimationData::AnimationNode& animNode) {
-    if (animNode.translations.size() == 1)
-        return animNode.translations[0].scale;
-
-    size_t idx = GetAnimKeyframeItemIdx(animNode.translations, animTime);
-    size_t nextIdx = idx + 1;
-
-    float deltaTime = (float)animNode.translations[nextIdx].time - (float)animNode.translations[idx].time;
-
-    return glm::lerp(animNode.translations[idx].scale, animNode.translations[nextIdx].scale, (float)((animTime - animNode.translations[idx].time) / deltaTime));
+const SkeletonClipSet* AnimationManager::GetClipSet(const MeshPtr& mesh, const AnimationPtr& animation) {
+    CachedClipSet& cached = m_clipSets[{ mesh.get(), animation.get() }];
+    if (cached.clips == nullptr) {
+        cached.animation = animation;
+        cached.clips = SkeletonClipSet::Bind(*GetSkeleton(mesh), animation->animData);
+    }
+    return cached.clips.get();
 }
 
-void AnimationManager::DoUpdate(std::map<ComponentType, const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>& components, float ms) {
-    assert(components[ComponentType::SkinnedMesh] != nullptr);
-    assert(components[ComponentType::Animation] != nullptr);
-    assert(components[ComponentType::Spatial] != nullptr);
-
-    auto& meshs = *reinterpret_cast<const std::array<std::unique_ptr<SkinnedMesh>, MAX_SIM_OBJECTS>*>(components[ComponentType::SkinnedMesh]);
-    auto& anims = *reinterpret_cast<const std::array<std::unique_ptr<AnimationComponent>, MAX_SIM_OBJECTS>*>(components[ComponentType::Animation]);
-    auto& spatials = *reinterpret_cast<const std::array<std::unique_ptr<Spatial>, MAX_SIM_OBJECTS>*>(components[ComponentType::Spatial]);
-
-    for (size_t i = 0; i < MAX_SIM_OBJECTS; ++i) {
-        SkinnedMesh* mesh = meshs[i].get();
-        AnimationComponent* anim = anims[i].get();
-        auto spatial = spatials[i].get();
-        
-        if (mesh != nullptr && anim != nullptr && spatial != nullptr) {
-            auto it = m_managedAnimations.find(i);
-            if (it == m_managedAnimations.end())
-                AddAnimationObj(i, mesh, anim, spatial);
-            else 
-                UpdateAnimationObj(i, mesh, anim, spatial);
+void AnimationManager::DoUpdate(ComponentStore& components, float ms) {
+    // an entity that's already managed only touches its own entry, so those update wide. adding builds render objs and
+    // fills the skeleton caches, that waits for the loop to finish
+    m_pendingAdds.clear();
+    components.view<SkinnedMesh, AnimationComponent, Spatial>().parallelEach([&](EntityId entity, SkinnedMesh& mesh, AnimationComponent& anim, Spatial& spatial) {
+        auto it = m_managedAnimations.find(entity);
+        if (it == m_managedAnimations.end() || it->second.cacheKey != anim.cacheKey) {
+            std::lock_guard<std::mutex> lock(m_pendingAddsLock);
+            m_pendingAdds.push_back(entity);
+            return;
         }
-        else {
-            m_managedAnimations.erase(i);
+        UpdateAnimationObj(&it->second, &anim, &spatial);
+    });
+
+    // same order whatever the chunking was
+    std::sort(m_pendingAdds.begin(), m_pendingAdds.end());
+    for (EntityId entity : m_pendingAdds) {
+        AddAnimationObj(entity, components.TryGet<SkinnedMesh>(entity), components.TryGet<AnimationComponent>(entity), components.TryGet<Spatial>(entity));
+    }
+
+    for (auto it = m_managedAnimations.begin(); it != m_managedAnimations.end();) {
+        if (!components.Has<SkinnedMesh, AnimationComponent, Spatial>(static_cast<EntityId>(it->first))) {
+            RetireRenderObj(&it->second);
+            it = m_managedAnimations.erase(it);
+        } else {
+            ++it;
         }
     }
 
@@ -137,82 +123,77 @@ void AnimationManager::DoUpdate(std::map<ComponentType, const std::array<std::un
 }
 
 void AnimationManager::DoUpdate(float ms) {
-    for (auto& anim : m_managedAnimations) {
-        anim.second.runningTime += ms;
-
-        // todo: actually use type...somehow
-        std::string animKey = "";
-        switch (anim.second.type) {
-        case AnimationType::IDLE: animKey = "IDLE"; break;
-        case AnimationType::ATTACK: animKey = "ATTACK"; break;
-        case AnimationType::ATTACK_IDLE: animKey = "ATTACK_IDLE"; break;
-        case AnimationType::WALKING: animKey = "WALKING"; break;
-        default:
-            break;
-        }
-
-        const AnimationData* animData = nullptr;
-        auto it = anim.second.animation->animData.find(animKey);
-        if (it != anim.second.animation->animData.end())
-            animData = &it->second;
-        else
-            animData = &anim.second.animation->animData.begin()->second;
+    FrameSnapshot* snapshot = m_framePipeline->SimSnapshot();
 
-        dg_assert_nm(animData != nullptr);
-
-        // todo: theres probly a way to cache this instead, but maybe it wouldnt matter much
-        std::queue<std::pair<size_t, glm::mat4>> nodeQueue;
-        nodeQueue.push({ 0, glm::mat4() });
-
-        const BoneOffsetData& bones = anim.second.mesh->GetBones();
-        const MeshTreeData& tree = anim.second.mesh->GetTree();
-        const auto& meshNodes = anim.second.mesh->GetNodes();
+    // serial part: advance clocks and reserve every instance's palette slice up front, the palette can't grow once jobs
+    // are writing into it
+    m_poseJobs.clear();
+    for (auto& anim : m_managedAnimations) {
+        ManagedAnimation& managedAnim = anim.second;
+        managedAnim.runningTime += ms;
 
-        float tps = animData->ticksPerSecond == 0.f ? 25.f : (float)animData->ticksPerSecond;
-        float timeInTicks = tps * (anim.second.runningTime / 1000);
-        float animTime = fmod(timeInTicks, (float)animData->duration);
+        uint32_t boneCount = managedAnim.skeleton->BoneCount();
+        uint32_t boneOffset = snapshot->AllocateBones(boneCount);
 
-        std::vector<glm::mat4> finalBoneOffsets(bones.size());
+        FrameSnapshot::MeshInstance instance;
+        instance.renderObj = managedAnim.meshRenderObj.get();
+        instance.transform = managedAnim.transform;
+        instance.boneOffset = boneOffset;
+        instance.boneCount = boneCount;
+        snapshot->meshInstances.push_back(instance);
 
-        while (!nodeQueue.empty()) {
-            const auto &node = nodeQueue.front();
-            const MeshNode &meshNode = meshNodes[node.first];
+        m_poseJobs.push_back({ &managedAnim, boneOffset });
+    }
 
-            glm::mat4 transform = meshNode.localTransform;
+    // each instance only touches its own cursors and palette slice, so they can go wide. parallelFor joins before
+    // returning, after that the snapshot goes to the renderer as usual
+    glm::mat4* palette = snapshot->bonePalette.data();
+    scheduler()->parallelFor(m_poseJobs.size(), 1, [this, palette](size_t begin, size_t end) {
+        for (size_t idx = begin; idx < end; ++idx) {
+            EvaluatePose(m_poseJobs[idx].anim, palette + m_poseJobs[idx].boneOffset);
+        }
+    });
+}
 
-            auto animCheck = animData->animationNodes.find(meshNode.name);
-            if (animCheck != animData->animationNodes.end()) {
-                const auto& animNode = animCheck->second;
+void AnimationManager::EvaluatePose(ManagedAnimation* managedAnim, glm::mat4* finalBoneOffsets) {
+    // per thread scratch, sized for the biggest skeleton/clip this thread has seen
+    static thread_local ClipPose pose;
+    static thread_local std::vector<glm::mat4> globalTransforms;
 
-                glm::vec3 scaleVec = CalcInterpolatedScaling(animTime, animNode);
-                const glm::mat4 scale = glm::scale(glm::vec3{ scaleVec.x, scaleVec.y, scaleVec.z });
+    const Skeleton& skeleton = *managedAnim->skeleton;
+    const SkeletonClip& clip = managedAnim->clips->Clip(managedAnim->type);
 
-                glm::quat rotVec = CalcInterpolatedRotation(animTime, animNode);
-                const glm::mat4 rot = glm::toMat4(glm::quat{ rotVec.w, rotVec.x, rotVec.y, rotVec.z });
+    float timeInTicks = clip.ticksPerSecond * (managedAnim->runningTime / 1000);
+    float animTime = fmod(timeInTicks, clip.duration);
 
-                auto transVec = CalcInterpolatedTrans(animTime, animNode);
-                const glm::mat4 trans = glm::translate(glm::vec3{ transVec.x, transVec.y, transVec.z });
+    if (managedAnim->cursorClip != &clip) {
+        managedAnim->keyCursors.assign(clip.ChannelCount() * 3, 0);
+        managedAnim->cursorClip = &clip;
+    }
+    pose.Sample(clip.scales, clip.rotations, clip.translations, animTime, managedAnim->keyCursors.data());
 
-                transform = trans * rot * scale;
-            }
+    if (globalTransforms.size() < skeleton.NodeCount())
+        globalTransforms.resize(skeleton.NodeCount());
 
-            transform = node.second * transform;
+    // parents come first, so their global transform is always ready
+    for (uint32_t node = 0; node < skeleton.NodeCount(); ++node) {
+        glm::mat4 transform = skeleton.localTransforms[node];
 
-            auto boneCheck = anim.second.boneMapping.find(meshNode.name);
-            if (boneCheck != anim.second.boneMapping.end())
-                finalBoneOffsets[boneCheck->second] = glm::transpose(anim.second.mesh->GetGimt() * transform * bones[boneCheck->second].second);
+        uint32_t channel = clip.nodeChannels[node];
+        if (channel != SkeletonClip::kNoChannel) {
+            const glm::mat4 scale = glm::scale(glm::vec3{ pose.scaleX[channel], pose.scaleY[channel], pose.scaleZ[channel] });
+            const glm::mat4 rot = glm::toMat4(glm::quat{ pose.rotW[channel], pose.rotX[channel], pose.rotY[channel], pose.rotZ[channel] });
+            const glm::mat4 trans = glm::translate(glm::vec3{ pose.transX[channel], pose.transY[channel], pose.transZ[channel] });
 
-			nodeQueue.pop();
-			auto it = tree.find(node.first);
-            if (it != tree.end()) {
-                const auto& childs = it->second;
-                for (auto child : childs)
-                    nodeQueue.push({ child, transform });
-            }
-            else
-                LOG_E("Animation::DoUpdate. tree doesnt contain node as parent, its probly screwed up.");
+            transform = trans * rot * scale;
         }
 
-        anim.second.meshRenderObj->boneOffsets(finalBoneOffsets);
+        uint32_t parent = skeleton.parents[node];
+        glm::mat4& global = globalTransforms[node];
+        global = parent == Skeleton::kNoParent ? transform : globalTransforms[parent] * transform;
+
+        uint32_t boneSlot = skeleton.boneSlots[node];
+        if (boneSlot != Skeleton::kNoBone)
+            finalBoneOffsets[boneSlot] = glm::transpose(skeleton.gimt * global * skeleton.boneOffsets[boneSlot]);
     }
-}
\ No newline at end of file
+}
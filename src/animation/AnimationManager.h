@@ -7,54 +7,75 @@
 #include "Animation.h"
 #include "AnimationCache.h"
 #include "EventManager.h"
+#include "Skeleton.h"
+#include <map>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 
-class MeshRenderer;
+class FramePipeline;
 class SimObj;
 
 class AnimationManager : public ComponentManager {
 private:
     struct ManagedAnimation {
         std::unique_ptr<MeshRenderObj> meshRenderObj;
+        dm::Transform transform; // sim side copy, the render obj only sees it through the frame snapshot
         AnimationPtr animation;
         MeshPtr mesh;
+        const Skeleton* skeleton{nullptr};
+        const SkeletonClipSet* clips{nullptr};
+        const SkeletonClip* cursorClip{nullptr}; // clip keyCursors belong to
+        std::vector<uint32_t> keyCursors;        // see ClipPose::Sample
         float runningTime;
-        std::unordered_map<std::string, size_t> boneMapping;
         std::string cacheKey;
         AnimationType type;
         glm::dvec3 pos;
         glm::dvec3 dir;
     };
 
-    MeshRenderer* m_meshRenderer;
+    FramePipeline* m_framePipeline;
     AnimationCache* m_animationCache;
     std::map<uint64_t, ManagedAnimation> m_managedAnimations;
 
+    // built the first time a mesh/animation shows up, the ptrs keep the keys alive
+    struct CachedSkeleton {
+        MeshPtr mesh;
+        std::unique_ptr<Skeleton> skeleton;
+    };
+    struct CachedClipSet {
+        AnimationPtr animation;
+        std::unique_ptr<SkeletonClipSet> clips;
+    };
+    std::unordered_map<const Mesh*, CachedSkeleton> m_skeletons;
+    std::map<std::pair<const Mesh*, const Animation*>, CachedClipSet> m_clipSets;
+
+    // entities the view loop found new (or with a different cache key), added after it on the updating thread
+    std::vector<EntityId> m_pendingAdds;
+    std::mutex m_pendingAddsLock;
+
+    // one per instance per update, see DoUpdate(float)
+    struct PoseJob {
+        ManagedAnimation* anim;
+        uint32_t boneOffset;
+    };
+    std::vector<PoseJob> m_poseJobs;
+
 public:
-    AnimationManager(EventManager* em, MeshRenderer* meshRenderer, AnimationCache* animationCache)
-        : m_meshRenderer(meshRenderer)
+    AnimationManager(EventManager* em, FramePipeline* framePipeline, AnimationCache* animationCache)
+        : m_framePipeline(framePipeline)
         , m_animationCache(animationCache)
     {}
 
     void UpdateViewport(const Viewport& vp) override {}
-    void DoUpdate(std::map<ComponentType, const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>& components, float ms) override;
+    void DoUpdate(ComponentStore& components, float ms) override;
 
 private:
     void AddAnimationObj(uint64_t key, SkinnedMesh* skinnedMesh, AnimationComponent* anim, Spatial* spatial);
-    void UpdateAnimationObj(uint64_t key, SkinnedMesh* skinnedMesh, AnimationComponent* anim, Spatial* spatial);
+    void UpdateAnimationObj(ManagedAnimation* managedAnim, AnimationComponent* anim, Spatial* spatial);
+    void RetireRenderObj(ManagedAnimation* managedAnim);
     void DoUpdate(float ms);
-
-    glm::vec3 CalcInterpolatedScaling(float animTime, const AnimationData::AnimationNode& animNode);
-    glm::quat CalcInterpolatedRotation(float animTime, const AnimationData::AnimationNode& animNode);
-    glm::vec3 CalcInterpolatedTrans(float animTime, const AnimationData::AnimationNode& animNode);
-
-    template<typename T>
-    size_t GetAnimKeyframeItemIdx(const std::vector<T>& items, float time) {
-        for (size_t i = 0; i < items.size() - 1; ++i) {
-            if (time < items[i + 1].time)
-                return i;
-        }
-        return 0;
-    }
+    void EvaluatePose(ManagedAnimation* managedAnim, glm::mat4* finalBoneOffsets);
+    const Skeleton* GetSkeleton(const MeshPtr& mesh);
+    const SkeletonClipSet* GetClipSet(const MeshPtr& mesh, const AnimationPtr& animation);
 };
\ No newline at end of file
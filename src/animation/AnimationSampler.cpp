@@ -0,0 +1,370 @@
+#include "AnimationSampler.h"
+#include "DGAssert.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANIM_SAMPLER_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ANIM_SAMPLER_X86 1
+#include <immintrin.h>
+#include "CpuId.h"
+#endif
+
+#if defined(ANIM_SAMPLER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ANIM_SAMPLER_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ANIM_SAMPLER_TARGET(isa)
+#endif
+
+namespace {
+inline float KeyFactor(const float* times, uint32_t key0, uint32_t key1, float time) {
+    float dt = times[key1] - times[key0];
+    return dt > 0.f ? std::min(1.f, std::max(0.f, (time - times[key0]) / dt)) : 0.f;
+}
+
+// abramowitz & stegun 4.4.46, acos(x) = sqrt(1 - x) * p(x) on [0, 1] to 2e-8
+constexpr float kAcos[] = {1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f, 0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f};
+// taylor through x^11, under 1e-7 off on the [0, pi/2] slerp needs
+constexpr float kSin[] = {1.f, -1.f / 6.f, 1.f / 120.f, -1.f / 5040.f, 1.f / 362880.f, -1.f / 39916800.f};
+
+// glm::slerp lerps keys closer together than this instead
+constexpr float kSlerpMaxCos = 1.f - FLT_EPSILON;
+
+void SampleVec3Scalar(const KeyTrackSet& tracks, const uint32_t* key0, const uint32_t* key1, float time, float* outX, float* outY, float* outZ,
+                      uint32_t channel, uint32_t channelCount) {
+    for (; channel < channelCount; ++channel) {
+        uint32_t k0 = key0[channel];
+        uint32_t k1 = key1[channel];
+        float    f  = KeyFactor(tracks.times.data(), k0, k1, time);
+        outX[channel] = tracks.x[k0] + (tracks.x[k1] - tracks.x[k0]) * f;
+        outY[channel] = tracks.y[k0] + (tracks.y[k1] - tracks.y[k0]) * f;
+        outZ[channel] = tracks.z[k0] + (tracks.z[k1] - tracks.z[k0]) * f;
+    }
+}
+
+// exactly what AnimationManager did before the keys were repacked
+void SampleQuatScalar(const KeyTrackSet& tracks, const uint32_t* key0, const uint32_t* key1, float time, float* outX, float* outY, float* outZ, float* outW,
+                      uint32_t channel, uint32_t channelCount) {
+    for (; channel < channelCount; ++channel) {
+        uint32_t  k0 = key0[channel];
+        uint32_t  k1 = key1[channel];
+        glm::quat a{tracks.w[k0], tracks.x[k0], tracks.y[k0], tracks.z[k0]};
+        glm::quat b{tracks.w[k1], tracks.x[k1], tracks.y[k1], tracks.z[k1]};
+        glm::quat q = glm::normalize(glm::slerp(a, b, KeyFactor(tracks.times.data(), k0, k1, time)));
+        outX[channel] = q.x;
+        outY[channel] = q.y;
+        outZ[channel] = q.z;
+        outW[channel] = q.w;
+    }
+}
+
+#ifdef ANIM_SAMPLER_SSE
+// sse2 has no gather, these are four scalar loads. the avx2 path uses vgatherdps
+inline __m128 Gather4(const float* values, const uint32_t* keys) {
+    return _mm_setr_ps(values[keys[0]], values[keys[1]], values[keys[2]], values[keys[3]]);
+}
+
+inline __m128 KeyFactor4(const float* times, const uint32_t* key0, const uint32_t* key1, __m128 time) {
+    __m128 t0 = Gather4(times, key0);
+    __m128 dt = _mm_sub_ps(Gather4(times, key1), t0);
+    // single key tracks have dt == 0, the mask throws away the inf/nan from dividing by it
+    __m128 f  = _mm_and_ps(_mm_cmpgt_ps(dt, _mm_setzero_ps()), _mm_div_ps(_mm_sub_ps(time, t0), dt));
+    return _mm_min_ps(_mm_set1_ps(1.f), _mm_max_ps(_mm_setzero_ps(), f));
+}
+
+inline __m128 Lerp4(const float* values, const uint32_t* key0, const uint32_t* key1, __m128 f) {
+    __m128 a = Gather4(values, key0);
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(Gather4(values, key1), a), f));
+}
+
+inline __m128 Sin4(__m128 x) {
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 p  = _mm_set1_ps(kSin[5]);
+    for (int idx = 4; idx >= 0; --idx) {
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(kSin[idx]));
+    }
+    return _mm_mul_ps(p, x);
+}
+
+inline __m128 Acos4(__m128 x) {
+    __m128 p = _mm_set1_ps(kAcos[7]);
+    for (int idx = 6; idx >= 0; --idx) {
+        p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(kAcos[idx]));
+    }
+    return _mm_mul_ps(p, _mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.f), x)));
+}
+
+uint32_t SampleVec3SSE2(const KeyTrackSet& tracks, const uint32_t* key0, const uint32_t* key1, float time, float* outX, float* outY, float* outZ,
+                        uint32_t channel, uint32_t channelCount) {
+    __m128 time4 = _mm_set1_ps(time);
+    for (; channel + 4 <= channelCount; channel += 4) {
+        __m128 f = KeyFactor4(tracks.times.data(), key0 + channel, key1 + channel, time4);
+        _mm_storeu_ps(outX + channel, Lerp4(tracks.x.data(), key0 + channel, key1 + channel, f));
+        _mm_storeu_ps(outY + channel, Lerp4(tracks.y.data(), key0 + channel, key1 + channel, f));
+        _mm_storeu_ps(outZ + channel, Lerp4(tracks.z.data(), key0 + channel, key1 + channel, f));
+    }
+    return channel;
+}
+
+uint32_t SampleQuatSSE2(const KeyTrackSet& tracks, const uint32_t* key0, const uint32_t* key1, float time, float* outX, float* outY, float* outZ,
+                        float* outW, uint32_t channel, uint32_t channelCount) {
+    __m128 time4 = _mm_set1_ps(time);
+    __m128 one   = _mm_set1_ps(1.f);
+    for (; channel + 4 <= channelCount; channel += 4) {
+        const uint32_t* k0 = key0 + channel;
+        const uint32_t* k1 = key1 + channel;
+        __m128 f = KeyFactor4(tracks.times.data(), k0, k1, time4);
+
+        __m128 ax = Gather4(tracks.x.data(), k0), ay = Gather4(tracks.y.data(), k0);
+        __m128 az = Gather4(tracks.z.data(), k0), aw = Gather4(tracks.w.data(), k0);
+        __m128 bx = Gather4(tracks.x.data(), k1), by = Gather4(tracks.y.data(), k1);
+        __m128 bz = Gather4(tracks.z.data(), k1), bw = Gather4(tracks.w.data(), k1);
+
+        // flip b onto a's hemisphere by xoring in the sign of the dot product
+        __m128 dot  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bw), _mm_mul_ps(ax, bx)), _mm_add_ps(_mm_mul_ps(ay, by), _mm_mul_ps(az, bz)));
+        __m128 sign = _mm_and_ps(dot, _mm_set1_ps(-0.f));
+        bx = _mm_xor_ps(bx, sign);
+        by = _mm_xor_ps(by, sign);
+        bz = _mm_xor_ps(bz, sign);
+        bw = _mm_xor_ps(bw, sign);
+        __m128 cosTheta = _mm_min_ps(one, _mm_xor_ps(dot, sign));
+
+        // sin((1 - f) theta) / sin(theta) and sin(f theta) / sin(theta). the lerp lanes' 0/0 gets masked off
+        __m128 theta  = Acos4(cosTheta);
+        __m128 invSin = _mm_div_ps(one, Sin4(theta));
+        __m128 lerp   = _mm_cmpgt_ps(cosTheta, _mm_set1_ps(kSlerpMaxCos));
+        __m128 w0     = _mm_or_ps(_mm_and_ps(lerp, _mm_sub_ps(one, f)), _mm_andnot_ps(lerp, _mm_mul_ps(Sin4(_mm_mul_ps(_mm_sub_ps(one, f), theta)), invSin)));
+        __m128 w1     = _mm_or_ps(_mm_and_ps(lerp, f), _mm_andnot_ps(lerp, _mm_mul_ps(Sin4(_mm_mul_ps(f, theta)), invSin)));
+
+        __m128 x = _mm_add_ps(_mm_mul_ps(ax, w0), _mm_mul_ps(bx, w1));
+        __m128 y = _mm_add_ps(_mm_mul_ps(ay, w0), _mm_mul_ps(by, w1));
+        __m128 z = _mm_add_ps(_mm_mul_ps(az, w0), _mm_mul_ps(bz, w1));
+        __m128 w = _mm_add_ps(_mm_mul_ps(aw, w0), _mm_mul_ps(bw, w1));
+
+        __m128 lengthSq  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+        __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+        _mm_storeu_ps(outX + channel, _mm_mul_ps(x, invLength));
+        _mm_storeu_ps(outY + channel, _mm_mul_ps(y, invLength));
+        _mm_storeu_ps(outZ + channel, _mm_mul_ps(z, invLength));
+        _mm_storeu_ps(outW + channel, _mm_mul_ps(w, invLength));
+    }
+    return channel;
+}
+#endif
+
+#ifdef ANIM_SAMPLER_X86
+// same as the sse2 path, 8 channels at a time with real gathers. no fma so it rounds like the sse2 path does
+ANIM_SAMPLER_TARGET("avx2") inline __m256 Gather8(const float* values, const uint32_t* keys) {
+    return _mm256_i32gather_ps(values, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys)), 4);
+}
+
+ANIM_SAMPLER_TARGET("avx2") inline __m256 KeyFactor8(const float* times, const uint32_t* key0, const uint32_t* key1, __m256 time) {
+    __m256 t0 = Gather8(times, key0);
+    __m256 dt = _mm256_sub_ps(Gather8(times, key1), t0);
+    __m256 f  = _mm256_and_ps(_mm256_cmp_ps(dt, _mm256_setzero_ps(), _CMP_GT_OQ), _mm256_div_ps(_mm256_sub_ps(time, t0), dt));
+    return _mm256_min_ps(_mm256_set1_ps(1.f), _mm256_max_ps(_mm256_setzero_ps(), f));
+}
+
+ANIM_SAMPLER_TARGET("avx2") inline __m256 Lerp8(const float* values, const uint32_t* key0, const uint32_t* key1, __m256 f) {
+    __m256 a = Gather8(values, key0);
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(Gather8(values, key1), a), f));
+}
+
+ANIM_SAMPLER_TARGET("avx2") inline __m256 Sin8(__m256 x) {
+    __m256 x2 = _mm256_mul_ps(x, x);
+    __m256 p  = _mm256_set1_ps(kSin[5]);
+    for (int idx = 4; idx >= 0; --idx) {
+        p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(kSin[idx]));
+    }
+    return _mm256_mul_ps(p, x);
+}
+
+ANIM_SAMPLER_TARGET("avx2") inline __m256 Acos8(__m256 x) {
+    __m256 p = _mm256_set1_ps(kAcos[7]);
+    for (int idx = 6; idx >= 0; --idx) {
+        p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(kAcos[idx]));
+    }
+    return _mm256_mul_ps(p, _mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.f), x)));
+}
+
+ANIM_SAMPLER_TARGET("avx2")
+uint32_t SampleVec3AVX2(const KeyTrackSet& tracks, const uint32_t* key0, const uint32_t* key1, float time, float* outX, float* outY, float* outZ,
+                        uint32_t channel, uint32_t channelCount) {
+    __m256 time8 = _mm256_set1_ps(time);
+    for (; channel + 8 <= channelCount; channel += 8) {
+        __m256 f = KeyFactor8(tracks.times.data(), key0 + channel, key1 + channel, time8);
+        _mm256_storeu_ps(outX + channel, Lerp8(tracks.x.data(), key0 + channel, key1 + channel, f));
+        _mm256_storeu_ps(outY + channel, Lerp8(tracks.y.data(), key0 + channel, key1 + channel, f));
+        _mm256_storeu_ps(outZ + channel, Lerp8(tracks.z.data(), key0 + channel, key1 + channel, f));
+    }
+    return channel;
+}
+
+ANIM_SAMPLER_TARGET("avx2")
+uint32_t SampleQuatAVX2(const KeyTrackSet& tracks, const uint32_t* key0, const uint32_t* key1, float time, float* outX, float* outY, float* outZ,
+                        float* outW, uint32_t channel, uint32_t channelCount) {
+    __m256 time8 = _mm256_set1_ps(time);
+    __m256 one   = _mm256_set1_ps(1.f);
+    for (; channel + 8 <= channelCount; channel += 8) {
+        const uint32_t* k0 = key0 + channel;
+        const uint32_t* k1 = key1 + channel;
+        __m256 f = KeyFactor8(tracks.times.data(), k0, k1, time8);
+
+        __m256 ax = Gather8(tracks.x.data(), k0), ay = Gather8(tracks.y.data(), k0);
+        __m256 az = Gather8(tracks.z.data(), k0), aw = Gather8(tracks.w.data(), k0);
+        __m256 bx = Gather8(tracks.x.data(), k1), by = Gather8(tracks.y.data(), k1);
+        __m256 bz = Gather8(tracks.z.data(), k1), bw = Gather8(tracks.w.data(), k1);
+
+        __m256 dot  = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(aw, bw), _mm256_mul_ps(ax, bx)), _mm256_add_ps(_mm256_mul_ps(ay, by), _mm256_mul_ps(az, bz)));
+        __m256 sign = _mm256_and_ps(dot, _mm256_set1_ps(-0.f));
+        bx = _mm256_xor_ps(bx, sign);
+        by = _mm256_xor_ps(by, sign);
+        bz = _mm256_xor_ps(bz, sign);
+        bw = _mm256_xor_ps(bw, sign);
+        __m256 cosTheta = _mm256_min_ps(one, _mm256_xor_ps(dot, sign));
+
+        __m256 theta  = Acos8(cosTheta);
+        __m256 invSin = _mm256_div_ps(one, Sin8(theta));
+        __m256 lerp   = _mm256_cmp_ps(cosTheta, _mm256_set1_ps(kSlerpMaxCos), _CMP_GT_OQ);
+        __m256 w0     = _mm256_blendv_ps(_mm256_mul_ps(Sin8(_mm256_mul_ps(_mm256_sub_ps(one, f), theta)), invSin), _mm256_sub_ps(one, f), lerp);
+        __m256 w1     = _mm256_blendv_ps(_mm256_mul_ps(Sin8(_mm256_mul_ps(f, theta)), invSin), f, lerp);
+
+        __m256 x = _mm256_add_ps(_mm256_mul_ps(ax, w0), _mm256_mul_ps(bx, w1));
+        __m256 y = _mm256_add_ps(_mm256_mul_ps(ay, w0), _mm256_mul_ps(by, w1));
+        __m256 z = _mm256_add_ps(_mm256_mul_ps(az, w0), _mm256_mul_ps(bz, w1));
+        __m256 w = _mm256_add_ps(_mm256_mul_ps(aw, w0), _mm256_mul_ps(bw, w1));
+
+        __m256 lengthSq  = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_add_ps(_mm256_mul_ps(z, z), _mm256_mul_ps(w, w)));
+        __m256 invLength = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSq));
+        _mm256_storeu_ps(outX + channel, _mm256_mul_ps(x, invLength));
+        _mm256_storeu_ps(outY + channel, _mm256_mul_ps(y, invLength));
+        _mm256_storeu_ps(outZ + channel, _mm256_mul_ps(z, invLength));
+        _mm256_storeu_ps(outW + channel, _mm256_mul_ps(w, invLength));
+    }
+    return channel;
+}
+#endif
+}
+
+void ClipPose::Sample(const KeyTrackSet& scales, const KeyTrackSet& rotations, const KeyTrackSet& translations, float time, uint32_t* cursors) {
+    Sample(BestPath(), scales, rotations, translations, time, cursors);
+}
+
+void ClipPose::Sample(Path path, const KeyTrackSet& scales, const KeyTrackSet& rotations, const KeyTrackSet& translations, float time, uint32_t* cursors) {
+    dg_assert(IsSupported(path), "%s animation sampling isn't supported on this cpu", PathName(path));
+    uint32_t channelCount = scales.ChannelCount();
+    dg_assert_nm(rotations.ChannelCount() == channelCount && translations.ChannelCount() == channelCount);
+
+    if (scaleX.size() < channelCount) {
+        for (std::vector<float>* out : {&scaleX, &scaleY, &scaleZ, &rotX, &rotY, &rotZ, &rotW, &transX, &transY, &transZ}) {
+            out->resize(channelCount);
+        }
+        _key0.resize(channelCount);
+        _key1.resize(channelCount);
+    }
+
+    SampleVec3(path, scales, time, cursors, scaleX.data(), scaleY.data(), scaleZ.data());
+    SampleQuat(path, rotations, time, cursors + channelCount);
+    SampleVec3(path, translations, time, cursors + channelCount * 2, transX.data(), transY.data(), transZ.data());
+}
+
+void ClipPose::FindKeys(const KeyTrackSet& tracks, float time, uint32_t* cursors) {
+    for (uint32_t channel = 0; channel < tracks.ChannelCount(); ++channel) {
+        const float* times    = tracks.times.data() + tracks.offsets[channel];
+        uint32_t     keyCount = tracks.KeyCount(channel);
+        uint32_t     cursor   = cursors[channel];
+
+        if (cursor >= keyCount || time < times[cursor]) {
+            cursor = 0;
+        }
+        while (cursor + 2 < keyCount && time >= times[cursor + 1]) {
+            ++cursor;
+        }
+
+        cursors[channel] = cursor;
+        _key0[channel]   = tracks.offsets[channel] + cursor;
+        _key1[channel]   = _key0[channel] + (cursor + 1 < keyCount ? 1 : 0);
+    }
+}
+
+void ClipPose::SampleVec3(Path path, const KeyTrackSet& tracks, float time, uint32_t* cursors, float* outX, float* outY, float* outZ) {
+    FindKeys(tracks, time, cursors);
+
+    uint32_t channelCount = tracks.ChannelCount();
+    uint32_t channel      = 0;
+    // each path leaves its tail to the narrower ones
+    switch (path) {
+#ifdef ANIM_SAMPLER_X86
+        case Path::AVX2: channel = SampleVec3AVX2(tracks, _key0.data(), _key1.data(), time, outX, outY, outZ, channel, channelCount); [[fallthrough]];
+#endif
+#ifdef ANIM_SAMPLER_SSE
+        case Path::SSE2: channel = SampleVec3SSE2(tracks, _key0.data(), _key1.data(), time, outX, outY, outZ, channel, channelCount); break;
+#endif
+        default: break;
+    }
+    SampleVec3Scalar(tracks, _key0.data(), _key1.data(), time, outX, outY, outZ, channel, channelCount);
+}
+
+void ClipPose::SampleQuat(Path path, const KeyTrackSet& tracks, float time, uint32_t* cursors) {
+    FindKeys(tracks, time, cursors);
+
+    uint32_t channelCount = tracks.ChannelCount();
+    uint32_t channel      = 0;
+    switch (path) {
+#ifdef ANIM_SAMPLER_X86
+        case Path::AVX2:
+            channel = SampleQuatAVX2(tracks, _key0.data(), _key1.data(), time, rotX.data(), rotY.data(), rotZ.data(), rotW.data(), channel, channelCount);
+            [[fallthrough]];
+#endif
+#ifdef ANIM_SAMPLER_SSE
+        case Path::SSE2:
+            channel = SampleQuatSSE2(tracks, _key0.data(), _key1.data(), time, rotX.data(), rotY.data(), rotZ.data(), rotW.data(), channel, channelCount);
+            break;
+#endif
+        default: break;
+    }
+    SampleQuatScalar(tracks, _key0.data(), _key1.data(), time, rotX.data(), rotY.data(), rotZ.data(), rotW.data(), channel, channelCount);
+}
+
+bool ClipPose::IsSupported(Path path) {
+    switch (path) {
+        case Path::Scalar: return true;
+#ifdef ANIM_SAMPLER_SSE
+        case Path::SSE2: return true;
+#ifdef ANIM_SAMPLER_X86
+        case Path::AVX2: {
+            static const bool hasAVX2 = CpuHasAVX2();
+            return hasAVX2;
+        }
+#endif
+#endif
+        default: return false;
+    }
+}
+
+ClipPose::Path ClipPose::BestPath() {
+    static const Path best = [] {
+        Path path = IsSupported(Path::AVX2) ? Path::AVX2 : IsSupported(Path::SSE2) ? Path::SSE2 : Path::Scalar;
+        LOG_D("ClipPose: using the %s path", PathName(path));
+        return path;
+    }();
+    return best;
+}
+
+const char* ClipPose::PathName(Path path) {
+    switch (path) {
+        case Path::Scalar: return "scalar";
+        case Path::SSE2: return "sse2";
+        case Path::AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
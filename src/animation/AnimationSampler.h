@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Keys of one kind (scale, rotation or translation) for every channel of a clip, packed SoA with float times so the
+// sampler can pull several channels' keys into one SSE register
+struct KeyTrackSet {
+    std::vector<uint32_t> offsets{0}; // channel c owns keys [offsets[c], offsets[c + 1])
+    std::vector<float>    times;
+    std::vector<float>    x, y, z, w; // w only holds data for rotations
+
+    uint32_t ChannelCount() const { return static_cast<uint32_t>(offsets.size() - 1); }
+    uint32_t KeyCount(uint32_t channel) const { return offsets[channel + 1] - offsets[channel]; }
+
+    void AddKey(float time, float kx, float ky, float kz, float kw = 0.f) {
+        times.push_back(time);
+        x.push_back(kx);
+        y.push_back(ky);
+        z.push_back(kz);
+        w.push_back(kw);
+    }
+    // closes the channel whose keys were just added
+    void EndChannel() { offsets.push_back(static_cast<uint32_t>(times.size())); }
+};
+
+// Local scale/rotation/translation of every channel at one point in a clip, SoA. Reused between instances and frames,
+// only grows when a clip with more channels than before comes through.
+// The scalar path is the old per channel glm::slerp. The SSE2 (4 channels) and AVX2 (8 channels) paths slerp with
+// polynomial acos/sin, within a few ulps of it rather than bit for bit; '/bench animation' reports how far off.
+class ClipPose {
+public:
+    enum class Path : uint8_t {
+        Scalar = 0,
+        SSE2,
+        AVX2,
+        Count,
+    };
+
+    std::vector<float> scaleX, scaleY, scaleZ;
+    std::vector<float> rotX, rotY, rotZ, rotW;
+    std::vector<float> transX, transY, transZ;
+
+private:
+    std::vector<uint32_t> _key0;
+    std::vector<uint32_t> _key1;
+
+public:
+    // cursors holds 3 key indices per channel, all the scale ones first then rotation then translation. They're last
+    // call's keys and get advanced in place, so a track usually moves zero or one key instead of being searched from the
+    // start. Time going backwards (clip looped) restarts the search.
+    void Sample(const KeyTrackSet& scales, const KeyTrackSet& rotations, const KeyTrackSet& translations, float time, uint32_t* cursors);
+    // on a given path, for the benchmark. the path has to be supported
+    void Sample(Path path, const KeyTrackSet& scales, const KeyTrackSet& rotations, const KeyTrackSet& translations, float time, uint32_t* cursors);
+
+    static bool        IsSupported(Path path);
+    static Path        BestPath();
+    static const char* PathName(Path path);
+
+private:
+    void FindKeys(const KeyTrackSet& tracks, float time, uint32_t* cursors);
+    void SampleVec3(Path path, const KeyTrackSet& tracks, float time, uint32_t* cursors, float* outX, float* outY, float* outZ);
+    void SampleQuat(Path path, const KeyTrackSet& tracks, float time, uint32_t* cursors);
+};
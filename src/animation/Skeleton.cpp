@@ -0,0 +1,110 @@
+#include "Skeleton.h"
+#include "DGAssert.h"
+#include "Log.h"
+
+#include <queue>
+#include <unordered_map>
+
+std::unique_ptr<Skeleton> Skeleton::Build(const Mesh& mesh) {
+    const std::vector<MeshNode>& meshNodes = mesh.GetNodes();
+    const MeshTreeData&          tree      = mesh.GetTree();
+    const BoneOffsetData&        bones     = mesh.GetBones();
+    dg_assert(!meshNodes.empty(), "mesh has no nodes");
+
+    std::unordered_map<std::string, uint32_t> boneSlotByName;
+    for (uint32_t slot = 0; slot < bones.size(); ++slot) {
+        boneSlotByName[bones[slot].first] = slot;
+    }
+
+    std::unique_ptr<Skeleton> skeleton(new Skeleton());
+    skeleton->gimt = mesh.GetGimt();
+    skeleton->boneOffsets.reserve(bones.size());
+    for (const auto& bone : bones) {
+        skeleton->boneOffsets.push_back(bone.second);
+    }
+
+    // breadth first from the root, same order the per frame walk used to visit them in
+    std::queue<std::pair<uint32_t, uint32_t>> nodeQueue; // mesh node, parent skeleton node
+    nodeQueue.push({0, kNoParent});
+    while (!nodeQueue.empty()) {
+        uint32_t meshNodeIdx = nodeQueue.front().first;
+        uint32_t parent      = nodeQueue.front().second;
+        nodeQueue.pop();
+
+        const MeshNode& meshNode = meshNodes[meshNodeIdx];
+        uint32_t        idx      = skeleton->NodeCount();
+
+        auto boneCheck = boneSlotByName.find(meshNode.name);
+        skeleton->parents.push_back(parent);
+        skeleton->localTransforms.push_back(meshNode.localTransform);
+        skeleton->boneSlots.push_back(boneCheck != boneSlotByName.end() ? boneCheck->second : kNoBone);
+        skeleton->names.push_back(meshNode.name);
+
+        auto it = tree.find(meshNodeIdx);
+        if (it == tree.end()) {
+            LOG_E("Skeleton::Build. tree doesnt contain node %u as parent, its probly screwed up.", meshNodeIdx);
+            continue;
+        }
+        for (uint32_t child : it->second) {
+            nodeQueue.push({child, idx});
+        }
+    }
+
+    return skeleton;
+}
+
+namespace {
+// the sampler assumes every track has a key, an empty one gets the identity
+void AddChannelKeys(const AnimationData::AnimationNode& animNode, SkeletonClip* clip) {
+    for (const auto& key : animNode.scales) {
+        clip->scales.AddKey(static_cast<float>(key.time), key.scale.x, key.scale.y, key.scale.z);
+    }
+    if (animNode.scales.empty()) {
+        clip->scales.AddKey(0.f, 1.f, 1.f, 1.f);
+    }
+    clip->scales.EndChannel();
+
+    for (const auto& key : animNode.rotations) {
+        clip->rotations.AddKey(static_cast<float>(key.time), key.rot.x, key.rot.y, key.rot.z, key.rot.w);
+    }
+    if (animNode.rotations.empty()) {
+        clip->rotations.AddKey(0.f, 0.f, 0.f, 0.f, 1.f);
+    }
+    clip->rotations.EndChannel();
+
+    for (const auto& key : animNode.translations) {
+        clip->translations.AddKey(static_cast<float>(key.time), key.scale.x, key.scale.y, key.scale.z);
+    }
+    if (animNode.translations.empty()) {
+        clip->translations.AddKey(0.f, 0.f, 0.f, 0.f);
+    }
+    clip->translations.EndChannel();
+}
+}
+
+std::unique_ptr<SkeletonClipSet> SkeletonClipSet::Bind(const Skeleton& skeleton, const std::unordered_map<std::string, AnimationData>& animData) {
+    dg_assert(!animData.empty(), "animation has no clips");
+
+    static const std::array<const char*, static_cast<size_t>(AnimationType::COUNT)> kClipNames = {{"IDLE", "ATTACK", "ATTACK_IDLE", "WALKING"}};
+
+    std::unique_ptr<SkeletonClipSet> clipSet(new SkeletonClipSet());
+    for (size_t type = 0; type < kClipNames.size(); ++type) {
+        // todo: actually use type...somehow. falls back to whatever clip comes first, like before
+        auto it = animData.find(kClipNames[type]);
+        const AnimationData& data = it != animData.end() ? it->second : animData.begin()->second;
+
+        SkeletonClip& clip  = clipSet->clips[type];
+        clip.data           = &data;
+        clip.ticksPerSecond = data.ticksPerSecond == 0.0 ? 25.f : static_cast<float>(data.ticksPerSecond);
+        clip.duration       = static_cast<float>(data.duration);
+        clip.nodeChannels.resize(skeleton.NodeCount(), SkeletonClip::kNoChannel);
+        for (uint32_t node = 0; node < skeleton.NodeCount(); ++node) {
+            auto channel = data.animationNodes.find(skeleton.names[node]);
+            if (channel != data.animationNodes.end()) {
+                clip.nodeChannels[node] = clip.ChannelCount();
+                AddChannelKeys(channel->second, &clip);
+            }
+        }
+    }
+    return clipSet;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "AnimationComponent.h"
+#include "AnimationData.h"
+#include "AnimationSampler.h"
+#include "Mesh.h"
+
+// Mesh node tree flattened once per mesh. Nodes are stored parents first, so evaluating a pose is one forward loop
+// over these arrays instead of a BFS through the tree map.
+struct Skeleton {
+    static constexpr uint32_t kNoParent = 0xffffffff;
+    static constexpr uint32_t kNoBone   = 0xffffffff;
+
+    std::vector<uint32_t>    parents;         // skeleton node index, kNoParent for the root
+    std::vector<glm::mat4>   localTransforms; // bind pose
+    std::vector<uint32_t>    boneSlots;       // palette slot per node, kNoBone if the node doesn't drive a bone
+    std::vector<std::string> names;           // only used to bind clips
+    std::vector<glm::mat4>   boneOffsets;     // per palette slot
+    glm::mat4                gimt;
+
+    uint32_t NodeCount() const { return static_cast<uint32_t>(parents.size()); }
+    uint32_t BoneCount() const { return static_cast<uint32_t>(boneOffsets.size()); }
+
+    static std::unique_ptr<Skeleton> Build(const Mesh& mesh);
+};
+
+// An AnimationData clip with its channels resolved to skeleton node indices and its keys repacked for ClipPose
+struct SkeletonClip {
+    static constexpr uint32_t kNoChannel = 0xffffffff;
+
+    const AnimationData*  data{nullptr};
+    float                 ticksPerSecond{25.f};
+    float                 duration{0.f};
+    std::vector<uint32_t> nodeChannels; // per skeleton node, kNoChannel keeps the bind pose
+    KeyTrackSet           scales;
+    KeyTrackSet           rotations;
+    KeyTrackSet           translations;
+
+    uint32_t ChannelCount() const { return scales.ChannelCount(); }
+};
+
+// Every AnimationType of an animation resolved against one skeleton, built when an instance is added
+struct SkeletonClipSet {
+    std::array<SkeletonClip, static_cast<size_t>(AnimationType::COUNT)> clips;
+
+    const SkeletonClip& Clip(AnimationType type) const { return clips[static_cast<size_t>(type)]; }
+
+    static std::unique_ptr<SkeletonClipSet> Bind(const Skeleton& skeleton, const std::unordered_map<std::string, AnimationData>& animData);
+};
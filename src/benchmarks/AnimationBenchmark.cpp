@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/compatibility.hpp>
+#include "AnimationData.h"
+#include "AnimationSampler.h"
+#include "Benchmarks.h"
+
+namespace {
+// what AnimationManager used to do per channel per frame: search from key 0, sample straight off the AoS keys
+template <typename T>
+size_t LinearKeyIdx(const std::vector<T>& items, float time) {
+    for (size_t i = 0; i < items.size() - 1; ++i) {
+        if (time < items[i + 1].time)
+            return i;
+    }
+    return 0;
+}
+
+glm::vec3 SampleVec3(const std::vector<AnimationData::AnimationNode::Vec3Time>& keys, float time) {
+    size_t idx = LinearKeyIdx(keys, time);
+    float  dt  = (float)keys[idx + 1].time - (float)keys[idx].time;
+    return glm::lerp(keys[idx].scale, keys[idx + 1].scale, (float)((time - keys[idx].time) / dt));
+}
+
+glm::quat SampleQuat(const std::vector<AnimationData::AnimationNode::QuatTime>& keys, float time) {
+    size_t idx = LinearKeyIdx(keys, time);
+    float  dt  = (float)keys[idx + 1].time - (float)keys[idx].time;
+    return glm::normalize(glm::slerp(keys[idx].rot, keys[idx + 1].rot, (float)((time - keys[idx].time) / dt)));
+}
+}
+
+// '/bench animation [channels] [keysPerChannel] [frames]'
+// Per channel linear key search over AoS double-time keys vs cursors + SoA float tracks through ClipPose on every path
+// this cpu has. Error is the largest rotation difference from the scalar path, which slerps like the linear search does
+std::string bench::RunAnimationBenchmark(const BenchmarkArgs& args) {
+    uint32_t channelCount = 0;
+    uint32_t keyCount     = 0;
+    uint32_t frames       = 0;
+    if (!ParseCountArg(args, 0, 64, 1, &channelCount) || !ParseCountArg(args, 1, 120, 2, &keyCount) || !ParseCountArg(args, 2, 2000, 1, &frames)) {
+        return "usage: /bench animation [channels > 0] [keysPerChannel >= 2] [frames > 0]";
+    }
+    float    duration     = static_cast<float>(keyCount - 1);
+    float    frameStep    = duration / 240.f; // ~2 frames per key, like a 30 tick clip played at 60fps
+
+    std::mt19937                          rng(1234);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+    std::vector<AnimationData::AnimationNode> nodes(channelCount);
+    KeyTrackSet                               scales, rotations, translations;
+    for (AnimationData::AnimationNode& node : nodes) {
+        for (uint32_t key = 0; key < keyCount; ++key) {
+            glm::vec3 scale(dist(rng), dist(rng), dist(rng));
+            glm::vec3 trans(dist(rng), dist(rng), dist(rng));
+            glm::quat rot = glm::normalize(glm::quat(dist(rng), dist(rng), dist(rng), dist(rng)));
+            node.scales.emplace_back(key, scale);
+            node.rotations.emplace_back(key, rot);
+            node.translations.emplace_back(key, trans);
+            scales.AddKey(static_cast<float>(key), scale.x, scale.y, scale.z);
+            rotations.AddKey(static_cast<float>(key), rot.x, rot.y, rot.z, rot.w);
+            translations.AddKey(static_cast<float>(key), trans.x, trans.y, trans.z);
+        }
+        scales.EndChannel();
+        rotations.EndChannel();
+        translations.EndChannel();
+    }
+
+    float            linearChecksum = 0.f;
+    bench::Stopwatch stopwatch;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        float time = fmod(frame * frameStep, duration);
+        for (const AnimationData::AnimationNode& node : nodes) {
+            linearChecksum += SampleVec3(node.scales, time).x + SampleQuat(node.rotations, time).w + SampleVec3(node.translations, time).z;
+        }
+    }
+    double linearMs = stopwatch.elapsedMs() / frames;
+
+    // scalar first, it's the old slerp and what the other paths are compared against
+    ClipPose              reference;
+    std::vector<uint32_t> referenceCursors(channelCount * 3, 0);
+
+    std::stringstream ss;
+    ss << "channels:" << channelCount << " keys:" << keyCount << " frames:" << frames << "\n";
+    ss << "linear search, AoS " << linearMs * 1000 << "us/frame (" << (linearMs * 1e6 / channelCount) << "ns/channel)\n";
+    for (uint32_t pathIdx = 0; pathIdx < static_cast<uint32_t>(ClipPose::Path::Count); ++pathIdx) {
+        ClipPose::Path path = static_cast<ClipPose::Path>(pathIdx);
+        if (!ClipPose::IsSupported(path)) {
+            continue;
+        }
+
+        ClipPose              pose;
+        std::vector<uint32_t> cursors(channelCount * 3, 0);
+        float                 cursorChecksum = 0.f;
+        stopwatch.restart();
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            float time = fmod(frame * frameStep, duration);
+            pose.Sample(path, scales, rotations, translations, time, cursors.data());
+            for (uint32_t channel = 0; channel < channelCount; ++channel) {
+                cursorChecksum += pose.scaleX[channel] + pose.rotW[channel] + pose.transZ[channel];
+            }
+        }
+        double cursorMs = stopwatch.elapsedMs() / frames;
+
+        // largest difference from the scalar path's rotations over a slice of the clip
+        float maxError = 0.f;
+        std::fill(cursors.begin(), cursors.end(), 0);
+        std::fill(referenceCursors.begin(), referenceCursors.end(), 0);
+        for (uint32_t frame = 0; frame < std::min(frames, 240u); ++frame) {
+            float time = fmod(frame * frameStep, duration);
+            pose.Sample(path, scales, rotations, translations, time, cursors.data());
+            reference.Sample(ClipPose::Path::Scalar, scales, rotations, translations, time, referenceCursors.data());
+            for (uint32_t channel = 0; channel < channelCount; ++channel) {
+                maxError = std::max({maxError, std::abs(pose.rotX[channel] - reference.rotX[channel]), std::abs(pose.rotY[channel] - reference.rotY[channel]),
+                                     std::abs(pose.rotZ[channel] - reference.rotZ[channel]), std::abs(pose.rotW[channel] - reference.rotW[channel])});
+            }
+        }
+
+        ss << "cursors, SoA " << ClipPose::PathName(path) << " " << cursorMs * 1000 << "us/frame (" << (cursorMs * 1e6 / channelCount)
+           << "ns/channel) checksum " << linearChecksum << "/" << cursorChecksum << " max error " << maxError << "\n";
+    }
+    return ss.str();
+}
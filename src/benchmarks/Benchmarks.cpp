@@ -0,0 +1,45 @@
+#include "Benchmarks.h"
+#include <functional>
+#include <map>
+#include "ConsoleCommands.h"
+#include "Log.h"
+
+static const std::string kBenchChannel = "bench";
+
+namespace bench {
+using BenchmarkFunc = std::function<std::string(const BenchmarkArgs&)>;
+
+static const std::map<std::string, BenchmarkFunc>& benchmarks() {
+    static const std::map<std::string, BenchmarkFunc> benchmarks = {
+        {"queues", RunQueueBenchmark},
+        {"components", RunComponentBenchmark},
+        {"animation", RunAnimationBenchmark},
+        {"drawitems", RunDrawItemBenchmark},
+        {"noise", RunNoiseBenchmark},
+    };
+    return benchmarks;
+}
+
+void RegisterConsoleCommand() {
+    config::ConsoleCommands::getInstance().RegisterCommand("bench", [](const std::vector<std::string>& params) -> std::string {
+        // params[0] is the command itself
+        if (params.size() < 2) {
+            std::string names;
+            for (const auto& p : benchmarks()) {
+                names += p.first + " ";
+            }
+            return "usage: /bench <name> [args]. available: " + names;
+        }
+
+        auto it = benchmarks().find(params[1]);
+        if (it == benchmarks().end()) {
+            return "Unknown benchmark '" + params[1] + "'";
+        }
+
+        BenchmarkArgs args(begin(params) + 2, end(params));
+        std::string   results = it->second(args);
+        LOG(Log::Level::Debug, kBenchChannel, "%s:\n%s", params[1].c_str(), results.c_str());
+        return results;
+    });
+}
+}
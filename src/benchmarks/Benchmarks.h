@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+// CPU microbenchmarks, run from the console with '/bench <name> [args]'. '/bench' alone lists them.
+namespace bench {
+using BenchmarkArgs = std::vector<std::string>;
+
+void RegisterConsoleCommand();
+
+std::string RunQueueBenchmark(const BenchmarkArgs& args);
+std::string RunComponentBenchmark(const BenchmarkArgs& args);
+std::string RunAnimationBenchmark(const BenchmarkArgs& args);
+std::string RunDrawItemBenchmark(const BenchmarkArgs& args);
+std::string RunNoiseBenchmark(const BenchmarkArgs& args);
+
+// args[idx] as a whole number >= minValue, defaultValue when it's not there. false for anything else (not a number,
+// negative, too small or too big), the console doesn't catch exceptions so nothing here may throw
+inline bool ParseCountArg(const BenchmarkArgs& args, size_t idx, uint32_t defaultValue, uint32_t minValue, uint32_t* value) {
+    if (idx >= args.size()) {
+        *value = defaultValue;
+        return true;
+    }
+    const std::string& arg = args[idx];
+    if (arg.empty() || arg[0] < '0' || arg[0] > '9') {
+        return false;
+    }
+    char*         end    = nullptr;
+    unsigned long parsed = std::strtoul(arg.c_str(), &end, 10);
+    if (*end != '\0' || parsed < minValue || parsed > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    *value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+class Stopwatch {
+private:
+    using Clock = std::chrono::high_resolution_clock;
+    Clock::time_point _start{Clock::now()};
+
+public:
+    void   restart() { _start = Clock::now(); }
+    double elapsedMs() const { return std::chrono::duration<double, std::milli>(Clock::now() - _start).count(); }
+};
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include "AnimationComponent.h"
+#include "Benchmarks.h"
+#include "ComponentStore.h"
+#include "Spatial.h"
+
+namespace {
+// stand in for a manager's per entity work
+inline void Integrate(Spatial& spatial, const AnimationComponent& anim, double dt, uint64_t* walking) {
+    spatial.pos += spatial.velocity * dt;
+    *walking += anim.animationType == AnimationType::WALKING ? 1 : 0;
+}
+}
+
+// '/bench components [entityCount] [passes]'
+// Old per slot unique_ptr arrays scanned end to end vs the packed pools walked through view<Spatial, AnimationComponent>
+std::string bench::RunComponentBenchmark(const BenchmarkArgs& args) {
+    uint32_t entityCount = 0;
+    uint32_t passes      = 0;
+    if (!ParseCountArg(args, 0, 100000, 1, &entityCount) || !ParseCountArg(args, 1, 20, 1, &passes)) {
+        return "usage: /bench components [entityCount > 0] [passes > 0]";
+    }
+    double   dt = 1.0 / 60.0;
+
+    // every entity moves, every other one animates
+    std::vector<std::unique_ptr<Spatial>>            spatialSlots(entityCount);
+    std::vector<std::unique_ptr<AnimationComponent>> animationSlots(entityCount);
+
+    ComponentStore store;
+    store.RegisterPool<Spatial>();
+    store.RegisterPool<AnimationComponent>();
+
+    // components get added over the life of a scene, not in entity order, so the old heap allocations end up scattered
+    std::vector<uint32_t> creationOrder(entityCount);
+    std::iota(begin(creationOrder), end(creationOrder), 0);
+    std::shuffle(begin(creationOrder), end(creationOrder), std::mt19937(1234));
+
+    for (uint32_t entity : creationOrder) {
+        spatialSlots[entity].reset(new Spatial());
+        store.Pool<Spatial>()->Add(entity);
+        if (entity % 2 == 0) {
+            animationSlots[entity].reset(new AnimationComponent());
+            store.Pool<AnimationComponent>()->Add(entity);
+        }
+    }
+
+    uint64_t         scanWalking = 0;
+    bench::Stopwatch stopwatch;
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (uint32_t entity = 0; entity < entityCount; ++entity) {
+            Spatial*            spatial = spatialSlots[entity].get();
+            AnimationComponent* anim    = animationSlots[entity].get();
+            if (spatial != nullptr && anim != nullptr) {
+                Integrate(*spatial, *anim, dt, &scanWalking);
+            }
+        }
+    }
+    double scanMs = stopwatch.elapsedMs() / passes;
+
+    // SimulationManager does this at the start of every update
+    store.SortPools();
+
+    uint64_t viewWalking = 0;
+    stopwatch.restart();
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        store.view<Spatial, AnimationComponent>().each(
+            [&](EntityId entity, Spatial& spatial, AnimationComponent& anim) { Integrate(spatial, anim, dt, &viewWalking); });
+    }
+    double viewMs = stopwatch.elapsedMs() / passes;
+
+    std::stringstream ss;
+    ss << "entities:" << entityCount << " passes:" << passes << "\n";
+    ss << "unique_ptr slots " << scanMs << "ms/pass (" << (scanMs * 1e6 / entityCount) << "ns/entity)\n";
+    ss << "view<Spatial, AnimationComponent> " << viewMs << "ms/pass (" << (viewMs * 1e6 / entityCount) << "ns/entity)\n";
+    ss << "checksum " << scanWalking << "/" << viewWalking << "\n";
+    return ss.str();
+}
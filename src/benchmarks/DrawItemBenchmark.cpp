@@ -0,0 +1,188 @@
+#include <cstring>
+#include <sstream>
+#include "Benchmarks.h"
+#include "CommandBuffer.h"
+#include "DrawItemEncoder.h"
+#include "NullBackend.h"
+#include "RenderPassCommandBuffer.h"
+#include "StateGroupEncoder.h"
+
+using namespace gfx;
+
+namespace {
+// the byte vector layout DrawItem used to have, with the decoder that went with it: every field found by walking the
+// offsets of the ones before it and memcpy'd out, streams and bindings copied into fresh vectors per draw
+struct LegacyDrawItem : public std::vector<uint8_t> {};
+
+enum class LegacyField : uint8_t { StreamCount = 0, BindingCount, DrawCall, IndexBuffer, PipelineState, VertexStreams, Bindings };
+
+class LegacyDecoder {
+private:
+    const LegacyDrawItem* _drawItem{nullptr};
+    uint8_t               _streamCount{0};
+    uint8_t               _bindingCount{0};
+
+public:
+    LegacyDecoder(const LegacyDrawItem* item) : _drawItem(item) {
+        ReadState(LegacyField::StreamCount, &_streamCount);
+        ReadState(LegacyField::BindingCount, &_bindingCount);
+    }
+
+    size_t GetStreamCount() { return _streamCount; }
+    size_t GetBindingCount() { return _bindingCount; }
+    bool   ReadDrawCall(DrawCall* drawCall) { return ReadState(LegacyField::DrawCall, drawCall); }
+    bool   ReadPipelineState(PipelineStateId* pipelineState) { return ReadState(LegacyField::PipelineState, pipelineState); }
+    bool   ReadIndexBuffer(BufferId* indexBuffer) { return ReadState(LegacyField::IndexBuffer, indexBuffer); }
+    bool   ReadVertexStreams(VertexStream** streams) { return ReadState(LegacyField::VertexStreams, *streams, _streamCount); }
+    bool   ReadBindings(Binding** bindings) { return ReadState(LegacyField::Bindings, *bindings, _bindingCount); }
+
+private:
+    template <class T>
+    bool ReadState(LegacyField field, T* stateOut, uint32_t count = 1) {
+        memcpy(stateOut, _drawItem->data() + GetOffset(field), sizeof(T) * count);
+        return true;
+    }
+
+    size_t GetOffset(LegacyField field) {
+        switch (field) {
+            case LegacyField::StreamCount: return 0;
+            case LegacyField::BindingCount: return sizeof(uint8_t);
+            case LegacyField::DrawCall: return GetOffset(LegacyField::BindingCount) + sizeof(uint8_t);
+            case LegacyField::IndexBuffer: return GetOffset(LegacyField::DrawCall) + sizeof(DrawCall);
+            case LegacyField::PipelineState: return GetOffset(LegacyField::IndexBuffer) + sizeof(BufferId);
+            case LegacyField::VertexStreams: return GetOffset(LegacyField::PipelineState) + sizeof(PipelineStateId);
+            case LegacyField::Bindings: return GetOffset(LegacyField::VertexStreams) + sizeof(VertexStream) * _streamCount;
+        }
+        return 0;
+    }
+};
+
+LegacyDrawItem ToLegacy(const DrawItem* item) {
+    LegacyDrawItem legacy;
+    legacy.resize(sizeof(uint8_t) * 2 + sizeof(DrawCall) + sizeof(BufferId) + sizeof(PipelineStateId) + sizeof(VertexStream) * item->streamCount +
+                  sizeof(Binding) * item->bindingCount);
+    uint8_t* out = legacy.data();
+    auto     put = [&out](const void* src, size_t size) {
+        memcpy(out, src, size);
+        out += size;
+    };
+    put(&item->streamCount, sizeof(uint8_t));
+    put(&item->bindingCount, sizeof(uint8_t));
+    put(&item->drawCall, sizeof(DrawCall));
+    put(&item->indexBuffer, sizeof(BufferId));
+    put(&item->pipelineState, sizeof(PipelineStateId));
+    put(item->streams(), sizeof(VertexStream) * item->streamCount);
+    put(item->bindings(), sizeof(Binding) * item->bindingCount);
+    return legacy;
+}
+
+void Issue(RenderPassCommandBuffer* pass, PipelineStateId pipelineState, BufferId vertexBuffer, const Binding* bindings, size_t bindingCount,
+           const DrawCall& drawCall, BufferId indexBuffer) {
+    pass->setPipelineState(pipelineState);
+    pass->setVertexBuffer(vertexBuffer);
+    for (size_t idx = 0; idx < bindingCount; ++idx) {
+        const Binding& binding = bindings[idx];
+        if (binding.type == Binding::Type::Texture) {
+            pass->setShaderTexture(binding.resource, binding.slot, binding.stageFlags);
+        } else {
+            pass->setShaderBuffer(binding.resource, binding.slot, binding.stageFlags, binding.offset);
+        }
+    }
+    pass->drawIndexed(indexBuffer, drawCall.primitiveCount, drawCall.startOffset, drawCall.baseVertexOffset);
+}
+}
+
+// '/bench drawitems [draws] [frames]'
+// Decoding and issuing every draw against the null device, old vector layout + decoder vs reading DrawItem in place.
+// Both issue the same calls with no filtering, so the difference is decode cost only
+std::string bench::RunDrawItemBenchmark(const BenchmarkArgs& args) {
+    uint32_t drawCount = 0;
+    uint32_t frames    = 0;
+    if (!ParseCountArg(args, 0, 50000, 1, &drawCount) || !ParseCountArg(args, 1, 20, 1, &frames)) {
+        return "usage: /bench drawitems [draws > 0] [frames > 0]";
+    }
+
+    NullBackend backend;
+    NullDevice* device = static_cast<NullDevice*>(backend.getRenderDevice());
+    device->SetRecording(false);
+
+    RenderPassId renderPass = device->CreateRenderPass(RenderPassInfo());
+    BufferId     vertices   = device->AllocateBuffer(BufferDesc::vbPersistent(1024), nullptr);
+    BufferId     indices    = device->AllocateBuffer(BufferDesc::ibPersistent(1024), nullptr);
+    BufferId     constants  = device->AllocateBuffer(BufferDesc::defaultPersistent(BufferUsageFlags::ConstantBufferBit, 256), nullptr);
+    TextureId    texture    = device->CreateTexture2D(PixelFormat::RGBA8Unorm, TextureUsageFlags::ShaderRead, 4, 4, nullptr, "DrawItemBench");
+
+    // a mesh draw's worth of state: the pipeline, one vertex stream, a couple of constant buffers and a texture
+    StateGroupEncoder encoder;
+    encoder.Begin();
+    encoder.SetRenderPass(renderPass);
+    encoder.SetVertexShader(device->GetShader(ShaderType::VertexShader, "mesh"));
+    encoder.SetPixelShader(device->GetShader(ShaderType::PixelShader, "mesh"));
+    encoder.SetVertexLayout(1);
+    encoder.SetVertexBuffer(vertices);
+    encoder.SetIndexBuffer(indices);
+    encoder.BindConstantBuffer(0, constants);
+    encoder.BindConstantBuffer(1, constants);
+    encoder.BindTexture(0, texture);
+    std::unique_ptr<const StateGroup> stateGroup(encoder.End());
+
+    DrawCall drawCall;
+    drawCall.type           = DrawCall::Type::Indexed;
+    drawCall.primitiveCount = 36;
+
+    PipelineStateCache                           pipelineStates(device);
+    std::vector<std::unique_ptr<const DrawItem>> items;
+    std::vector<LegacyDrawItem>                  legacyItems;
+    for (uint32_t idx = 0; idx < drawCount; ++idx) {
+        const StateGroup* groups[] = {stateGroup.get()};
+        items.emplace_back(DrawItemEncoder::Encode(&pipelineStates, drawCall, groups, 1));
+        legacyItems.push_back(ToLegacy(items.back().get()));
+    }
+
+    auto runFrames = [&](auto&& issueAll) {
+        bench::Stopwatch stopwatch;
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            CommandBuffer*           commandBuffer = device->CreateCommandBuffer();
+            RenderPassCommandBuffer* pass          = commandBuffer->beginRenderPass(renderPass, FrameBuffer(), "DrawItemBench");
+            issueAll(pass);
+            commandBuffer->endRenderPass(pass);
+            device->Submit({commandBuffer});
+        }
+        return stopwatch.elapsedMs() / frames;
+    };
+
+    double legacyMs = runFrames([&](RenderPassCommandBuffer* pass) {
+        for (const LegacyDrawItem& item : legacyItems) {
+            PipelineStateId pipelineState;
+            DrawCall        call;
+            BufferId        indexBuffer;
+            LegacyDecoder   decoder(&item);
+
+            std::vector<VertexStream> streams(decoder.GetStreamCount());
+            std::vector<Binding>      bindings(decoder.GetBindingCount());
+            VertexStream*             streamPtr  = streams.data();
+            Binding*                  bindingPtr = bindings.data();
+            decoder.ReadDrawCall(&call);
+            decoder.ReadPipelineState(&pipelineState);
+            decoder.ReadIndexBuffer(&indexBuffer);
+            decoder.ReadVertexStreams(&streamPtr);
+            if (bindings.size() > 0) {
+                decoder.ReadBindings(&bindingPtr);
+            }
+            Issue(pass, pipelineState, streams[0].vertexBuffer, bindings.data(), bindings.size(), call, indexBuffer);
+        }
+    });
+
+    double inPlaceMs = runFrames([&](RenderPassCommandBuffer* pass) {
+        for (const std::unique_ptr<const DrawItem>& item : items) {
+            Issue(pass, item->pipelineState, item->streams()[0].vertexBuffer, item->bindings(), item->bindingCount, item->drawCall, item->indexBuffer);
+        }
+    });
+
+    std::stringstream ss;
+    ss << "draws:" << drawCount << " frames:" << frames << " bindings/draw:" << static_cast<uint32_t>(items[0]->bindingCount) << "\n";
+    ss << "legacy decode " << legacyMs << "ms/frame (" << (legacyMs * 1e6 / drawCount) << "ns/draw)\n";
+    ss << "in place      " << inPlaceMs << "ms/frame (" << (inPlaceMs * 1e6 / drawCount) << "ns/draw)\n";
+    ss << "device draws " << device->Stats().drawCalls << "\n";
+    return ss.str();
+}
@@ -0,0 +1,77 @@
+#include <noise/noise.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include "Benchmarks.h"
+#include "RidgedNoise.h"
+
+// '/bench noise [tiles] [resolution]'
+// Heightmap tiles through libnoise's RidgedMulti one sample at a time vs RidgedNoise a row at a time on every path
+// this cpu has, set up the way GenerateHeightmapTask does it. Error is the largest difference from libnoise
+std::string bench::RunNoiseBenchmark(const BenchmarkArgs& args) {
+    // the kernels step by 1 / (resolution - 1)
+    uint32_t tiles      = 0;
+    uint32_t resolution = 0;
+    if (!ParseCountArg(args, 0, 16, 1, &tiles) || !ParseCountArg(args, 1, 128, 2, &resolution)) {
+        return "usage: /bench noise [tiles > 0] [resolution >= 2]";
+    }
+    size_t   tileSize   = static_cast<size_t>(resolution) * resolution;
+
+    noise::module::RidgedMulti module;
+    module.SetSeed(32);
+    module.SetFrequency(0.05);
+    module.SetOctaveCount(8);
+
+    RidgedNoise ridged;
+    ridged.SetSeed(32);
+    ridged.SetFrequency(0.05);
+    ridged.SetOctaveCount(8);
+
+    // tile corners somewhere on a planet sized cube, already scaled like the task's samples
+    std::mt19937                           rng(11);
+    std::uniform_real_distribution<double> corner(-5000.0, 5000.0);
+    std::vector<double>                    xs(tiles * tileSize), ys(tiles * tileSize), zs(tiles * tileSize);
+    for (uint32_t tile = 0; tile < tiles; ++tile) {
+        double x = corner(rng), y = corner(rng), z = corner(rng), size = 50.0;
+        for (size_t idx = 0; idx < tileSize; ++idx) {
+            size_t at = tile * tileSize + idx;
+            xs[at]    = x + size * (idx % resolution) / (resolution - 1);
+            ys[at]    = y + size * (idx / resolution) / (resolution - 1);
+            zs[at]    = z;
+        }
+    }
+
+    std::vector<double> expected(xs.size());
+    bench::Stopwatch    stopwatch;
+    for (size_t idx = 0; idx < xs.size(); ++idx) {
+        expected[idx] = module.GetValue(xs[idx], ys[idx], zs[idx]);
+    }
+    double libnoiseMs = stopwatch.elapsedMs();
+
+    std::stringstream ss;
+    ss << "tiles:" << tiles << " resolution:" << resolution << "x" << resolution << " best path:" << RidgedNoise::PathName(RidgedNoise::BestPath()) << "\n";
+    ss << "libnoise " << (tiles * 1000.0 / libnoiseMs) << " tiles/s\n";
+
+    std::vector<double> values(xs.size());
+    for (uint32_t p = 0; p < static_cast<uint32_t>(RidgedNoise::Path::Count); ++p) {
+        RidgedNoise::Path path = static_cast<RidgedNoise::Path>(p);
+        if (!RidgedNoise::IsSupported(path)) {
+            ss << RidgedNoise::PathName(path) << " not supported\n";
+            continue;
+        }
+
+        stopwatch.restart();
+        for (size_t row = 0; row < xs.size(); row += resolution) {
+            ridged.GetValues(path, &xs[row], &ys[row], &zs[row], &values[row], resolution);
+        }
+        double ms = stopwatch.elapsedMs();
+
+        double maxError = 0.0;
+        for (size_t idx = 0; idx < values.size(); ++idx) {
+            maxError = std::max(maxError, std::abs(values[idx] - expected[idx]));
+        }
+        ss << RidgedNoise::PathName(path) << " " << (tiles * 1000.0 / ms) << " tiles/s (" << (libnoiseMs / ms) << "x) max error " << maxError << "\n";
+    }
+    return ss.str();
+}
@@ -0,0 +1,102 @@
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include "Benchmarks.h"
+#include "BlockingQueue.h"
+#include "MPSCQueue.h"
+#include "SPSCQueue.h"
+
+namespace {
+// roughly what a tile result looks like: a key and a heap allocated payload
+struct QueueBenchPayload {
+    uint64_t           key{0};
+    std::vector<float> data;
+};
+
+template <typename EnqueueFunc, typename DrainFunc>
+double RunProducersConsumer(uint32_t producerCount, uint32_t itemsPerProducer, uint32_t payloadFloats, EnqueueFunc enqueue, DrainFunc drain) {
+    std::atomic<bool>        go{false};
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < producerCount; ++p) {
+        producers.emplace_back([&, p]() {
+            while (!go) {
+                std::this_thread::yield();
+            }
+            for (uint32_t idx = 0; idx < itemsPerProducer; ++idx) {
+                QueueBenchPayload payload;
+                payload.key = (static_cast<uint64_t>(p) << 32) | idx;
+                payload.data.resize(payloadFloats);
+                enqueue(std::move(payload));
+            }
+        });
+    }
+
+    // calling thread plays the frame thread
+    const size_t                   expected = static_cast<size_t>(producerCount) * itemsPerProducer;
+    std::vector<QueueBenchPayload> received;
+    received.reserve(expected);
+
+    bench::Stopwatch stopwatch;
+    go = true;
+    while (received.size() < expected) {
+        drain(&received);
+    }
+    double elapsed = stopwatch.elapsedMs();
+
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    return elapsed;
+}
+}
+
+// '/bench queues [itemsPerProducer] [payloadFloats]'
+// Compares the old mutex BlockingQueue against MPSCQueue on the worker -> frame thread result path, and SPSCQueue
+// with a single producer. Producers here are plain threads that can spin on a full ring, tasks can't
+std::string bench::RunQueueBenchmark(const BenchmarkArgs& args) {
+    uint32_t itemsPerProducer = 0;
+    uint32_t payloadFloats    = 0;
+    if (!ParseCountArg(args, 0, 20000, 1, &itemsPerProducer) || !ParseCountArg(args, 1, 32 * 32, 0, &payloadFloats)) {
+        return "usage: /bench queues [itemsPerProducer > 0] [payloadFloats]";
+    }
+
+    std::stringstream ss;
+    ss << "items/producer:" << itemsPerProducer << " payload floats:" << payloadFloats << "\n";
+
+    for (uint32_t producerCount : {1u, 4u, 16u}) {
+        double items = static_cast<double>(producerCount) * itemsPerProducer;
+
+        BlockingQueue<QueueBenchPayload> blockingQueue;
+        double                           blockingMs = RunProducersConsumer(
+            producerCount, itemsPerProducer, payloadFloats, [&](QueueBenchPayload&& payload) { blockingQueue.enqueue(std::move(payload)); },
+            [&](std::vector<QueueBenchPayload>* dst) { blockingQueue.flush(dst); });
+
+        MPSCQueue<QueueBenchPayload> mpscQueue(1024);
+        double                       mpscMs = RunProducersConsumer(
+            producerCount, itemsPerProducer, payloadFloats,
+            [&](QueueBenchPayload&& payload) {
+                while (!mpscQueue.tryEnqueue(std::move(payload))) {
+                    std::this_thread::yield();
+                }
+            },
+            [&](std::vector<QueueBenchPayload>* dst) { mpscQueue.drain(dst); });
+
+        ss << "producers:" << producerCount << " | BlockingQueue " << blockingMs << "ms (" << (blockingMs * 1e6 / items) << "ns/item)"
+           << " | MPSCQueue " << mpscMs << "ms (" << (mpscMs * 1e6 / items) << "ns/item)";
+
+        if (producerCount == 1) {
+            SPSCQueue<QueueBenchPayload> spscQueue(1024);
+            double                       spscMs = RunProducersConsumer(
+                producerCount, itemsPerProducer, payloadFloats,
+                [&](QueueBenchPayload&& payload) {
+                    while (!spscQueue.tryEnqueue(std::move(payload))) {
+                        std::this_thread::yield();
+                    }
+                },
+                [&](std::vector<QueueBenchPayload>* dst) { spscQueue.drain(dst); });
+            ss << " | SPSCQueue " << spscMs << "ms (" << (spscMs * 1e6 / items) << "ns/item)";
+        }
+        ss << "\n";
+    }
+    return ss.str();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <bitset>
+#include <initializer_list>
+#include "ComponentType.h"
+
+// Which component types a manager reads and which it writes. Two managers can run at the same time unless one writes
+// something the other touches.
+struct ComponentAccess {
+    using TypeSet = std::bitset<static_cast<size_t>(ComponentType::COUNT)>;
+
+    TypeSet reads;
+    TypeSet writes;
+
+    ComponentAccess(std::initializer_list<ComponentType> readTypes, std::initializer_list<ComponentType> writeTypes) {
+        for (ComponentType type : readTypes) {
+            reads.set(static_cast<size_t>(type));
+        }
+        for (ComponentType type : writeTypes) {
+            writes.set(static_cast<size_t>(type));
+        }
+    }
+
+    bool ConflictsWith(const ComponentAccess& other) const {
+        return (writes & (other.reads | other.writes)).any() || (other.writes & reads).any();
+    }
+};
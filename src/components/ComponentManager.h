@@ -1,14 +1,15 @@
 #pragma once
-#include "Component.h"
-#include "ComponentType.h"
+#include "ComponentStore.h"
 #include "Viewport.h"
 
-#include <array>
-#include <map>
-#include <memory>
-
 class ComponentManager {
 public:
+    virtual ~ComponentManager() {}
+
     virtual void UpdateViewport(const Viewport& vp) = 0;
-    virtual void DoUpdate(std::map<ComponentType, const std::array<std::unique_ptr<Component>, 1024u>*>& components, float ms) = 0;
+    virtual void DoUpdate(ComponentStore& components, float ms) = 0;
+
+    // managers that poke render objects directly (ex. ui) can't overlap render submission, so in pipelined frame mode
+    // they run on the frame thread ahead of the rest of the simulation
+    virtual bool RunsOnFrameThread() const { return false; }
 };
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "Component.h"
+#include "DGAssert.h"
+
+// index into the component pools. SimObj ids are handles: index in the low 32 bits, generation in the high 32 bits so a
+// recycled index doesn't alias a destroyed object
+using EntityId = uint32_t;
+
+inline uint64_t MakeEntityHandle(EntityId index, uint32_t generation) { return (static_cast<uint64_t>(generation) << 32) | index; }
+inline EntityId EntityIndex(uint64_t handle) { return static_cast<EntityId>(handle & 0xffffffff); }
+inline uint32_t EntityGeneration(uint64_t handle) { return static_cast<uint32_t>(handle >> 32); }
+
+// Type erased side of a pool so SimulationManager/SimObj can add and remove by ComponentType
+class ComponentPoolBase {
+protected:
+    static constexpr uint32_t kInvalidIdx = 0xffffffff;
+
+    std::vector<uint32_t> _sparse;   // entity -> dense index
+    std::vector<EntityId> _entities; // dense index -> entity
+    bool                  _sorted{true};
+
+public:
+    virtual ~ComponentPoolBase() {}
+
+    bool Has(EntityId entity) const { return entity < _sparse.size() && _sparse[entity] != kInvalidIdx; }
+
+    // live components only, in storage order
+    const std::vector<EntityId>& Entities() const { return _entities; }
+    size_t                       Size() const { return _entities.size(); }
+
+    virtual Component* AddDefault(EntityId entity) = 0;
+    virtual Component* GetComponent(EntityId entity) = 0;
+    virtual void       Remove(EntityId entity) = 0;
+
+    // Puts the dense arrays back in entity order. Views look their secondary pools up by entity, so when every pool is
+    // sorted those lookups walk memory forwards instead of jumping around. Moves components, so pointers are invalidated
+    virtual void SortByEntity() = 0;
+};
+
+// Sparse set: components are packed densely so iterating only touches live ones. Storage is paged so growing never moves
+// existing components. Removing swaps the last component into the hole, so pointers into a pool stay valid until a
+// component of that type is removed or the pool gets re-sorted.
+template <class T>
+class ComponentPool : public ComponentPoolBase {
+public:
+    static constexpr uint32_t kPageShift = 10;
+    static constexpr uint32_t kPageSize  = 1u << kPageShift;
+    static constexpr uint32_t kPageMask  = kPageSize - 1;
+
+private:
+    struct Page {
+        alignas(T) unsigned char storage[sizeof(T) * kPageSize];
+    };
+
+    std::vector<std::unique_ptr<Page>> _pages;
+
+public:
+    ComponentPool() {}
+    ~ComponentPool() {
+        for (uint32_t idx = 0; idx < _entities.size(); ++idx) {
+            At(idx)->~T();
+        }
+    }
+
+    ComponentPool(const ComponentPool&) = delete;
+    ComponentPool& operator=(const ComponentPool&) = delete;
+
+    template <class... Args>
+    T* Add(EntityId entity, Args&&... args) {
+        dg_assert(!Has(entity), "entity already has this component");
+
+        if (entity >= _sparse.size()) {
+            _sparse.resize(entity + 1, kInvalidIdx);
+        }
+
+        uint32_t denseIdx = static_cast<uint32_t>(_entities.size());
+        if ((denseIdx >> kPageShift) >= _pages.size()) {
+            _pages.emplace_back(new Page());
+        }
+
+        T* component = new (_pages[denseIdx >> kPageShift]->storage + sizeof(T) * (denseIdx & kPageMask)) T(std::forward<Args>(args)...);
+        _sorted      = _sorted && (_entities.empty() || _entities.back() < entity);
+        _entities.push_back(entity);
+        _sparse[entity] = denseIdx;
+        return component;
+    }
+
+    T* Get(EntityId entity) { return Has(entity) ? At(_sparse[entity]) : nullptr; }
+
+    // no bounds/presence check, for views that already know the entity has one
+    T& GetUnchecked(EntityId entity) { return *At(_sparse[entity]); }
+
+    // dense index, ex. for iterating a range of the pool
+    T&       AtIndex(uint32_t denseIdx) { return *At(denseIdx); }
+    EntityId EntityAtIndex(uint32_t denseIdx) const { return _entities[denseIdx]; }
+
+    Component* AddDefault(EntityId entity) final { return Add(entity); }
+    Component* GetComponent(EntityId entity) final { return Get(entity); }
+
+    void Remove(EntityId entity) final {
+        if (!Has(entity)) {
+            return;
+        }
+
+        uint32_t denseIdx = _sparse[entity];
+        uint32_t lastIdx  = static_cast<uint32_t>(_entities.size() - 1);
+        if (denseIdx != lastIdx) {
+            *At(denseIdx)                = std::move(*At(lastIdx));
+            _entities[denseIdx]          = _entities[lastIdx];
+            _sparse[_entities[denseIdx]] = denseIdx;
+            _sorted                      = false;
+        }
+        At(lastIdx)->~T();
+        _entities.pop_back();
+        _sparse[entity] = kInvalidIdx;
+    }
+
+    void SortByEntity() final {
+        if (_sorted) {
+            return;
+        }
+
+        std::vector<uint32_t> order(_entities.size());
+        std::iota(begin(order), end(order), 0);
+        std::sort(begin(order), end(order), [&](uint32_t a, uint32_t b) { return _entities[a] < _entities[b]; });
+
+        std::vector<std::unique_ptr<Page>> sortedPages(_pages.size());
+        for (std::unique_ptr<Page>& page : sortedPages) {
+            page.reset(new Page());
+        }
+
+        std::vector<EntityId> sortedEntities(_entities.size());
+        for (uint32_t denseIdx = 0; denseIdx < order.size(); ++denseIdx) {
+            T* src = At(order[denseIdx]);
+            new (sortedPages[denseIdx >> kPageShift]->storage + sizeof(T) * (denseIdx & kPageMask)) T(std::move(*src));
+            src->~T();
+
+            sortedEntities[denseIdx]          = _entities[order[denseIdx]];
+            _sparse[sortedEntities[denseIdx]] = denseIdx;
+        }
+
+        _pages.swap(sortedPages);
+        _entities.swap(sortedEntities);
+        _sorted = true;
+    }
+
+private:
+    T* At(uint32_t denseIdx) { return std::launder(reinterpret_cast<T*>(_pages[denseIdx >> kPageShift]->storage) + (denseIdx & kPageMask)); }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <initializer_list>
+#include <memory>
+#include <tuple>
+#include "ComponentPool.h"
+#include "ComponentType.h"
+#include "TaskScheduler.h"
+
+class ComponentStore;
+
+// Entities that have every one of Ts. Walks the smallest pool and looks the rest up through their sparse arrays, so the
+// cost scales with the rarest component instead of the entity count.
+template <class... Ts>
+class ComponentView {
+private:
+    std::tuple<ComponentPool<Ts>*...> _pools;
+    const ComponentPoolBase*          _driver{nullptr};
+
+public:
+    ComponentView(ComponentPool<Ts>*... pools) : _pools(pools...) {
+        for (const ComponentPoolBase* pool : {static_cast<const ComponentPoolBase*>(pools)...}) {
+            if (_driver == nullptr || pool->Size() < _driver->Size()) {
+                _driver = pool;
+            }
+        }
+    }
+
+    // upper bound on how many entities each() visits
+    size_t sizeHint() const { return _driver->Size(); }
+
+    // func(EntityId, Ts&...)
+    template <class Func>
+    void each(Func&& func) {
+        eachInRange(0, sizeHint(), func);
+    }
+
+    // only visits driver entries [begin, end), so disjoint ranges can be handed to different threads
+    template <class Func>
+    void eachInRange(size_t begin, size_t end, Func&& func) {
+        const std::vector<EntityId>& entities = _driver->Entities();
+        for (size_t idx = begin; idx < end; ++idx) {
+            EntityId               entity = entities[idx];
+            std::tuple<Ts*...> components(Fetch(std::get<ComponentPool<Ts>*>(_pools), entity, static_cast<uint32_t>(idx))...);
+            if (((std::get<Ts*>(components) != nullptr) && ...)) {
+                func(entity, *std::get<Ts*>(components)...);
+            }
+        }
+    }
+
+    // each() split over the scheduler in chunks of driver entries, returns when all are done. func must be safe to run
+    // concurrently for different entities
+    template <class Func>
+    void parallelEach(Func&& func, size_t minChunkSize = 64) {
+        scheduler()->parallelFor(sizeHint(), minChunkSize, [this, &func](size_t begin, size_t end) { eachInRange(begin, end, func); });
+    }
+
+private:
+    // the driving pool is walked in order, no need to go through its sparse array
+    template <class T>
+    T* Fetch(ComponentPool<T>* pool, EntityId entity, uint32_t denseIdx) {
+        return pool == _driver ? &pool->AtIndex(denseIdx) : pool->Get(entity);
+    }
+};
+
+// Owns one pool per component type. Pools are registered up front so lookups never allocate and concurrent readers never
+// race on pool creation.
+class ComponentStore {
+private:
+    std::array<std::unique_ptr<ComponentPoolBase>, static_cast<size_t>(ComponentType::COUNT)> _pools;
+
+public:
+    template <class T>
+    void RegisterPool() {
+        std::unique_ptr<ComponentPoolBase>& pool = _pools[static_cast<size_t>(T::type())];
+        dg_assert(pool == nullptr, "pool already registered");
+        pool.reset(new ComponentPool<T>());
+    }
+
+    template <class T>
+    ComponentPool<T>* Pool() {
+        return static_cast<ComponentPool<T>*>(Pool(T::type()));
+    }
+
+    ComponentPoolBase* Pool(ComponentType type) {
+        ComponentPoolBase* pool = _pools[static_cast<size_t>(type)].get();
+        dg_assert(pool != nullptr, "component type has no pool");
+        return pool;
+    }
+
+    template <class... Ts>
+    ComponentView<Ts...> view() {
+        return ComponentView<Ts...>(Pool<Ts>()...);
+    }
+
+    template <class... Ts>
+    bool Has(EntityId entity) {
+        return (Pool<Ts>()->Has(entity) && ...);
+    }
+
+    template <class T>
+    T* TryGet(EntityId entity) {
+        return Pool<T>()->Get(entity);
+    }
+
+    // see ComponentPoolBase::SortByEntity. only call while nothing is iterating
+    void SortPools() {
+        for (std::unique_ptr<ComponentPoolBase>& pool : _pools) {
+            if (pool) {
+                pool->SortByEntity();
+            }
+        }
+    }
+
+    void RemoveAll(EntityId entity) {
+        for (std::unique_ptr<ComponentPoolBase>& pool : _pools) {
+            if (pool) {
+                pool->Remove(entity);
+            }
+        }
+    }
+};
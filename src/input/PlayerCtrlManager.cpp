@@ -159,31 +159,17 @@ bool PlayerCtrlManager::PlyrCntrlRight(const input::InputContextCallbackArgs& ar
     return true;
 }
 
-void PlayerCtrlManager::DoUpdate(std::map<ComponentType, const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>& components, float ms) {
-
-    assert(components[ComponentType::PlayerControlled] != nullptr);
-    assert(components[ComponentType::Spatial] != nullptr);
-    assert(components[ComponentType::Animation] != nullptr);
-
-    auto& pcs = *reinterpret_cast<const std::array<std::unique_ptr<PlayerControlled>, MAX_SIM_OBJECTS>*>(components[ComponentType::PlayerControlled]);
-    auto& spatials = *reinterpret_cast<const std::array<std::unique_ptr<Spatial>, MAX_SIM_OBJECTS>*>(components[ComponentType::Spatial]);
-    auto& anims = *reinterpret_cast<const std::array<std::unique_ptr<AnimationComponent>, MAX_SIM_OBJECTS>*>(components[ComponentType::Animation]);
-
+void PlayerCtrlManager::DoUpdate(ComponentStore& components, float ms) {
     HandleCameraMovement(ms);
 
-    for (size_t i = 0; i < MAX_SIM_OBJECTS; ++i) {
-        PlayerControlled* pc = pcs[i].get();
-        Spatial* spatial = spatials[i].get();
-        AnimationComponent* anim = anims[i].get();
+    components.view<PlayerControlled, Spatial>().each([&](EntityId entity, PlayerControlled& pc, Spatial& spatial) {
+        spatial.direction = glm::dvec3(cntrldInput.x * -1.0, 0.0, cntrldInput.y);
 
-        if (pc != nullptr && spatial != nullptr) {
-            spatial->direction = glm::dvec3(cntrldInput.x * -1.0, 0.0, cntrldInput.y);
-
-            if (anim != nullptr) {
-                anim->animationType = glm::length(cntrldInput) > 0.1 ? AnimationType::WALKING : AnimationType::IDLE;
-            }
+        AnimationComponent* anim = components.TryGet<AnimationComponent>(entity);
+        if (anim != nullptr) {
+            anim->animationType = glm::length(cntrldInput) > 0.1 ? AnimationType::WALKING : AnimationType::IDLE;
         }
-    }
+    });
 
     cntrldInput = { 0.f, 0.f };
 }
\ No newline at end of file
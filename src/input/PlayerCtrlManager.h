@@ -27,7 +27,7 @@ public:
 
     void UpdateViewport(const Viewport& vp) override {}
 
-    void DoUpdate(std::map<ComponentType, const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>& components, float ms) override;
+    void DoUpdate(ComponentStore& components, float ms) override;
 
     bool LookMode(const input::InputContextCallbackArgs& args);
 
@@ -9,6 +9,8 @@
 #endif
 
 #include "GLDevice.h"
+#include "NullBackend.h"
+#include "CaptureDevice.h"
 #ifndef _WIN32
 #include "MetalBackend.h"
 #endif
@@ -154,7 +156,10 @@ int sys::Run(app::Application* app) {
     
     std::unique_ptr<gfx::RenderBackend> backend;
     void* windowHandle = nullptr;
-    if (SDL_GetWindowWMInfo(_window, &info)) {
+    if (deviceApi == gfx::RenderDeviceApi::Null) {
+        // headless, doesn't care which window system it's on
+        backend.reset(new gfx::NullBackend());
+    } else if (SDL_GetWindowWMInfo(_window, &info)) {
         switch (info.subsystem) {
             case SDL_SYSWM_UNKNOWN:
                 break;
@@ -203,7 +208,7 @@ int sys::Run(app::Application* app) {
         LOG_E("Couldn't get window information: %s\n", SDL_GetError());
     }
 
-    dg_assert_nm(windowHandle);
+    dg_assert_nm(windowHandle || deviceApi == gfx::RenderDeviceApi::Null);
     
     gfx::SwapchainDesc desc;
     desc.format = gfx::PixelFormat::BGRA8Unorm;
@@ -212,8 +217,19 @@ int sys::Run(app::Application* app) {
 
     backend->printDeviceInfo();
     _app->renderDevice = backend->getRenderDevice();
+    if (_app->renderDevice == nullptr) {
+        LOG_E("%s", "RenderDevice creation failed.");
+        return -1;
+    }
     _app->swapchain = backend->createSwapchainForWindow(desc, _app->renderDevice, windowHandle);
 
+    // wrapped after the swapchain is made, backends want their own device there
+    std::unique_ptr<gfx::CaptureDevice> captureDevice;
+    if (config::Config::getInstance().GetConfigString("RenderDeviceSettings", "Capture") == "y") {
+        captureDevice.reset(new gfx::CaptureDevice(_app->renderDevice));
+        _app->renderDevice = captureDevice.get();
+    }
+
     PopulateKeyMapping();
 
     LOG_D("SDL Initialized. Version: %d.%d.%d on %s", info.version.major, info.version.minor, info.version.patch, subsystem);
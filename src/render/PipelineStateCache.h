@@ -1,20 +1,98 @@
 #pragma once
 
+#include <xxhash.h>
+#include <array>
 #include <cassert>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "RenderDevice.h"
 #include "PipelineStateDesc.h"
 
+// Hash-consed pipeline states: every equal desc maps to one device object that lives as long as the cache. The desc is
+// packed field by field before hashing so struct padding never ends up in the key, and the packed key is compared on a
+// hit so a collision only costs a compare. Locked, draw items get encoded from renderer submits
 class PipelineStateCache {
+public:
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        size_t   pipelineStates{0};
+    };
+
 private:
-    gfx::RenderDevice* _device;
+    // the whole desc, one field per slot. the packed key is what gets hashed and compared
+    using Key = std::array<uint64_t, 8>;
+
+    struct Entry {
+        Key                  key;
+        gfx::PipelineStateId id{gfx::NULL_ID};
+    };
+
+    gfx::RenderDevice*                               _device;
+    std::mutex                                       _mutex;
+    std::unordered_map<uint64_t, std::vector<Entry>> _entries;
+    Stats                                            _stats;
 
 public:
     PipelineStateCache(gfx::RenderDevice* device) : _device(device) {}
 
-    gfx::ShaderId Get(const gfx::PipelineStateDesc& psd) {
-        // TODO: actually cache
+    ~PipelineStateCache() {
+        for (const auto& bucket : _entries) {
+            for (const Entry& entry : bucket.second) {
+                _device->DestroyResource(entry.id);
+            }
+        }
+    }
+
+    gfx::PipelineStateId Get(const gfx::PipelineStateDesc& psd) {
+        Key                         key  = MakeKey(psd);
+        uint64_t                    hash = XXH3_64bits(key.data(), sizeof(Key));
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::vector<Entry>& bucket = _entries[hash];
+        for (const Entry& entry : bucket) {
+            if (entry.key == key) {
+                ++_stats.hits;
+                return entry.id;
+            }
+        }
+
         gfx::PipelineStateId psId = _device->CreatePipelineState(psd);
         assert(psId);
+        bucket.push_back({key, psId});
+        ++_stats.misses;
+        ++_stats.pipelineStates;
         return psId;
     }
+
+    Stats GetStats() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+private:
+    static Key MakeKey(const gfx::PipelineStateDesc& psd) {
+        const gfx::BlendState&  bs = psd.blendState;
+        const gfx::RasterState& rs = psd.rasterState;
+        const gfx::DepthState&  ds = psd.depthState;
+        return {
+            psd.renderPass,
+            psd.vertexShader,
+            psd.pixelShader,
+            psd.vertexLayout,
+            static_cast<uint64_t>(psd.topology),
+            Pack(bs.enable, bs.srcRgbFunc, bs.srcAlphaFunc, bs.dstRgbFunc, bs.dstAlphaFunc, bs.rgbMode, bs.alphaMode),
+            Pack(rs.fillMode, rs.cullMode, rs.windingOrder),
+            Pack(ds.enable, ds.depthWriteMask, ds.depthFunc),
+        };
+    }
+
+    // state enums and bools all fit in a byte
+    static uint64_t Pack() { return 0; }
+
+    template <typename T, typename... Rest>
+    static uint64_t Pack(T value, Rest... rest) {
+        return (Pack(rest...) << 8) | (static_cast<uint64_t>(value) & 0xff);
+    }
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <utility>
 #include "RenderDevice.h"
 #include "File.h"
 
@@ -15,8 +16,10 @@ private:
     std::unordered_map<std::string, CacheItem> _cache;
     Policy _policy;
 public:
-    RenderCache(gfx::RenderDevice* device, const std::string& baseDir)
-        : _device(device), _baseDir(baseDir), _policy(device) {
+    // anything past baseDir goes to the policy after the device
+    template <typename... PolicyArgs>
+    RenderCache(gfx::RenderDevice* device, const std::string& baseDir, PolicyArgs&&... policyArgs)
+        : _device(device), _baseDir(baseDir), _policy(device, std::forward<PolicyArgs>(policyArgs)...) {
         if (!fs::IsPathDirectory(baseDir)) {
             LOG_E("%s", "Invalid Directory Path");
             _baseDir = fs::AppendPathProcessDir("/assets");
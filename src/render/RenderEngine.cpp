@@ -1,6 +1,7 @@
 #include "RenderEngine.h"
 #include <cassert>
 #include "Config.h"
+#include "ConsoleCommands.h"
 #include "ConstantBuffer.h"
 #include "ConstantBuffer.h"
 #include "DebugDrawInterface.h"
@@ -15,6 +16,9 @@
 
 using namespace gfx;
 
+// a skinned mesh takes 16k of it
+static constexpr size_t kTransientConstantsFrameSize = 8 * 1024 * 1024;
+
 struct ViewConstants {
     glm::vec3 eye;
     float     padding0;
@@ -53,10 +57,19 @@ RenderEngine::RenderEngine(RenderDevice* device, gfx::Swapchain* swapchain, Rend
     _shaderCache           = new ShaderCache(_device, shaderDirPath);
     _pipelineStateCache    = new PipelineStateCache(_device);
     _vertexLayoutCache     = new VertexLayoutCache(_device);
-    _meshCache             = new MeshCache(_device, assetDirPath);
+    _meshCache             = new MeshCache(_device, assetDirPath, _vertexLayoutCache);
     _constantBufferManager = new ConstantBufferManager(_device);
     _materialCache         = new MaterialCache(_device, assetDirPath);
     _animationCache        = new AnimationCache(_device, assetDirPath);
+    _transientConstants    = new TransientBufferRing(_device, BufferUsageFlags::ConstantBufferBit, kTransientConstantsFrameSize, "TransientConstants");
+
+    config::ConsoleCommands::getInstance().RegisterCommand("rendercaches", [this](const std::vector<std::string>& params) -> std::string {
+        PipelineStateCache::Stats psoStats    = _pipelineStateCache->GetStats();
+        VertexLayoutCache::Stats  layoutStats = _vertexLayoutCache->GetStats();
+        return "pipelinestates:" + std::to_string(psoStats.pipelineStates) + " hits:" + std::to_string(psoStats.hits) + " misses:" + std::to_string(psoStats.misses) +
+               "\nvertexlayouts:" + std::to_string(layoutStats.vertexLayouts) + " hits:" + std::to_string(layoutStats.hits) +
+               " misses:" + std::to_string(layoutStats.misses);
+    });
 
     viewConstantsBuffer = _constantBufferManager->GetConstantBuffer(sizeof(ViewConstants), "ViewConstants");
     
@@ -95,6 +108,8 @@ RenderEngine::RenderEngine(RenderDevice* device, gfx::Swapchain* swapchain, Rend
     encoder.BindResource(viewConstantsBuffer->GetBinding(0));
     encoder.SetRenderPass(_baseRenderPass);
     _stateGroupDefaults = encoder.End();
+
+    _queue.reset(new RenderQueue(_baseRenderPass, _stateGroupDefaults));
 }
 
 void RenderEngine::CreateRenderTargets()
@@ -114,6 +129,10 @@ RenderEngine::~RenderEngine() {
         delete _pipelineStateCache;
         _pipelineStateCache = nullptr;
     }
+    if (_transientConstants) {
+        delete _transientConstants;
+        _transientConstants = nullptr;
+    }
 
     _renderersByType.clear();
 
@@ -122,8 +141,10 @@ RenderEngine::~RenderEngine() {
 }
 
 void RenderEngine::RenderFrame(const RenderScene* scene) {
-    RenderQueue queue(_baseRenderPass, _stateGroupDefaults);
-    queue.defaults = _stateGroupDefaults;    
+    RenderQueue& queue = *_queue;
+    queue.Clear();
+    gfx::StateGroupEncoder::ResetTransient();
+    _transientConstants->BeginFrame();
 
     assert(_view);
     FrameView view = _view->frameView();
@@ -153,6 +174,8 @@ void RenderEngine::RenderFrame(const RenderScene* scene) {
     gfx::RenderPassCommandBuffer* renderPassCommandBuffer = commandBuffer->beginRenderPass(_baseRenderPass, frameBuffer, "MainPass");
     queue.Submit(renderPassCommandBuffer);
     commandBuffer->endRenderPass(renderPassCommandBuffer);
+    _frameStats = queue.Stats();
+    _transientConstants->EndFrame();
     
     _device->Submit({commandBuffer});
     _swapchain->present(backbuffer);
@@ -166,3 +189,4 @@ ConstantBufferManager* RenderEngine::constantBufferManager() { return _constantB
 MaterialCache*         RenderEngine::materialCache() { return _materialCache; }
 DebugDrawInterface*    RenderEngine::debugDraw() { return _renderers.debug.get(); }
 AnimationCache*        RenderEngine::animationCache() { return _animationCache; }
+TransientBufferRing*   RenderEngine::transientConstants() { return _transientConstants; }
@@ -16,6 +16,7 @@
 #include "SimObj.h"
 #include "StateGroup.h"
 #include "TerrainRenderer.h"
+#include "TransientBufferRing.h"
 #include "VertexLayoutCache.h"
 #include "Swapchain.h"
 
@@ -85,11 +86,15 @@ private:
     ConstantBufferManager* _constantBufferManager{nullptr};
     MaterialCache*         _materialCache;
     AnimationCache*        _animationCache;
+    TransientBufferRing*   _transientConstants{nullptr};
 
     Renderers _renderers;
 
     const gfx::StateGroup* _stateGroupDefaults{nullptr};
 
+    std::unique_ptr<RenderQueue> _queue;
+    RenderQueueStats             _frameStats;
+
 public:
     RenderEngine(gfx::RenderDevice* device, gfx::Swapchain* swapchain, RenderView* view);
     ~RenderEngine();
@@ -97,6 +102,10 @@ public:
     Renderers& Renderers() { return _renderers; }
     void       RenderFrame(const RenderScene* scene);
     void       CreateRenderTargets();
+
+    // what the last RenderFrame sent to the device
+    const RenderQueueStats& FrameStats() const { return _frameStats; }
+
     RenderPassId _baseRenderPass { gfx::NULL_ID };
     gfx::TextureId _depthBuffer { gfx::NULL_ID };
     
@@ -108,6 +117,7 @@ public:
     MaterialCache*         materialCache() override;
     DebugDrawInterface*    debugDraw() override;
     AnimationCache*        animationCache() override;
+    TransientBufferRing*   transientConstants() override;
 
 private:
 };
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <algorithm>
 #include <stdint.h>
 #include <vector>
 #include "CommandBuffer.h"
@@ -8,70 +7,136 @@
 #include "DrawItem.h"
 #include "RenderDevice.h"
 #include "StateGroup.h"
-#include "DrawItemDecoder.h"
 #include "VertexStream.h"
+#include "RadixSort.h"
+#include "SortKey.h"
+#include "TaskScheduler.h"
 
 using namespace gfx;
 
+// what Submit actually sent to the command buffer, redundant binds it dropped are counted separately
+struct RenderQueueStats {
+    uint32_t drawCalls{0};
+    uint32_t instances{0}; // what the draws drew, above drawCalls when some were instanced
+    uint32_t pipelineStateChanges{0};
+    uint32_t vertexBufferChanges{0};
+    uint32_t bufferBinds{0};
+    uint32_t textureBinds{0};
+    uint32_t redundantBindsSkipped{0};
+};
+
 class RenderQueue {
 private:
-    typedef std::pair<uint32_t, const gfx::DrawItem*> DrawItemPair;
-    std::vector<DrawItemPair> _items;
+    // bindings past this many slots are always sent
+    static constexpr uint32_t kTrackedSlots = 16;
+
+    struct SortedDrawItem {
+        uint64_t             key;
+        const gfx::DrawItem* item;
+        uint32_t             dynamicOffset;
+        uint32_t             instanceCount;
+    };
+
+    struct BoundResource {
+        ResourceId       resource{NULL_ID};
+        uint32_t         offset{0};
+        ShaderStageFlags stages{ShaderStageFlags::None};
+    };
+
+    // one per thread slot so renderers can add from scheduler workers without locking, padded so neighbouring
+    // segments' sizes don't share a cache line
+    struct alignas(64) Segment {
+        std::vector<SortedDrawItem> items;
+    };
+
+    std::vector<Segment>        _segments;
+    std::vector<SortedDrawItem> _items;
+    std::vector<SortedDrawItem> _sortScratch;
+    RenderQueueStats            _stats;
 
 public:
     // temporary
     const gfx::StateGroup* defaults{nullptr};
     const gfx::RenderPassId renderPass { 0 };
 
-    RenderQueue(gfx::RenderPassId renderPass, const gfx::StateGroup* defaults) : renderPass(renderPass), defaults(defaults) {}
+    RenderQueue(gfx::RenderPassId renderPass, const gfx::StateGroup* defaults)
+        : _segments(scheduler()->workerCount() + 1), renderPass(renderPass), defaults(defaults) {}
 
-    void AddDrawItem(uint32_t key, const gfx::DrawItem* item) { _items.push_back(std::make_pair(key, item)); }
+    // key from SortKey.h. Safe from the thread that owns the queue and from scheduler workers at the same time, each
+    // appends to its own segment. Any other thread shares the owner's segment and must not overlap with it.
+    // dynamicOffset is added to the item's DynamicConstantBuffer binding, usually a TransientBufferRing allocation.
+    // instanceCount above 1 draws the item instanced, indexed items only
+    void AddDrawItem(uint64_t key, const gfx::DrawItem* item, uint32_t dynamicOffset = 0, uint32_t instanceCount = 1) {
+        _segments[scheduler()->threadSlot()].items.push_back({key, item, dynamicOffset, instanceCount});
+    }
 
+    // drops the items but keeps the storage for next frame
+    void Clear() {
+        for (Segment& segment : _segments) {
+            segment.items.clear();
+        }
+        _items.clear();
+        _stats = RenderQueueStats();
+    }
+
+    const RenderQueueStats& Stats() const { return _stats; }
+
+    // everything added has to be in by now, the segments get gathered and sorted once
     void Submit(gfx::RenderPassCommandBuffer* commandBuffer) {
+        Gather();
         Sort();
-        
-        for (const DrawItemPair& p : _items) {
-            const gfx::DrawItem* drawItem = p.second;
-            
-            PipelineStateId pipelineStateId;
-            DrawCall        drawCall;
-            BufferId        indexBufferId;
-            std::vector<VertexStream> streams;
-            std::vector<Binding>      bindings;
-            
-            DrawItemDecoder decoder(drawItem);
-            
-            size_t streamCount = decoder.GetStreamCount();
-            dg_assert(streamCount == 1, "> 1 stream count not supported");
-            size_t bindingCount = decoder.GetBindingCount();
-            
-            streams.clear();
-            bindings.clear();
-            streams.resize(streamCount);
-            bindings.resize(bindingCount);
-            
-            VertexStream* streamPtr  = streams.data();
-            Binding*      bindingPtr = bindings.data();
-            
-            dg_assert_nm(decoder.ReadDrawCall(&drawCall));
-            dg_assert_nm(decoder.ReadPipelineState(&pipelineStateId));
-            dg_assert_nm(decoder.ReadIndexBuffer(&indexBufferId));
-            dg_assert_nm(decoder.ReadVertexStreams(&streamPtr));
-            if (bindingCount > 0) {
-                dg_assert_nm(decoder.ReadBindings(&bindingPtr));
+
+        // a fresh render pass command buffer has nothing bound
+        PipelineStateId boundPipelineState = NULL_ID;
+        BufferId        boundVertexBuffer  = NULL_ID;
+        BoundResource   boundBuffers[kTrackedSlots];
+        BoundResource   boundTextures[kTrackedSlots];
+
+        for (const SortedDrawItem& sortedItem : _items) {
+            const gfx::DrawItem* drawItem = sortedItem.item;
+            dg_assert(drawItem->streamCount == 1, "> 1 stream count not supported");
+
+            const PipelineStateId pipelineStateId = drawItem->pipelineState;
+            const VertexStream&   stream          = drawItem->streams()[0];
+            const Binding*        bindings        = drawItem->bindings();
+            const DrawCall&       drawCall        = drawItem->drawCall;
+
+            if (pipelineStateId != boundPipelineState) {
+                commandBuffer->setPipelineState(pipelineStateId);
+                boundPipelineState = pipelineStateId;
+                ++_stats.pipelineStateChanges;
+            } else {
+                ++_stats.redundantBindsSkipped;
+            }
+
+            if (stream.vertexBuffer != boundVertexBuffer) {
+                commandBuffer->setVertexBuffer(stream.vertexBuffer);
+                boundVertexBuffer = stream.vertexBuffer;
+                ++_stats.vertexBufferChanges;
+            } else {
+                ++_stats.redundantBindsSkipped;
             }
             
-            commandBuffer->setPipelineState(pipelineStateId);
-            commandBuffer->setVertexBuffer(streamPtr[0].vertexBuffer);
-            
-            for (const Binding& binding : bindings) {
+            for (uint32_t idx = 0; idx < drawItem->bindingCount; ++idx) {
+                const Binding& binding = bindings[idx];
                 switch (binding.type) {
-                    case Binding::Type::ConstantBuffer: {
-                        commandBuffer->setShaderBuffer(binding.resource, binding.slot, binding.stageFlags);
+                    case Binding::Type::ConstantBuffer:
+                    case Binding::Type::DynamicConstantBuffer: {
+                        uint32_t offset = binding.offset;
+                        if (binding.type == Binding::Type::DynamicConstantBuffer) {
+                            offset += sortedItem.dynamicOffset;
+                        }
+                        if (BindIfChanged(boundBuffers, binding, offset)) {
+                            commandBuffer->setShaderBuffer(binding.resource, binding.slot, binding.stageFlags, offset);
+                            ++_stats.bufferBinds;
+                        }
                         break;
                     }
                     case Binding::Type::Texture: {
-                        commandBuffer->setShaderTexture(binding.resource, binding.slot, binding.stageFlags);
+                        if (BindIfChanged(boundTextures, binding, 0)) {
+                            commandBuffer->setShaderTexture(binding.resource, binding.slot, binding.stageFlags);
+                            ++_stats.textureBinds;
+                        }
                         break;
                     }
                     default: {
@@ -81,21 +146,61 @@ public:
             }
             switch (drawCall.type) {
                 case DrawCall::Type::Arrays: {
+                    dg_assert(sortedItem.instanceCount == 1, "instanced arrays draws aren't supported");
                     commandBuffer->drawPrimitives(drawCall.startOffset, drawCall.primitiveCount);
                     break;
                 }
                 case DrawCall::Type::Indexed: {
-                    commandBuffer->drawIndexed(indexBufferId, drawCall.primitiveCount, drawCall.startOffset, drawCall.baseVertexOffset);
+                    if (sortedItem.instanceCount > 1) {
+                        commandBuffer->drawIndexedInstanced(drawItem->indexBuffer, drawCall.primitiveCount, drawCall.startOffset, drawCall.baseVertexOffset,
+                                                            sortedItem.instanceCount);
+                    } else {
+                        commandBuffer->drawIndexed(drawItem->indexBuffer, drawCall.primitiveCount, drawCall.startOffset, drawCall.baseVertexOffset);
+                    }
                     break;
                 }
                 default:
                     dg_assert_fail_nm();
             }
+            ++_stats.drawCalls;
+            _stats.instances += sortedItem.instanceCount;
         }
     }
 
 private:
+    // bindings stick across pipeline changes on every backend, so only a different resource, offset or stage set needs
+    // a call
+    bool BindIfChanged(BoundResource* bound, const Binding& binding, uint32_t offset) {
+        if (binding.slot >= kTrackedSlots) {
+            return true;
+        }
+
+        BoundResource& slot = bound[binding.slot];
+        if (slot.resource == binding.resource && slot.offset == offset && slot.stages == binding.stageFlags) {
+            ++_stats.redundantBindsSkipped;
+            return false;
+        }
+        slot.resource = binding.resource;
+        slot.offset   = offset;
+        slot.stages   = binding.stageFlags;
+        return true;
+    }
+
+    // the owner's segment goes first, so items from serial renderers keep their relative order through the stable sort
+    void Gather() {
+        size_t count = 0;
+        for (const Segment& segment : _segments) {
+            count += segment.items.size();
+        }
+        _items.clear();
+        _items.reserve(count);
+        for (Segment& segment : _segments) {
+            _items.insert(_items.end(), segment.items.begin(), segment.items.end());
+            segment.items.clear();
+        }
+    }
+
     void Sort() {
-        std::sort(begin(_items), end(_items), [](const DrawItemPair& p1, const DrawItemPair& p2) { return p1.first < p2.first; });
+        RadixSort64(_items, _sortScratch, [](const SortedDrawItem& sortedItem) { return sortedItem.key; });
     }
 };
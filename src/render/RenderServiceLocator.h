@@ -8,6 +8,7 @@
 #include "PipelineStateCache.h"
 #include "RenderDevice.h"
 #include "ShaderCache.h"
+#include "TransientBufferRing.h"
 #include "VertexLayoutCache.h"
 #include "AnimationCache.h"
 
@@ -22,4 +23,6 @@ public:
     virtual ConstantBufferManager* constantBufferManager() = 0;
     virtual DebugDrawInterface*    debugDraw()             = 0;
     virtual AnimationCache*        animationCache()        = 0;
+    // per frame constants, allocate between the start of RenderFrame and the queue's submit
+    virtual TransientBufferRing*   transientConstants()    = 0;
 };
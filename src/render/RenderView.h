@@ -14,6 +14,7 @@ struct FrameView {
     const glm::vec3 look;
     const Frustum   frustum;
     const Viewport  viewport;
+    const float     zfar;
     
     std::vector<RenderObj*> _visibleObjects;
 };
@@ -28,6 +29,6 @@ struct RenderView {
         glm::mat4 proj  = camera->BuildProjection();
         glm::mat4 view  = camera->BuildView();
         glm::mat4 ortho = glm::ortho(0.0f, viewport->width, 0.0f, viewport->height);
-        return {camera->pos, proj, view, ortho, camera->look, {proj, view}, *viewport};
+        return {camera->pos, proj, view, ortho, camera->look, {proj, view}, *viewport, camera->zfar};
     }
 };
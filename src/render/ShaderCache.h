@@ -41,7 +41,7 @@ public:
             _device->AddOrUpdateShaders({shaderData});
         };
         
-        if(_device->GetDeviceApi() != gfx::RenderDeviceApi::OpenGL) {
+        if(_device->GetDeviceApi() != gfx::RenderDeviceApi::OpenGL && _device->GetDeviceApi() != gfx::RenderDeviceApi::Null) {
             _watcherId = fs::WatchDirManager::AddWatcher(_baseDir, eventCallback);
         }
 
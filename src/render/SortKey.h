@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdint>
+#include "DrawItem.h"
+#include "ResourceTypes.h"
+
+// Drawn in enum order inside a pass. World sorts by state, the others keep the order renderers added them in
+enum class RenderLayer : uint8_t {
+    World = 0,
+    Sky,
+    UI,
+    TextCursor,
+    Text,
+    Debug,
+    Count,
+};
+
+// 64 bit RenderQueue key, drawn ascending:
+//   opaque       pass:4 | layer:4 | 0:1 | pipeline:16 | material:16 | depth:23     grouped by state, near to far inside
+//   translucent  pass:4 | layer:4 | 1:1 | ~depth:23   | pipeline:16 | material:16  far to near
+// pipeline and material ids are only used to group, ids that alias past 16 bits just cost a state change
+namespace SortKey {
+static constexpr uint32_t kDepthBits    = 23;
+static constexpr uint32_t kIdBits       = 16;
+static constexpr uint64_t kDepthMask    = (1ull << kDepthBits) - 1;
+static constexpr uint64_t kIdMask       = (1ull << kIdBits) - 1;
+static constexpr uint32_t kPassShift    = 60;
+static constexpr uint32_t kLayerShift   = 56;
+static constexpr uint32_t kTranslucency = 55;
+
+inline uint64_t QuantizeDepth(float depth) {
+    return static_cast<uint64_t>(std::clamp(depth, 0.f, 1.f) * static_cast<float>(kDepthMask)) & kDepthMask;
+}
+
+inline uint64_t Header(uint8_t pass, RenderLayer layer, bool translucent) {
+    return (static_cast<uint64_t>(pass & 0xf) << kPassShift) | (static_cast<uint64_t>(layer) << kLayerShift) |
+           (static_cast<uint64_t>(translucent) << kTranslucency);
+}
+
+inline gfx::PipelineStateId PipelineOf(const gfx::DrawItem* item) { return item->pipelineState; }
+
+// folds a pointer or id into the material field
+inline uint32_t MaterialKey(uint64_t material) { return static_cast<uint32_t>(material ^ (material >> 16) ^ (material >> 32)) & kIdMask; }
+inline uint32_t MaterialKey(const void* material) { return MaterialKey(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(material)) >> 4); }
+
+// depth is view distance over the far plane, [0, 1]
+inline uint64_t Opaque(RenderLayer layer, const gfx::DrawItem* item, uint32_t material, float depth, uint8_t pass = 0) {
+    return Header(pass, layer, false) | ((PipelineOf(item) & kIdMask) << (kIdBits + kDepthBits)) | ((material & kIdMask) << kDepthBits) |
+           QuantizeDepth(depth);
+}
+
+inline uint64_t Translucent(RenderLayer layer, const gfx::DrawItem* item, uint32_t material, float depth, uint8_t pass = 0) {
+    return Header(pass, layer, true) | ((kDepthMask - QuantizeDepth(depth)) << (kIdBits * 2)) | ((PipelineOf(item) & kIdMask) << kIdBits) |
+           (material & kIdMask);
+}
+
+// no state or depth bits, the queue's sort is stable so items come out in the order they went in
+inline uint64_t Ordered(RenderLayer layer, uint8_t pass = 0) { return Header(pass, layer, false); }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include "DGAssert.h"
+#include "Log.h"
+#include "RenderDevice.h"
+#include "RenderPassCommandBuffer.h"
+
+// Per frame data out of one buffer. The buffer is kFramesInFlight regions, a frame maps once, bumps allocations out of
+// its own region and unmaps before submit, so the gpu can still be reading the regions of the frames before it.
+// Nothing waits on a fence here, the swapchain does that: metal's in flight semaphore never lets the cpu get more than
+// kImageCount (2) frames ahead, and dx11 renames the buffer on a discard map anyway.
+// Allocations are kShaderBufferOffsetAlignment aligned and bound through a DynamicConstantBuffer binding with the
+// offset passed to RenderQueue::AddDrawItem. A binding sees up to kBindWindow bytes from its offset whatever the
+// allocation's size, the buffer has that much slack past the last region so an allocation can be shorter than the
+// shader's struct as long as the shader never reads past what was written (unused bones).
+// Allocate is safe from scheduler workers, the rest is frame thread only
+class TransientBufferRing {
+public:
+    static constexpr uint32_t kFramesInFlight = 3;
+    static constexpr uint32_t kAlignment      = gfx::kShaderBufferOffsetAlignment;
+    static constexpr uint32_t kBindWindow     = 64 * 1024; // 4096 constants, the most dx11 binds
+
+    struct Allocation {
+        uint8_t* data{nullptr}; // nullptr when the frame is out of space
+        uint32_t offset{0};     // from the start of buffer(), what the draw gets queued with
+
+        explicit operator bool() const { return data != nullptr; }
+    };
+
+    struct Stats {
+        size_t   bytesUsed{0}; // last finished frame
+        size_t   frameSize{0};
+        uint32_t allocations{0};
+        uint32_t failed{0};
+    };
+
+private:
+    gfx::RenderDevice*    _device;
+    gfx::BufferId         _buffer{gfx::NULL_ID};
+    size_t                _frameSize;
+    uint32_t              _frame{0};
+    uint8_t*              _mapped{nullptr}; // start of the current frame's region
+    std::atomic<size_t>   _head{0};
+    std::atomic<uint32_t> _allocations{0};
+    std::atomic<uint32_t> _failed{0};
+    Stats                 _stats;
+
+public:
+    TransientBufferRing(gfx::RenderDevice* device, gfx::BufferUsageFlags usage, size_t frameSize, const std::string& debugName)
+        : _device(device), _frameSize((frameSize + kAlignment - 1) & ~size_t(kAlignment - 1)) {
+        _buffer = _device->AllocateBuffer(gfx::BufferDesc::defaultTransient(usage, _frameSize * kFramesInFlight + kBindWindow, debugName));
+        dg_assert_nm(_buffer != gfx::NULL_ID);
+        _stats.frameSize = _frameSize;
+    }
+
+    ~TransientBufferRing() { _device->DestroyResource(_buffer); }
+
+    TransientBufferRing(const TransientBufferRing&) = delete;
+    TransientBufferRing& operator=(const TransientBufferRing&) = delete;
+
+    gfx::BufferId buffer() const { return _buffer; }
+    const Stats&  GetStats() const { return _stats; }
+
+    void BeginFrame() {
+        dg_assert(_mapped == nullptr, "BeginFrame without EndFrame");
+        _frame       = (_frame + 1) % kFramesInFlight;
+        _head        = 0;
+        _allocations = 0;
+        _failed      = 0;
+
+        uint8_t* base = _device->MapMemory(_buffer, gfx::BufferAccess::Write);
+        dg_assert_nm(base);
+        _mapped = base + FrameBase();
+    }
+
+    void EndFrame() {
+        dg_assert(_mapped != nullptr, "EndFrame without BeginFrame");
+        _stats.bytesUsed = std::min(_head.load(), _frameSize);
+        // only what this frame allocated needs flushing, not the whole ring
+        _device->UnmapMemoryRange(_buffer, FrameBase(), _stats.bytesUsed);
+        _mapped = nullptr;
+
+        _stats.allocations = _allocations;
+        _stats.failed      = _failed;
+        if (_stats.failed > 0) {
+            LOG_E("TransientBufferRing: %u allocations didn't fit in %zu bytes", _stats.failed, _frameSize);
+        }
+    }
+
+    // only valid until EndFrame
+    Allocation Allocate(size_t size) {
+        dg_assert(_mapped != nullptr, "Allocate outside BeginFrame/EndFrame");
+        size_t aligned = (size + kAlignment - 1) & ~size_t(kAlignment - 1);
+        size_t start   = _head.fetch_add(aligned, std::memory_order_relaxed);
+        if (start + aligned > _frameSize) {
+            ++_failed;
+            return Allocation();
+        }
+        ++_allocations;
+        return {_mapped + start, static_cast<uint32_t>(FrameBase() + start)};
+    }
+
+    template <class T>
+    T* Allocate(uint32_t* offset) {
+        Allocation allocation = Allocate(sizeof(T));
+        *offset               = allocation.offset;
+        return reinterpret_cast<T*>(allocation.data);
+    }
+
+private:
+    size_t FrameBase() const { return _frameSize * _frame; }
+};
@@ -1,23 +1,75 @@
 #pragma once
 
+#include <xxhash.h>
 #include <cassert>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "RenderDevice.h"
 #include "VertexLayoutDesc.h"
 
+// Hash-consed like PipelineStateCache, equal attribute lists share one device layout so pipeline states built from
+// them dedupe too. Layouts live as long as the cache
 class VertexLayoutCache {
+public:
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        size_t   vertexLayouts{0};
+    };
+
 private:
-    gfx::RenderDevice* _device;
+    struct Entry {
+        gfx::VertexLayoutDesc desc;
+        gfx::VertexLayoutId   id{gfx::NULL_ID};
+    };
+
+    gfx::RenderDevice*                               _device;
+    std::mutex                                       _mutex;
+    std::unordered_map<uint64_t, std::vector<Entry>> _entries;
+    Stats                                            _stats;
 
 public:
     VertexLayoutCache(gfx::RenderDevice* device) : _device(device) {}
 
+    ~VertexLayoutCache() {
+        for (const auto& bucket : _entries) {
+            for (const Entry& entry : bucket.second) {
+                _device->DestroyResource(entry.id);
+            }
+        }
+    }
+
     gfx::VertexLayoutId Get(const gfx::VertexLayoutDesc& vld) {
-        // TODO: actually cache
+        // 3 bytes an attribute, packed so padding stays out of it and chained through the seed so nothing allocates
+        uint64_t hash = 0;
+        for (const gfx::VertexLayoutElement& element : vld.elements) {
+            uint8_t packed[3] = {static_cast<uint8_t>(element.type), static_cast<uint8_t>(element.usage), static_cast<uint8_t>(element.storage)};
+            hash              = XXH3_64bits_withSeed(packed, sizeof(packed), hash);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<Entry>&         bucket = _entries[hash];
+        for (const Entry& entry : bucket) {
+            if (entry.desc == vld) {
+                ++_stats.hits;
+                return entry.id;
+            }
+        }
+
         gfx::VertexLayoutId vlId = _device->CreateVertexLayout(vld);
         assert(vlId);
+        bucket.push_back({vld, vlId});
+        ++_stats.misses;
+        ++_stats.vertexLayouts;
         return vlId;
     }
 
+    Stats GetStats() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
     gfx::VertexLayoutId Pos3fNormal3fTex2f() {
         static gfx::VertexLayoutDesc layout{{{gfx::VertexAttributeType::Float3, gfx::VertexAttributeUsage::Position, gfx::VertexAttributeStorage::Float},
                                              {gfx::VertexAttributeType::Float3, gfx::VertexAttributeUsage::Normal, gfx::VertexAttributeStorage::Float},
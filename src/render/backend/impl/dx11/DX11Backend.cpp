@@ -10,7 +10,11 @@ namespace gfx {
     DX11Backend::DX11Backend(bool usePrebuiltShaders) {
         DX11_CHECK(CreateDXGIFactory1(IID_PPV_ARGS(&m_factory)));
         _device.reset(new DX11Device(&resourceManager, usePrebuiltShaders));
-        dg_assert_nm(_device.get() != nullptr);
+        if (!_device->IsInitialized()) {
+            // getRenderDevice hands out null and the platform layer gives up
+            LOG_E("DX11Backend: couldn't create a usable device");
+            _device.reset();
+        }
     }
 
     Swapchain* DX11Backend::createSwapchainForWindow(const SwapchainDesc& swapchainDesc, RenderDevice* device, void* windowHandle) {
@@ -1,4 +1,5 @@
 #include "DX11Context.h"
+#include "DGAssert.h"
 #include "Hash.h"
 
 namespace std {
@@ -89,28 +90,26 @@ namespace gfx {
         m_devcon->UpdateSubresource(tex, subresource, &box, data, rowPitch, rowDepth);
     }
 
-    void DX11Context::SetVertexCBuffer(uint32_t slot, ID3D11Buffer* buffer) {
-        auto it = m_currentState.vsCBuffers.find(slot);
-        if (it == m_currentState.vsCBuffers.end()) {
-            m_pendingState.vsCBuffers.emplace(slot, buffer);
-            m_pendingState.vsCBufferDirtySlots.emplace(slot);
-        }
-        else if (it->second != buffer) {
-            m_pendingState.vsCBuffers[slot] = buffer;
-            m_pendingState.vsCBufferDirtySlots.emplace(slot);
+    void DX11Context::SetCBuffer(std::unordered_map<uint32_t, ID3D11Buffer*>& pendingBuffers, std::unordered_map<uint32_t, uint32_t>& pendingOffsets,
+                                 std::unordered_set<uint32_t>& dirtySlots, const std::unordered_map<uint32_t, ID3D11Buffer*>& currentBuffers,
+                                 const std::unordered_map<uint32_t, uint32_t>& currentOffsets, uint32_t slot, ID3D11Buffer* buffer, uint32_t offset) {
+        auto bufferIt = currentBuffers.find(slot);
+        auto offsetIt = currentOffsets.find(slot);
+        pendingBuffers[slot] = buffer;
+        pendingOffsets[slot] = offset;
+        if (bufferIt == currentBuffers.end() || bufferIt->second != buffer || offsetIt == currentOffsets.end() || offsetIt->second != offset) {
+            dirtySlots.emplace(slot);
         }
     }
 
-    void DX11Context::SetPixelCBuffer(uint32_t slot, ID3D11Buffer* buffer) {
-        auto it = m_currentState.psCBuffers.find(slot);
-        if (it == m_currentState.psCBuffers.end()) {
-            m_pendingState.psCBuffers.emplace(slot, buffer);
-            m_pendingState.psCBufferDirtySlots.emplace(slot);
-        }
-        else if (it->second != buffer) {
-            m_pendingState.psCBuffers[slot] = buffer;
-            m_pendingState.psCBufferDirtySlots.emplace(slot);
-        }
+    void DX11Context::SetVertexCBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t offset) {
+        SetCBuffer(m_pendingState.vsCBuffers, m_pendingState.vsCBufferOffsets, m_pendingState.vsCBufferDirtySlots, m_currentState.vsCBuffers,
+                   m_currentState.vsCBufferOffsets, slot, buffer, offset);
+    }
+
+    void DX11Context::SetPixelCBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t offset) {
+        SetCBuffer(m_pendingState.psCBuffers, m_pendingState.psCBufferOffsets, m_pendingState.psCBufferDirtySlots, m_currentState.psCBuffers,
+                   m_currentState.psCBufferOffsets, slot, buffer, offset);
     }
 
     void DX11Context::SetInputLayout(uint32_t stride, ID3D11InputLayout* layout) {
@@ -168,13 +167,17 @@ namespace gfx {
         m_pendingState.primitiveType = top;
     }
 
-    void DX11Context::DrawPrimitive(uint32_t startVertex, uint32_t numVertices, bool indexed, uint32_t baseVertexLocation) {
+    void DX11Context::DrawPrimitive(uint32_t startVertex, uint32_t numVertices, bool indexed, uint32_t baseVertexLocation, uint32_t instanceCount) {
 
         if (m_pendingState.vertexShader != nullptr && m_currentState.vertexShader != m_pendingState.vertexShader)
             m_devcon->VSSetShader(m_pendingState.vertexShader, 0, 0);
 
-        for (uint32_t slot : m_pendingState.vsCBufferDirtySlots)
-            m_devcon->VSSetConstantBuffers(slot, static_cast<UINT>(1), &m_pendingState.vsCBuffers[slot]);
+        // offsets go in 16 byte constants. the range is the most a cbuffer can see, reads past the buffer's end return 0
+        static constexpr UINT kMaxConstants = D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT;
+        for (uint32_t slot : m_pendingState.vsCBufferDirtySlots) {
+            UINT firstConstant = m_pendingState.vsCBufferOffsets[slot] / 16;
+            m_devcon1->VSSetConstantBuffers1(slot, 1, &m_pendingState.vsCBuffers[slot], &firstConstant, &kMaxConstants);
+        }
 
         // todo: format?
         if (m_pendingState.indexBuffer != nullptr && m_currentState.indexBuffer != m_pendingState.indexBuffer)
@@ -206,8 +209,10 @@ namespace gfx {
         if (m_pendingState.pixelShader != nullptr && m_currentState.pixelShader != m_pendingState.pixelShader)
             m_devcon->PSSetShader(m_pendingState.pixelShader, 0, 0);
 
-        for (uint32_t slot : m_pendingState.psCBufferDirtySlots)
-            m_devcon->PSSetConstantBuffers(slot, static_cast<UINT>(1), &m_pendingState.psCBuffers[slot]);
+        for (uint32_t slot : m_pendingState.psCBufferDirtySlots) {
+            UINT firstConstant = m_pendingState.psCBufferOffsets[slot] / 16;
+            m_devcon1->PSSetConstantBuffers1(slot, 1, &m_pendingState.psCBuffers[slot], &firstConstant, &kMaxConstants);
+        }
 
         if (m_pendingState.rasterState != nullptr && m_currentState.rasterState != m_pendingState.rasterState)
             m_devcon->RSSetState(m_pendingState.rasterState);
@@ -231,7 +236,13 @@ namespace gfx {
 #ifdef DX11_3_API
         m_devcon->OMSetRenderTargets(1, &m_renderTargetView, m_depthStencilView);
 #endif
-        if (indexed)
+        if (instanceCount > 1) {
+            if (indexed)
+                m_devcon->DrawIndexedInstanced(numVertices, instanceCount, startVertex, baseVertexLocation, 0);
+            else
+                m_devcon->DrawInstanced(numVertices, instanceCount, startVertex, 0);
+        }
+        else if (indexed)
             m_devcon->DrawIndexed(numVertices, startVertex, baseVertexLocation);
         else
             m_devcon->Draw(numVertices, startVertex);
@@ -2,6 +2,7 @@
 #include "DX11ContextState.h"
 
 #include "DX11Debug.h"
+#include "DGAssert.h"
 
 #include <unordered_map>
 #include <array>
@@ -17,7 +18,7 @@
 #ifdef DX11_3_API
 #include <d3d11_3.h>
 #else
-#include <d3d11.h>
+#include <d3d11_1.h>
 #endif
 
 namespace gfx {
@@ -28,11 +29,21 @@ namespace gfx {
 #else
         Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_devcon;
 #endif
+        // 11.1, for binding constant buffers at an offset. DX11Device won't start without it
+        Microsoft::WRL::ComPtr<ID3D11DeviceContext1> m_devcon1;
         DX11ContextState m_pendingState, m_currentState;
+
+        void SetCBuffer(std::unordered_map<uint32_t, ID3D11Buffer*>& pendingBuffers, std::unordered_map<uint32_t, uint32_t>& pendingOffsets,
+                        std::unordered_set<uint32_t>& dirtySlots, const std::unordered_map<uint32_t, ID3D11Buffer*>& currentBuffers,
+                        const std::unordered_map<uint32_t, uint32_t>& currentOffsets, uint32_t slot, ID3D11Buffer* buffer, uint32_t offset);
     public:
 
         // todo: switch this over to use comptr for resources, now that its deferred context, things might get ugly with deleting
-        DX11Context(Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext) { m_devcon.Swap(deviceContext); };
+        DX11Context(Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext) {
+            m_devcon.Swap(deviceContext);
+            m_devcon.As(&m_devcon1);
+            dg_assert(m_devcon1 != nullptr, "d3d11.1 device context required");
+        };
         ID3D11DeviceContext* GetD3D11Context() { return m_devcon.Get(); };
 
         void* MapBufferPointer(ID3D11Buffer* buffer, D3D11_MAP usage);
@@ -44,8 +55,8 @@ namespace gfx {
         void ClearRenderTargetView(ID3D11RenderTargetView* rtv, float r, float g, float b, float a);
         void ClearDepthStencil(ID3D11DepthStencilView* dsv, bool clearDepth, float depthVal, bool clearStencil, uint8_t stencilVal);
 
-        void SetVertexCBuffer(uint32_t slot, ID3D11Buffer* buffer);
-        void SetPixelCBuffer(uint32_t slot, ID3D11Buffer* buffer);
+        void SetVertexCBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t offset = 0);
+        void SetPixelCBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t offset = 0);
 
         void SetVertexBuffer(ID3D11Buffer* buffer);
         void SetIndexBuffer(ID3D11Buffer* buffer);
@@ -67,7 +78,7 @@ namespace gfx {
 
         void SetPrimitiveType(D3D11_PRIMITIVE_TOPOLOGY top);
 
-        void DrawPrimitive(uint32_t startVertex, uint32_t numVertices, bool indexed, uint32_t baseVertexLocation = 0);
+        void DrawPrimitive(uint32_t startVertex, uint32_t numVertices, bool indexed, uint32_t baseVertexLocation = 0, uint32_t instanceCount = 1);
 
         void ExecuteCommandList(ID3D11CommandList *pCommandList, BOOL RestoreContextState);
     };
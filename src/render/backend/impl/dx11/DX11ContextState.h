@@ -13,6 +13,7 @@ namespace gfx {
         ID3D11VertexShader* vertexShader{ nullptr };
 
         std::unordered_map<uint32_t, ID3D11Buffer*> vsCBuffers;
+        std::unordered_map<uint32_t, uint32_t> vsCBufferOffsets;
         std::unordered_set<uint32_t> vsCBufferDirtySlots;
 
         std::unordered_map<uint32_t, ID3D11ShaderResourceView*> vsTextures;
@@ -20,6 +21,7 @@ namespace gfx {
         std::unordered_set<uint32_t> vsDirtyTextureSlots;
 
         std::unordered_map<uint32_t, ID3D11Buffer*> psCBuffers;
+        std::unordered_map<uint32_t, uint32_t> psCBufferOffsets;
         std::unordered_set<uint32_t> psCBufferDirtySlots;
 
         std::unordered_map<uint32_t, ID3D11ShaderResourceView*> psTextures;
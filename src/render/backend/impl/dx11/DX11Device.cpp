@@ -654,6 +654,18 @@ namespace gfx {
             nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, creationFlags, FeatureLevelsRequested, numLevelsRequested, D3D11_SDK_VERSION,
             &m_dev, nullptr, &context));
 
+        // transient constants are bound at offsets into one ring buffer (VSSetConstantBuffers1), that takes an 11.1 runtime
+        // (win8 and up, or win7 with the platform update) and a driver that does offsetting. Without it every draw would
+        // read its constants from offset 0, so don't start at all
+        ComPtr<ID3D11DeviceContext1> context1;
+        DX11_CHECK_RET(context.As(&context1));
+        D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+        DX11_CHECK_RET(m_dev->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)));
+        if (!options.ConstantBufferOffsetting) {
+            LOG_E("DX11Device: driver can't bind constant buffers at an offset");
+            return;
+        }
+
         std::string tmp = "ImdCtx";
         D3D_SET_OBJECT_NAME_A(context, tmp.c_str());
 
@@ -694,5 +706,7 @@ namespace gfx {
 
         // todo: deal with this?
         CreateDefaultSampler();
+
+        m_initialized = true;
     }
 }
\ No newline at end of file
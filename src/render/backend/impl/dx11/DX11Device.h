@@ -40,10 +40,16 @@ namespace gfx {
         ResourceManager* m_resourceManager{ nullptr };
         SimpleShaderLibrary m_shaderLibrary;
 
+        bool m_initialized{ false };
+
     public:
         DX11Device() = delete;
         DX11Device(ResourceManager* resourceManager, bool usePrebuiltShaders=false);
 
+        // false when the constructor bailed out partway (no device, or a driver missing something we need), nothing
+        // else on it can be called then
+        bool IsInitialized() const { return m_initialized; }
+
         // DX11 Specific 
 #ifdef DX11_3_API
         ID3D11Device3* GetID3D11Dev() { return m_dev.Get();  }
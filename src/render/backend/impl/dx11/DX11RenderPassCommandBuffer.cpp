@@ -144,12 +144,12 @@ namespace gfx {
         _cmdBuf->SetVertexBuffer(vb->buffer.Get());
     }
 
-    void DX11RenderPassCommandBuffer::setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages) {
+    void DX11RenderPassCommandBuffer::setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages, uint32_t offset) {
         BufferDX11* cbuffer = _rm->GetResource<BufferDX11>(buffer);
         if ((stages & ShaderStageFlags::VertexBit) != ShaderStageFlags::None)
-            _cmdBuf->SetVertexCBuffer(index, cbuffer->buffer.Get());
+            _cmdBuf->SetVertexCBuffer(index, cbuffer->buffer.Get(), offset);
         if ((stages & ShaderStageFlags::PixelBit) != ShaderStageFlags::None)
-            _cmdBuf->SetPixelCBuffer(index, cbuffer->buffer.Get());
+            _cmdBuf->SetPixelCBuffer(index, cbuffer->buffer.Get(), offset);
     }
 
     void DX11RenderPassCommandBuffer::setShaderTexture(TextureId texture, uint8_t index, ShaderStageFlags stages) {
@@ -173,4 +173,11 @@ namespace gfx {
         _cmdBuf->SetIndexBuffer(indexBuffer->buffer.Get());
         _cmdBuf->DrawPrimitive(indexOffset, indexCount, true, baseVertexOffset);
     }
+
+    void DX11RenderPassCommandBuffer::drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset,
+                                                           uint32_t instanceCount) {
+        auto indexBuffer = _rm->GetResource<BufferDX11>(indexBufferId);
+        _cmdBuf->SetIndexBuffer(indexBuffer->buffer.Get());
+        _cmdBuf->DrawPrimitive(indexOffset, indexCount, true, baseVertexOffset, instanceCount);
+    }
 }
\ No newline at end of file
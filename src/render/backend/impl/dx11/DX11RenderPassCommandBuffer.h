@@ -33,9 +33,10 @@ namespace gfx {
 
         void setPipelineState(PipelineStateId psId) final;
         void setVertexBuffer(BufferId vertexBuffer) final;
-        void setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages) final;
+        void setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages, uint32_t offset) final;
         void setShaderTexture(TextureId texture, uint8_t index, ShaderStageFlags stages) final;
         void drawPrimitives(uint32_t startOffset, uint32_t vertexCount) final;
         void drawIndexed(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset) final;
+        void drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset, uint32_t instanceCount) final;
     };
 }
\ No newline at end of file
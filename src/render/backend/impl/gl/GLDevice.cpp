@@ -11,7 +11,6 @@
 #include "StringUtil.h"
 #include "ShaderStageFlags.h"
 #include "Memory.h"
-#include "DrawItemDecoder.h"
 #include "DMath.h"
 #include "ResourceTypes.h"
 #include "DGAssert.h"
@@ -550,33 +549,17 @@ void GLDevice::Execute(CommandBuffer* cmdBuffer) {
     for (const DrawItem* item : *items) {
         //LOG_D("%s", "DrawItem");
 
-        DrawItemDecoder decoder(item);
-
-        PipelineStateId           psId;
-        DrawCall                  drawCall;
-        BufferId                  indexBufferId;
-        size_t                    streamCount  = decoder.GetStreamCount();
-        size_t                    bindingCount = decoder.GetBindingCount();
-        std::vector<VertexStream> streams(streamCount);
-        std::vector<Binding>      bindings(bindingCount);
-        VertexStream*             streamPtr  = streams.data();
-        Binding*                  bindingPtr = bindings.data();
-
-        assert(streamCount == 1); // > 1 not supported
-
-        dg_assert_nm(decoder.ReadDrawCall(&drawCall));
-        dg_assert_nm(decoder.ReadPipelineState(&psId));
-        dg_assert_nm(decoder.ReadIndexBuffer(&indexBufferId));
-        dg_assert_nm(decoder.ReadVertexStreams(&streamPtr));
-        if (bindingCount > 0) {
-            dg_assert_nm(decoder.ReadBindings(&bindingPtr));
-        }
+        PipelineStateId psId          = item->pipelineState;
+        const DrawCall& drawCall      = item->drawCall;
+        BufferId        indexBufferId = item->indexBuffer;
+
+        assert(item->streamCount == 1); // > 1 not supported
 
         GLPipelineState* pipelineState = _resourceManager.GetResource<GLPipelineState>(psId);
         assert(pipelineState);
         _context.BindPipelineState(pipelineState);
 
-        const VertexStream& stream       = streams[0];
+        const VertexStream& stream       = item->streams()[0];
         GLShaderProgram*    vertexShader = pipelineState->vertexShader;
         GLVertexLayout*     vertexLayout = pipelineState->vertexLayout;
         GLBuffer*           vertexBuffer = _resourceManager.GetResource<GLBuffer>(stream.vertexBuffer);
@@ -590,8 +573,8 @@ void GLDevice::Execute(CommandBuffer* cmdBuffer) {
         _context.BindVertexArrayObject(vao);
 
         // bindings
-        for (const Binding& binding : bindings) {
-            BindResource(binding);
+        for (uint32_t idx = 0; idx < item->bindingCount; ++idx) {
+            BindResource(item->bindings()[idx]);
         }
 
         switch (drawCall.type) {
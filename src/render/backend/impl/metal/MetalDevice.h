@@ -47,6 +47,7 @@ namespace gfx {
         virtual void UpdateTexture(TextureId texture, uint32_t slice, const void* srcData) override;
         virtual void DestroyResource(ResourceId resourceId) override;
         virtual void UnmapMemory(BufferId bufferId) override;
+        virtual void UnmapMemoryRange(BufferId bufferId, size_t offset, size_t size) override;
         virtual void Submit(const std::vector<CommandBuffer*>& cmdBuffers) override;
         
         // ----------
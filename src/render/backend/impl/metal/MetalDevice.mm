@@ -8,7 +8,6 @@
 #import "MetalDevice.h"
 #import <QuartzCore/CVDisplayLink.h>
 #include "DGAssert.h"
-#include "DrawItemDecoder.h"
 #include "Log.h"
 #include "MetalEnumAdapter.h"
 #include "MetalShaderLibrary.h"
@@ -390,8 +389,17 @@ void MetalDevice::UnmapMemory(BufferId bufferId) {
     if (!buffer) {
         return;
     }
+    UnmapMemoryRange(bufferId, 0, buffer->desc.size);
+}
+
+void MetalDevice::UnmapMemoryRange(BufferId bufferId, size_t offset, size_t size) {
+    MetalBuffer* buffer = _resourceManager->GetResource<MetalBuffer>(bufferId);
+    if (!buffer || size == 0) {
+        return;
+    }
+    dg_assert_nm(offset + size <= buffer->desc.size);
     // currently all buffers are managed so we need to invalidate on update
-    NSRange range = NSMakeRange(0, buffer->desc.size);
+    NSRange range = NSMakeRange(offset, size);
     [buffer->mtlBuffer didModifyRange:range];
 }
 
@@ -418,7 +426,8 @@ RenderPassId MetalDevice::CreateRenderPass(const RenderPassInfo& renderPassInfo)
 
 void MetalDevice::DestroyResource(ResourceId resourceId)
 {
-    dg_assert_fail("lol");
+    // command buffers in flight retain whatever mtl objects they use
+    _resourceManager->DestroyResource<Resource>(resourceId);
 }
 
 id<MTLDevice> MetalDevice::getMTLDevice()
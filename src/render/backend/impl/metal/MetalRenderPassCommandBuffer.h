@@ -26,9 +26,10 @@ namespace gfx
     public:
         MetalRenderPassCommandBuffer(id<MTLRenderCommandEncoder> encoder, ResourceManager* resourceManager);
         virtual void setPipelineState(PipelineStateId pipelineStateId) override;
-        virtual void setShaderBuffer(BufferId bufferId, uint8_t index, ShaderStageFlags stages) override;
+        virtual void setShaderBuffer(BufferId bufferId, uint8_t index, ShaderStageFlags stages, uint32_t offset) override;
         virtual void setShaderTexture(TextureId textureId, uint8_t index, ShaderStageFlags stages) override;
         virtual void drawIndexed(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset) override;
+        virtual void drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset, uint32_t instanceCount) override;
         virtual void drawPrimitives(uint32_t startOffset, uint32_t vertexCount) override;
         virtual void setVertexBuffer(BufferId vertexBuffer) override;
         
@@ -30,15 +30,15 @@ void MetalRenderPassCommandBuffer::setPipelineState(PipelineStateId pipelineStat
     [_encoder setCullMode:MetalEnumAdapter::toMTL(pipelineState->pipelineStateDesc.rasterState.cullMode)];
     [_encoder setTriangleFillMode:MetalEnumAdapter::toMTL(pipelineState->pipelineStateDesc.rasterState.fillMode)];
 }
-void MetalRenderPassCommandBuffer::setShaderBuffer(BufferId bufferId, uint8_t index, ShaderStageFlags stages)
+void MetalRenderPassCommandBuffer::setShaderBuffer(BufferId bufferId, uint8_t index, ShaderStageFlags stages, uint32_t offset)
 {
     index += 1;
     MetalBuffer* buffer = _resourceManager->GetResource<MetalBuffer>(bufferId);
     if (stages & ShaderStageFlags::VertexBit) {
-        [_encoder setVertexBuffer:buffer->mtlBuffer offset:0 atIndex:index];
+        [_encoder setVertexBuffer:buffer->mtlBuffer offset:offset atIndex:index];
     }
     if (stages & ShaderStageFlags::PixelBit) {
-        [_encoder setFragmentBuffer:buffer->mtlBuffer offset:0 atIndex:index];
+        [_encoder setFragmentBuffer:buffer->mtlBuffer offset:offset atIndex:index];
     }
     if (stages & ShaderStageFlags::TessEvalBit) {
         // todo
@@ -67,6 +67,10 @@ void MetalRenderPassCommandBuffer::setShaderTexture(TextureId textureId, uint8_t
     }
 }
 void MetalRenderPassCommandBuffer::drawIndexed(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset)
+{
+    drawIndexedInstanced(indexBufferId, indexCount, indexOffset, baseVertexOffset, 1);
+}
+void MetalRenderPassCommandBuffer::drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset, uint32_t instanceCount)
 {
     const MTLPrimitiveType primitiveType = MetalEnumAdapter::toMTL(_currentPipelineState->pipelineStateDesc.topology);
     MetalBuffer* indexBuffer = _resourceManager->GetResource<MetalBuffer>(indexBufferId);
@@ -75,9 +79,9 @@ void MetalRenderPassCommandBuffer::drawIndexed(BufferId indexBufferId, uint32_t
                           indexType:MTLIndexTypeUInt32
                         indexBuffer:indexBuffer->mtlBuffer
                   indexBufferOffset:indexOffset * sizeof(uint32_t) // has to be in bytes when using this draw call i guess
-                      instanceCount:1
+                      instanceCount:instanceCount
                          baseVertex:baseVertexOffset
-                       baseInstance:1];
+                       baseInstance:0]; // [[instance_id]] includes the base, shaders expect the first to be 0
 }
 void MetalRenderPassCommandBuffer::drawPrimitives(uint32_t startOffset, uint32_t vertexCount)
 {
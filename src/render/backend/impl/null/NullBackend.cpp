@@ -0,0 +1,30 @@
+#include "NullBackend.h"
+#include "Log.h"
+
+namespace gfx {
+
+NullSwapchain::NullSwapchain(const SwapchainDesc& desc, NullDevice* device) : Swapchain(desc), _device(device) {
+    dg_assert_nm(device != nullptr);
+    _backBuffer = _device->CreateTexture2D(desc.format, TextureUsageFlags::RenderTarget, desc.width, desc.height, nullptr, "NullBackBuffer");
+}
+
+void NullSwapchain::present(TextureId surface) {
+    dg_assert_nm(surface == _backBuffer);
+    _device->RecordPresent(surface);
+}
+
+void NullSwapchain::onSwapchainResize(uint32_t width, uint32_t height) {
+    _device->DestroyResource(_backBuffer);
+    _backBuffer = _device->CreateTexture2D(pixelFormat(), TextureUsageFlags::RenderTarget, width, height, nullptr, "NullBackBuffer");
+}
+
+NullBackend::NullBackend() : _device(new NullDevice(&_resourceManager)) {}
+
+void NullBackend::printDeviceInfo() { LOG_D("%s", "NullBackend: no GPU, commands are recorded to a trace"); }
+
+Swapchain* NullBackend::createSwapchainForWindow(const SwapchainDesc& swapchainDesc, RenderDevice* device, void* windowHandle) {
+    dg_assert_nm(device == _device.get());
+    _swapchains.emplace_back(new NullSwapchain(swapchainDesc, _device.get()));
+    return _swapchains.back().get();
+}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "NullDevice.h"
+#include "RenderBackend.h"
+#include "ResourceManager.h"
+#include "Swapchain.h"
+
+namespace gfx {
+
+// backbuffer is a plain CPU texture, present just shows up in the trace
+class NullSwapchain final : public Swapchain {
+private:
+    NullDevice* _device{nullptr};
+    TextureId   _backBuffer{NULL_ID};
+
+public:
+    NullSwapchain(const SwapchainDesc& desc, NullDevice* device);
+
+    TextureId begin() final { return _backBuffer; }
+    void      present(TextureId surface) final;
+
+protected:
+    void onSwapchainResize(uint32_t width, uint32_t height) final;
+};
+
+// Headless backend, select it with [RenderDeviceSettings] RenderDevice=null. Doesn't need a window handle
+class NullBackend final : public RenderBackend {
+private:
+    ResourceManager                             _resourceManager;
+    std::unique_ptr<NullDevice>                 _device;
+    std::vector<std::unique_ptr<NullSwapchain>> _swapchains;
+
+public:
+    NullBackend();
+
+    RenderDevice* getRenderDevice() final { return _device.get(); }
+    void          printDeviceInfo() final;
+    Swapchain*    createSwapchainForWindow(const SwapchainDesc& swapchainDesc, RenderDevice* device, void* windowHandle) final;
+};
+}
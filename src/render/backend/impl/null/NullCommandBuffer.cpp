@@ -0,0 +1,85 @@
+#include "NullCommandBuffer.h"
+#include "DGAssert.h"
+#include "NullResources.h"
+#include "ResourceManager.h"
+
+namespace gfx {
+
+void NullRenderPassCommandBuffer::reset() {
+    _pipelineState = NULL_ID;
+    _vertexBuffer  = NULL_ID;
+}
+
+// "changes" count every bind that differs from the last one in the pass, the same thing a backend would have to
+// forward to the driver
+void NullRenderPassCommandBuffer::setPipelineState(PipelineStateId pipelineState) {
+    dg_assert_nm(pipelineState != NULL_ID);
+    _stats->pipelineStateChanges += pipelineState != _pipelineState ? 1 : 0;
+    _pipelineState = pipelineState;
+    _trace->Write(TraceOp::SetPipelineState, pipelineState);
+}
+
+void NullRenderPassCommandBuffer::setVertexBuffer(BufferId vertexBuffer) {
+    _stats->vertexBufferChanges += vertexBuffer != _vertexBuffer ? 1 : 0;
+    _vertexBuffer = vertexBuffer;
+    _trace->Write(TraceOp::SetVertexBuffer, vertexBuffer);
+}
+
+void NullRenderPassCommandBuffer::setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages, uint32_t offset) {
+    dg_assert(offset % kShaderBufferOffsetAlignment == 0, "misaligned shader buffer offset %u", offset);
+    ++_stats->shaderBufferBinds;
+    _trace->Write(TraceOp::SetShaderBuffer, buffer, index, static_cast<uint32_t>(stages), offset);
+}
+
+void NullRenderPassCommandBuffer::setShaderTexture(TextureId texture, uint8_t index, ShaderStageFlags stages) {
+    ++_stats->shaderTextureBinds;
+    _trace->Write(TraceOp::SetShaderTexture, texture, index, static_cast<uint32_t>(stages));
+}
+
+void NullRenderPassCommandBuffer::drawPrimitives(uint32_t startOffset, uint32_t vertexCount) {
+    dg_assert(_pipelineState != NULL_ID, "draw without a pipeline state");
+    ++_stats->drawCalls;
+    ++_stats->instances;
+    _trace->Write(TraceOp::DrawPrimitives, startOffset, vertexCount);
+}
+
+void NullRenderPassCommandBuffer::drawIndexed(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset) {
+    dg_assert(_pipelineState != NULL_ID, "draw without a pipeline state");
+    ++_stats->drawCalls;
+    ++_stats->instances;
+    _trace->Write(TraceOp::DrawIndexed, indexBufferId, indexCount, indexOffset, baseVertexOffset);
+}
+
+void NullRenderPassCommandBuffer::drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset,
+                                                       uint32_t instanceCount) {
+    dg_assert(_pipelineState != NULL_ID, "draw without a pipeline state");
+    dg_assert_nm(instanceCount > 0);
+    ++_stats->drawCalls;
+    _stats->instances += instanceCount;
+    _trace->Write(TraceOp::DrawIndexedInstanced, indexBufferId, indexCount, indexOffset, baseVertexOffset, instanceCount);
+}
+
+NullCommandBuffer::NullCommandBuffer(ResourceManager* resourceManager, bool record) : _resourceManager(resourceManager) {
+    dg_assert_nm(resourceManager != nullptr);
+    _trace.SetEnabled(record);
+}
+
+RenderPassCommandBuffer* NullCommandBuffer::beginRenderPass(RenderPassId passId, const FrameBuffer& frameBuffer, const std::string& name) {
+    dg_assert_nm(_inPass == false);
+    dg_assert_nm(_resourceManager->GetResource<RenderPassNull>(passId) != nullptr);
+
+    _inPass = true;
+    ++_stats.renderPasses;
+    _passCmdBuf.reset();
+    _trace.Write(TraceOp::BeginRenderPass, passId, frameBuffer.colorCount, frameBuffer.color[0], frameBuffer.depth);
+    return &_passCmdBuf;
+}
+
+void NullCommandBuffer::endRenderPass(RenderPassCommandBuffer* commandBuffer) {
+    dg_assert_nm(_inPass);
+    dg_assert_nm(commandBuffer == &_passCmdBuf);
+
+    _inPass = false;
+    _trace.Write(TraceOp::EndRenderPass);
+}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include "NullTrace.h"
+#include "RenderPassCommandBuffer.h"
+
+namespace gfx {
+class ResourceManager;
+
+// Records into its own trace so command buffers can be filled on different threads, NullDevice::Submit appends them
+// to the device trace in submission order
+class NullRenderPassCommandBuffer final : public RenderPassCommandBuffer {
+private:
+    TraceWriter*    _trace{nullptr};
+    TraceStats*     _stats{nullptr};
+    PipelineStateId _pipelineState{NULL_ID};
+    BufferId        _vertexBuffer{NULL_ID};
+
+public:
+    NullRenderPassCommandBuffer(TraceWriter* trace, TraceStats* stats) : _trace(trace), _stats(stats) {}
+
+    void reset();
+
+    void setPipelineState(PipelineStateId pipelineState) final;
+    void setVertexBuffer(BufferId vertexBuffer) final;
+    void setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages, uint32_t offset) final;
+    void setShaderTexture(TextureId texture, uint8_t index, ShaderStageFlags stages) final;
+    void drawPrimitives(uint32_t startOffset, uint32_t vertexCount) final;
+    void drawIndexed(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset) final;
+    void drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset, uint32_t instanceCount) final;
+};
+
+class NullCommandBuffer final : public CommandBuffer {
+private:
+    ResourceManager*            _resourceManager{nullptr};
+    TraceWriter                 _trace;
+    TraceStats                  _stats;
+    NullRenderPassCommandBuffer _passCmdBuf{&_trace, &_stats};
+    bool                        _inPass{false};
+
+public:
+    NullCommandBuffer(ResourceManager* resourceManager, bool record);
+
+    const TraceWriter& Trace() const { return _trace; }
+    const TraceStats&  Stats() const { return _stats; }
+
+    RenderPassCommandBuffer* beginRenderPass(RenderPassId passId, const FrameBuffer& frameBuffer, const std::string& name = "") final;
+    void                     endRenderPass(RenderPassCommandBuffer* commandBuffer) final;
+};
+}
@@ -0,0 +1,175 @@
+#include "NullDevice.h"
+#include "NullCommandBuffer.h"
+#include "NullResources.h"
+
+#include <cstring>
+
+namespace gfx {
+
+NullDevice::NullDevice(ResourceManager* resourceManager) : _resourceManager(resourceManager) {
+    dg_assert_nm(resourceManager != nullptr);
+
+    DeviceConfig.DeviceAbbreviation = "Null";
+    DeviceConfig.ShaderDir          = "Null";
+    DeviceConfig.ShaderExtension    = ".null";
+}
+
+void NullDevice::RecordPresent(TextureId surface) { _trace.Write(TraceOp::Present, surface); }
+
+BufferId NullDevice::AllocateBuffer(const BufferDesc& desc, const void* initialData) {
+    BufferNull* buffer = new BufferNull();
+    buffer->desc       = desc;
+    buffer->storage.resize(desc.size);
+    if (initialData != nullptr) {
+        memcpy(buffer->storage.data(), initialData, desc.size);
+    }
+
+    BufferId id = _resourceManager->AddResource(buffer);
+    ++_stats.resourcesCreated;
+    _trace.Write(TraceOp::CreateBuffer, id, desc.size, static_cast<uint32_t>(desc.usageFlags));
+    return id;
+}
+
+// there are no shader files for this device, any function asked for just gets an id
+ShaderId NullDevice::GetShader(ShaderType type, const std::string& functionName) {
+    ShaderId shaderId = _shaderLibrary.GetShader(type, functionName);
+    return shaderId != NULL_ID ? shaderId : CreateShader(type, functionName);
+}
+
+void NullDevice::AddOrUpdateShaders(const std::vector<ShaderData>& shaderData) {
+    for (const ShaderData& data : shaderData) {
+        std::string functionName = data.name.substr(0, data.name.find_last_of('.'));
+        GetShader(ShaderType::VertexShader, functionName);
+        GetShader(ShaderType::PixelShader, functionName);
+    }
+}
+
+ShaderId NullDevice::CreateShader(ShaderType type, const std::string& functionName) {
+    ShaderNull* shader   = new ShaderNull();
+    shader->type         = type;
+    shader->functionName = functionName;
+
+    ShaderId id = _resourceManager->AddResource(shader);
+    ++_stats.resourcesCreated;
+
+    ShaderFunctionDesc desc;
+    desc.type         = type;
+    desc.functionName = functionName;
+    _shaderLibrary.AddShader(id, desc);
+
+    _trace.Write(TraceOp::CreateShader, id, static_cast<uint32_t>(type));
+    return id;
+}
+
+PipelineStateId NullDevice::CreatePipelineState(const PipelineStateDesc& desc) {
+    dg_assert_nm(desc.vertexShader != NULL_ID && desc.pixelShader != NULL_ID);
+
+    PipelineStateNull* pipelineState = new PipelineStateNull();
+    pipelineState->desc              = desc;
+
+    PipelineStateId id = _resourceManager->AddResource(pipelineState);
+    ++_stats.resourcesCreated;
+    _trace.Write(TraceOp::CreatePipelineState, id, desc.vertexShader, desc.pixelShader, desc.vertexLayout);
+    return id;
+}
+
+RenderPassId NullDevice::CreateRenderPass(const RenderPassInfo& renderPassInfo) {
+    RenderPassNull* renderPass = new RenderPassNull();
+    renderPass->info           = renderPassInfo;
+
+    RenderPassId id = _resourceManager->AddResource(renderPass);
+    ++_stats.resourcesCreated;
+    _trace.Write(TraceOp::CreateRenderPass, id, renderPassInfo.attachmentCount);
+    return id;
+}
+
+TextureId NullDevice::CreateTexture(PixelFormat format, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth) {
+    TextureNull* texture = new TextureNull();
+    texture->format      = format;
+    texture->width       = width;
+    texture->height      = height;
+    texture->depth       = depth;
+    texture->levels      = levels;
+    texture->storage.resize(static_cast<size_t>(PixelFormatByteSize(format)) * width * height * depth);
+
+    TextureId id = _resourceManager->AddResource(texture);
+    ++_stats.resourcesCreated;
+    _trace.Write(TraceOp::CreateTexture, id, static_cast<uint32_t>(format), width, height, depth);
+    return id;
+}
+
+TextureId NullDevice::CreateTexture2D(PixelFormat format, TextureUsageFlags usage, uint32_t width, uint32_t height, void* data, const std::string& debugName) {
+    TextureId id = CreateTexture(format, 1, width, height, 1);
+    if (data != nullptr) {
+        UpdateTexture(id, 0, data);
+    }
+    return id;
+}
+
+TextureId NullDevice::CreateTextureArray(PixelFormat format, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth, const std::string& debugName) {
+    return CreateTexture(format, levels, width, height, depth);
+}
+
+TextureId NullDevice::CreateTextureCube(PixelFormat format, uint32_t width, uint32_t height, void** data, const std::string& debugName) {
+    TextureId id = CreateTexture(format, 1, width, height, 6);
+    if (data != nullptr) {
+        for (uint32_t face = 0; face < 6; ++face) {
+            if (data[face] != nullptr) {
+                UpdateTexture(id, face, data[face]);
+            }
+        }
+    }
+    return id;
+}
+
+VertexLayoutId NullDevice::CreateVertexLayout(const VertexLayoutDesc& layoutDesc) {
+    VertexLayoutNull* layout = new VertexLayoutNull();
+    layout->desc             = layoutDesc;
+
+    VertexLayoutId id = _resourceManager->AddResource(layout);
+    ++_stats.resourcesCreated;
+    _trace.Write(TraceOp::CreateVertexLayout, id, layoutDesc.elements.size());
+    return id;
+}
+
+void NullDevice::DestroyResource(ResourceId resourceId) {
+    _resourceManager->DestroyResource<Resource>(resourceId);
+    _trace.Write(TraceOp::DestroyResource, resourceId);
+}
+
+void NullDevice::Submit(const std::vector<CommandBuffer*>& cmdBuffers) {
+    for (CommandBuffer* cmdBuffer : cmdBuffers) {
+        NullCommandBuffer* nullCmdBuffer = dynamic_cast<NullCommandBuffer*>(cmdBuffer);
+        dg_assert_nm(nullCmdBuffer != nullptr);
+
+        _trace.Append(nullCmdBuffer->Trace());
+        _stats.Accumulate(nullCmdBuffer->Stats());
+        delete nullCmdBuffer;
+    }
+}
+
+uint8_t* NullDevice::MapMemory(BufferId bufferId, BufferAccess) {
+    BufferNull* buffer = _resourceManager->GetResource<BufferNull>(bufferId);
+    dg_assert_nm(buffer != nullptr);
+
+    ++_stats.bufferMaps;
+    _trace.Write(TraceOp::MapBuffer, bufferId);
+    return buffer->storage.data();
+}
+
+void NullDevice::UnmapMemory(BufferId bufferId) { _trace.Write(TraceOp::UnmapBuffer, bufferId); }
+
+void NullDevice::UpdateTexture(TextureId textureId, uint32_t slice, const void* srcData) {
+    TextureNull* texture = _resourceManager->GetResource<TextureNull>(textureId);
+    dg_assert_nm(texture != nullptr && srcData != nullptr);
+    dg_assert_nm(slice < texture->depth);
+
+    size_t sliceSize = texture->storage.size() / texture->depth;
+    memcpy(texture->storage.data() + sliceSize * slice, srcData, sliceSize);
+
+    ++_stats.textureUpdates;
+    _trace.Write(TraceOp::UpdateTexture, textureId, slice);
+}
+
+CommandBuffer* NullDevice::CreateCommandBuffer() { return new NullCommandBuffer(_resourceManager, _trace.Enabled()); }
+}
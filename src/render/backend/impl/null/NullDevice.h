@@ -0,0 +1,64 @@
+#pragma once
+
+#include "NullTrace.h"
+#include "RenderDevice.h"
+#include "ResourceManager.h"
+#include "SimpleShaderLibrary.h"
+
+namespace gfx {
+
+// RenderDevice that never touches a GPU. Hands out real resource ids, keeps buffer/texture bytes in CPU memory and
+// optionally records every call into a TraceWriter, so the CPU side of rendering can be measured and checked headless.
+class NullDevice final : public RenderDevice {
+private:
+    ResourceManager*    _resourceManager{nullptr};
+    SimpleShaderLibrary _shaderLibrary;
+    TraceWriter         _trace;
+    TraceStats          _stats;
+
+public:
+    NullDevice(ResourceManager* resourceManager);
+
+    // Recording is on by default. Turn it off for pure timing runs, the stats are still kept
+    void SetRecording(bool record) { _trace.SetEnabled(record); }
+
+    // everything since the last ClearTrace/ResetStats, command buffers show up once they're submitted
+    const TraceWriter& Trace() const { return _trace; }
+    const TraceStats&  Stats() const { return _stats; }
+    void               ClearTrace() { _trace.Clear(); }
+    void               ResetStats() { _stats = TraceStats(); }
+
+    // called by NullSwapchain
+    void RecordPresent(TextureId surface);
+
+    RenderDeviceApi GetDeviceApi() final { return RenderDeviceApi::Null; }
+
+    BufferId AllocateBuffer(const BufferDesc& desc, const void* initialData) final;
+
+    ShaderId GetShader(ShaderType type, const std::string& functionName) final;
+    void     AddOrUpdateShaders(const std::vector<ShaderData>& shaderData) final;
+
+    PipelineStateId CreatePipelineState(const PipelineStateDesc& desc) final;
+    RenderPassId    CreateRenderPass(const RenderPassInfo& renderPassInfo) final;
+
+    TextureId CreateTexture2D(PixelFormat format, TextureUsageFlags usage, uint32_t width, uint32_t height, void* data, const std::string& debugName = "") final;
+    TextureId CreateTextureArray(PixelFormat format, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth, const std::string& debugName = "") final;
+    TextureId CreateTextureCube(PixelFormat format, uint32_t width, uint32_t height, void** data, const std::string& debugName = "") final;
+    VertexLayoutId CreateVertexLayout(const VertexLayoutDesc& layoutDesc) final;
+
+    void DestroyResource(ResourceId resourceId) final;
+
+    void Submit(const std::vector<CommandBuffer*>& cmdBuffers) final;
+
+    uint8_t* MapMemory(BufferId buffer, BufferAccess) final;
+    void     UnmapMemory(BufferId buffer) final;
+
+    void UpdateTexture(TextureId texture, uint32_t slice, const void* srcData) final;
+
+    CommandBuffer* CreateCommandBuffer() final;
+
+private:
+    ShaderId  CreateShader(ShaderType type, const std::string& functionName);
+    TextureId CreateTexture(PixelFormat format, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth);
+};
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "BufferDesc.h"
+#include "PipelineStateDesc.h"
+#include "PixelFormat.h"
+#include "RenderPassInfo.h"
+#include "Resource.h"
+#include "ShaderType.h"
+#include "VertexLayoutDesc.h"
+
+namespace gfx {
+
+// CPU side stand ins for GPU resources. Buffers and textures keep their bytes so MapMemory/UpdateTexture have somewhere
+// real to write and a capture can read them back.
+
+struct BufferNull : public Resource {
+    BufferDesc           desc;
+    std::vector<uint8_t> storage;
+};
+
+struct TextureNull : public Resource {
+    PixelFormat          format{PixelFormat::Invalid};
+    uint32_t             width{0};
+    uint32_t             height{0};
+    uint32_t             depth{1};
+    uint32_t             levels{1};
+    std::vector<uint8_t> storage; // first level of every slice, slice after slice
+};
+
+struct ShaderNull : public Resource {
+    ShaderType  type;
+    std::string functionName;
+};
+
+struct PipelineStateNull : public Resource {
+    PipelineStateDesc desc;
+};
+
+struct VertexLayoutNull : public Resource {
+    VertexLayoutDesc desc;
+};
+
+struct RenderPassNull : public Resource {
+    RenderPassInfo info;
+};
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace gfx {
+
+// One record per device/command buffer call: a TraceOp byte followed by that op's arguments, each written as a
+// little endian uint32. Resource ids are the device's ids so a trace can be matched against the resources that
+// were created earlier in the same trace.
+enum class TraceOp : uint8_t {
+    CreateBuffer = 0,     // id, size, usageFlags
+    CreateTexture,        // id, format, width, height, depth
+    CreatePipelineState,  // id, vertexShader, pixelShader, vertexLayout
+    CreateVertexLayout,   // id, elementCount
+    CreateRenderPass,     // id, attachmentCount
+    CreateShader,         // id, shaderType
+    DestroyResource,      // id
+    MapBuffer,            // id
+    UnmapBuffer,          // id
+    UpdateTexture,        // id, slice
+    BeginRenderPass,      // passId, colorCount, color0, depth
+    EndRenderPass,        //
+    SetPipelineState,     // id
+    SetVertexBuffer,      // id
+    SetShaderBuffer,      // id, index, stages, offset
+    SetShaderTexture,     // id, index, stages
+    DrawPrimitives,       // startOffset, vertexCount
+    DrawIndexed,          // indexBuffer, indexCount, indexOffset, baseVertexOffset
+    DrawIndexedInstanced, // indexBuffer, indexCount, indexOffset, baseVertexOffset, instanceCount
+    Present,              // surface
+    Count,
+};
+
+// what the null device saw since the last reset, ex. to check a change didn't add draws or state changes
+struct TraceStats {
+    uint32_t renderPasses{0};
+    uint32_t drawCalls{0};
+    uint32_t instances{0}; // every draw's instance count, plain draws are 1
+    uint32_t pipelineStateChanges{0};
+    uint32_t vertexBufferChanges{0};
+    uint32_t shaderBufferBinds{0};
+    uint32_t shaderTextureBinds{0};
+    uint32_t bufferMaps{0};
+    uint32_t textureUpdates{0};
+    uint32_t resourcesCreated{0};
+
+    void Accumulate(const TraceStats& other) {
+        renderPasses += other.renderPasses;
+        drawCalls += other.drawCalls;
+        instances += other.instances;
+        pipelineStateChanges += other.pipelineStateChanges;
+        vertexBufferChanges += other.vertexBufferChanges;
+        shaderBufferBinds += other.shaderBufferBinds;
+        shaderTextureBinds += other.shaderTextureBinds;
+        bufferMaps += other.bufferMaps;
+        textureUpdates += other.textureUpdates;
+        resourcesCreated += other.resourcesCreated;
+    }
+};
+
+class TraceWriter {
+private:
+    std::vector<uint8_t> _bytes;
+    bool                 _enabled{true};
+
+public:
+    template <class... Args>
+    void Write(TraceOp op, Args... args) {
+        if (!_enabled) {
+            return;
+        }
+        _bytes.push_back(static_cast<uint8_t>(op));
+        (WriteU32(static_cast<uint32_t>(args)), ...);
+    }
+
+    void Append(const TraceWriter& other) { _bytes.insert(_bytes.end(), other._bytes.begin(), other._bytes.end()); }
+
+    // keeps capacity, so recording the same frame again doesn't allocate
+    void Clear() { _bytes.clear(); }
+
+    void SetEnabled(bool enabled) { _enabled = enabled; }
+    bool Enabled() const { return _enabled; }
+
+    const std::vector<uint8_t>& Bytes() const { return _bytes; }
+
+private:
+    void WriteU32(uint32_t value) {
+        uint8_t bytes[4] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)};
+        _bytes.insert(_bytes.end(), bytes, bytes + 4);
+    }
+};
+}
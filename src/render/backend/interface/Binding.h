@@ -6,11 +6,14 @@
 
 namespace gfx {
 struct Binding {
-    enum class Type : uint8_t { ConstantBuffer, Texture };
+    // a DynamicConstantBuffer is bound at offset plus the dynamic offset its draw was queued with, so one encoded draw
+    // item can point at per frame data that moves around (TransientBufferRing)
+    enum class Type : uint8_t { ConstantBuffer, Texture, DynamicConstantBuffer };
 
     Type type{Type::ConstantBuffer};
     ResourceId resource{0};
     uint32_t slot{0};
+    uint32_t offset{0}; // bytes, constant buffers only
     ShaderStageFlags stageFlags{ShaderStageFlags::None};
 };
 }
@@ -1,12 +1,61 @@
 #pragma once
 
+#include <stdint.h>
 #include <memory>
-#include <vector>
+#include <new>
+#include <type_traits>
+#include "Binding.h"
+#include "DrawCall.h"
+#include "ResourceTypes.h"
+#include "VertexStream.h"
 
 namespace gfx {
 
-enum class DrawItemField : uint8_t { StreamCount = 0, BindingCount, DrawCall, IndexBuffer, PipelineState, VertexStreams, Bindings };
+// Everything a draw needs in one allocation, read in place:
+//   [DrawItem header][VertexStream x streamCount][Binding x bindingCount]
+// The trailing arrays start at fixed offsets from the header, so submitting an item is pointer math, no copies and no
+// allocations. Only DrawItemEncoder makes these, delete frees the whole blob.
+struct alignas(8) DrawItem {
+    DrawCall        drawCall;
+    PipelineStateId pipelineState{NULL_ID};
+    BufferId        indexBuffer{NULL_ID}; // NULL_ID unless drawCall is Indexed
+    uint32_t        byteSize{0};          // header plus both arrays
+    uint8_t         streamCount{0};
+    uint8_t         bindingCount{0};
+
+    const VertexStream* streams() const { return reinterpret_cast<const VertexStream*>(bytes() + sizeof(DrawItem)); }
+    const Binding*      bindings() const {
+        return reinterpret_cast<const Binding*>(bytes() + sizeof(DrawItem) + sizeof(VertexStream) * streamCount);
+    }
+
+    static size_t SizeFor(uint8_t streamCount, uint8_t bindingCount) {
+        return sizeof(DrawItem) + sizeof(VertexStream) * streamCount + sizeof(Binding) * bindingCount;
+    }
+
+    // arrays are left for the caller to fill through mutableStreams/mutableBindings
+    static DrawItem* Allocate(uint8_t streamCount, uint8_t bindingCount) {
+        size_t    size = SizeFor(streamCount, bindingCount);
+        DrawItem* item = new (::operator new(size)) DrawItem();
+        item->byteSize     = static_cast<uint32_t>(size);
+        item->streamCount  = streamCount;
+        item->bindingCount = bindingCount;
+        return item;
+    }
+
+    VertexStream* mutableStreams() { return const_cast<VertexStream*>(streams()); }
+    Binding*      mutableBindings() { return const_cast<Binding*>(bindings()); }
+
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
+
+private:
+    DrawItem() = default;
+
+    const uint8_t* bytes() const { return reinterpret_cast<const uint8_t*>(this); }
+};
+
+static_assert(sizeof(DrawItem) % alignof(VertexStream) == 0, "streams must start aligned");
+static_assert(sizeof(VertexStream) % alignof(Binding) == 0, "bindings must start aligned");
+static_assert(std::is_trivially_destructible<DrawItem>::value, "freed without running a destructor");
 
-struct DrawItem : public std::vector<uint8_t> {};
 using DrawItemPtr = std::shared_ptr<const DrawItem>;
 }
@@ -2,13 +2,13 @@
 #include "StateGroupEncoder.h"
 #include "StateGroupDecoder.h"
 #include "PipelineStateDesc.h"
-#include "RenderDevice.h"
 #include "VertexStream.h"
 #include <cassert>
+#include <cstring>
 
 namespace gfx {
 
-PipelineStateId GetPipelineState(gfx::RenderDevice* device, StateGroupDecoder& decoder) {
+PipelineStateId GetPipelineState(PipelineStateCache* pipelineStates, StateGroupDecoder& decoder) {
     gfx::PipelineStateDesc desc;
 
     dg_assert_nm(decoder.ReadRenderPass(&desc.renderPass));
@@ -23,32 +23,22 @@ PipelineStateId GetPipelineState(gfx::RenderDevice* device, StateGroupDecoder& d
     decoder.ReadDepthState(&desc.depthState);
     decoder.ReadPrimitiveType(&desc.topology);
 
-    PipelineStateId psId = device->CreatePipelineState(desc);
+    PipelineStateId psId = pipelineStates->Get(desc);
     assert(psId);
-
-    // TODO: This is a huge probelm, just creating pipeline states, and no way of cleaning them up
     return psId;
 }
 
-const DrawItem* DrawItemEncoder::Encode(RenderDevice* device, const DrawCall& drawCall, const std::vector<const StateGroup*>& stateGroups) {
-    return Encode(device, drawCall, stateGroups.data(), stateGroups.size());
+const DrawItem* DrawItemEncoder::Encode(PipelineStateCache* pipelineStates, const DrawCall& drawCall, const std::vector<const StateGroup*>& stateGroups) {
+    return Encode(pipelineStates, drawCall, stateGroups.data(), stateGroups.size());
 }
 
-const DrawItem* DrawItemEncoder::Encode(gfx::RenderDevice* device, const DrawCall& drawCall, const StateGroup* const* stateGroups, uint32_t count) {
-    const StateGroup* stateGroup    = nullptr;
-    bool              shouldCleanUp = false;
-
-    if (count > 1) {
-        // merge into temporary buffer
-        shouldCleanUp = true;
-        stateGroup    = StateGroupEncoder::Merge(stateGroups, count);
-    } else {
-        stateGroup = stateGroups[0];
-    }
+const DrawItem* DrawItemEncoder::Encode(PipelineStateCache* pipelineStates, const DrawCall& drawCall, const StateGroup* const* stateGroups, uint32_t count) {
+    // the merged group is only read while encoding, the frame arena holds it until the next reset
+    const StateGroup* stateGroup = StateGroupEncoder::MergeTransient(stateGroups, count);
 
     StateGroupDecoder decoder(stateGroup);
 
-    PipelineStateId pipelineState = GetPipelineState(device, decoder);
+    PipelineStateId pipelineState = GetPipelineState(pipelineStates, decoder);
     uint8_t bindingCount          = decoder.GetBindingCount();
     BufferId indexBuffer          = 0;
     uint8_t streamCount           = 1;
@@ -61,29 +51,19 @@ const DrawItem* DrawItemEncoder::Encode(gfx::RenderDevice* device, const DrawCal
         dg_assert_nm(decoder.ReadIndexBuffer(&indexBuffer));
     }
 
-    size_t drawItemSize = sizeof(uint8_t) * 2 + bindingCount * sizeof(Binding) + sizeof(DrawCall) +
-                          sizeof(PipelineStateId) + sizeof(BufferId) + sizeof(VertexStream) * streamCount;
-    DrawItem* di = new DrawItem();
-    di->resize(drawItemSize);
-
-    ByteBuffer writer(di->data(), di->size());
-
-    writer.Write(&streamCount, sizeof(uint8_t));
-    writer.Write(&bindingCount, sizeof(uint8_t));
-    writer.Write(&drawCall, sizeof(DrawCall));
-    writer.Write(&indexBuffer, sizeof(BufferId)); // 0 if no indexbuffer
-    writer.Write(&pipelineState, sizeof(PipelineStateId));
-    writer.Write(&stream, sizeof(VertexStream));
+    DrawItem* di      = DrawItem::Allocate(streamCount, bindingCount);
+    di->drawCall      = drawCall;
+    di->pipelineState = pipelineState;
+    di->indexBuffer   = indexBuffer; // 0 if no indexbuffer
+    di->mutableStreams()[0] = stream;
     if (decoder.HasState(StateGroupIndex::Bindings)) {
         int16_t bindingOffset = decoder.GetOffset(StateGroupIndex::Bindings);
         dg_assert_nm(bindingOffset != -1);
-        writer.Write(stateGroup->data() + bindingOffset, stateGroup->size() - bindingOffset);
+        dg_assert_nm(stateGroup->size() - bindingOffset == sizeof(Binding) * bindingCount);
+        // state group bindings aren't aligned, copy them out once here so Submit can read them in place
+        memcpy(di->mutableBindings(), stateGroup->data() + bindingOffset, sizeof(Binding) * bindingCount);
     }
 
-    if (shouldCleanUp) {
-        delete stateGroup;
-    }
-    
     return di;
 }
     
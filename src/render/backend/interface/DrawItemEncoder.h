@@ -7,14 +7,15 @@
 #include "Bytebuffer.h"
 #include "DrawCall.h"
 #include "DrawItem.h"
-#include "RenderDevice.h"
+#include "PipelineStateCache.h"
 #include "ResourceTypes.h"
 #include "StateGroup.h"
 
 namespace gfx {
 class DrawItemEncoder {
 public:
-    static const DrawItem* Encode(RenderDevice* device, const DrawCall& drawCall, const StateGroup* const* stateGroups, uint32_t count);
-    static const DrawItem* Encode(RenderDevice* device, const DrawCall& drawCall, const std::vector<const StateGroup*>& stateGroups);
+    // the item's pipeline state comes from (and stays owned by) pipelineStates
+    static const DrawItem* Encode(PipelineStateCache* pipelineStates, const DrawCall& drawCall, const StateGroup* const* stateGroups, uint32_t count);
+    static const DrawItem* Encode(PipelineStateCache* pipelineStates, const DrawCall& drawCall, const std::vector<const StateGroup*>& stateGroups);
 };
 }
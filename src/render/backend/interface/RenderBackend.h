@@ -16,6 +16,7 @@ namespace gfx
     class RenderBackend
     {
     public:
+        // null if the backend couldn't create a device it can render with
         virtual RenderDevice* getRenderDevice() = 0;
         virtual void printDeviceInfo() = 0;
         virtual Swapchain* createSwapchainForWindow(const SwapchainDesc& swapchainDesc, RenderDevice* device, void* windowHandle) = 0;
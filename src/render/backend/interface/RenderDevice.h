@@ -56,6 +56,8 @@ namespace gfx {
 
         virtual uint8_t* MapMemory(BufferId buffer, BufferAccess) = 0;
         virtual void UnmapMemory(BufferId buffer) = 0;
+        // only size bytes from offset were written since the map, devices that flush writes by hand can skip the rest
+        virtual void UnmapMemoryRange(BufferId buffer, size_t offset, size_t size) { UnmapMemory(buffer); }
 
         virtual void UpdateTexture(TextureId texture, uint32_t slice, const void* srcData) = 0;
                 
@@ -9,6 +9,8 @@ RenderDeviceApi ApiFromString(const std::string& apiString) {
     static constexpr std::array<const char*, glStringCount> glStrings       = {{"opengl"}};
     static constexpr size_t mtlStringCount                                  = 1;
     static constexpr std::array<const char*, mtlStringCount> mtlStrings     = {{"metal"}};
+    static constexpr size_t nullStringCount                                 = 1;
+    static constexpr std::array<const char*, nullStringCount> nullStrings   = {{"null"}};
     
     std::string lowerCase = ToLowercase(apiString);
     
@@ -30,6 +32,12 @@ RenderDeviceApi ApiFromString(const std::string& apiString) {
         }
     }
     
+    for (const char* str : nullStrings) {
+        if (lowerCase.compare(str) == 0) {
+            return RenderDeviceApi::Null;
+        }
+    }
+    
     return RenderDeviceApi::Unknown;
 }
 }
@@ -12,14 +12,21 @@
 
 namespace gfx
 {
+    // dx11.1 binds constant ranges in 16 constant (256 byte) steps, metal wants 256 for the constant address space
+    static constexpr uint32_t kShaderBufferOffsetAlignment = 256;
+
     class RenderPassCommandBuffer
     {
     public:
         virtual void setPipelineState(PipelineStateId pipelineState) = 0;
         virtual void setVertexBuffer(BufferId vertexBuffer) = 0;
-        virtual void setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages) = 0;
+        // offset is in bytes and a multiple of kShaderBufferOffsetAlignment
+        virtual void setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages, uint32_t offset) = 0;
         virtual void setShaderTexture(TextureId texture, uint8_t index, ShaderStageFlags stages) = 0;
         virtual void drawPrimitives(uint32_t startOffset, uint32_t vertexCount) = 0;
         virtual void drawIndexed(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset) = 0;
+        // instance ids count up from 0, shaders index their per instance data with it
+        virtual void drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset,
+                                          uint32_t instanceCount) = 0;
     };
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <stdint.h>
-#include <vector> 
+#include <cstddef>
+#include <new>
+#include <type_traits>
 
 namespace gfx {
 enum class StateGroupIndex : uint16_t {
@@ -46,6 +48,27 @@ struct StateGroupHeader {
     uint8_t bindingCount{0};
 };
         
-struct StateGroup : public std::vector<uint8_t> {};
-    
+// One allocation: [StateGroup][StateGroupHeader][payload]. data() is the serialized group the encoder and decoder work
+// on, header offsets are relative to it. Only StateGroupEncoder makes these: End and Merge hand out pooled groups that
+// delete puts back in the pool, transient merges live in a frame arena and must not be deleted
+struct alignas(8) StateGroup {
+    static constexpr uint8_t kTransient = 0xff;
+
+    uint64_t id{0};        // never reused, so merge caches can key on it without worrying about freed addresses
+    uint32_t byteSize{0};  // StateGroupHeader plus payload
+    uint8_t  sizeClass{0}; // pool size class, kTransient for arena groups
+
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(this) + sizeof(StateGroup); }
+    size_t         size() const { return byteSize; }
+
+    static void operator delete(StateGroup* stateGroup, std::destroying_delete_t);
+
+private:
+    friend class StateGroupEncoder;
+    StateGroup() = default;
+
+    uint8_t* mutableData() { return reinterpret_cast<uint8_t*>(this) + sizeof(StateGroup); }
+};
+
+static_assert(std::is_trivially_destructible<StateGroup>::value, "freed without running a destructor");
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <cassert>
+#include <cstring>
 #include "StateGroup.h"
 #include "Binding.h"
 #include "RasterState.h"
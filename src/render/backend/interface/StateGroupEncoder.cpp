@@ -1,9 +1,138 @@
 #include "StateGroupEncoder.h"
 #include "StateGroupDecoder.h"
-
-static constexpr size_t kMaxStateGroupPayloadSize = 512 - sizeof(gfx::StateGroupHeader);
+#include <xxhash.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "DGAssert.h"
+#include "LinearArena.h"
 
 namespace gfx {
+namespace {
+std::atomic<uint64_t> s_nextStateGroupId{1};
+
+// Persistent groups come out of power of two size classes, 64 to 1024 bytes, each with a free list carved out of 16k
+// chunks. Chunks are never given back, groups churn (terrain tiles come and go) but the working set levels off
+class StateGroupPool {
+private:
+    static constexpr size_t  kMinSlotSize = 64;
+    static constexpr uint8_t kClassCount  = 5;
+    static constexpr size_t  kChunkSize   = 16 * 1024;
+
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    std::mutex                              _mutex;
+    FreeSlot*                               _freeLists[kClassCount]{};
+    std::vector<std::unique_ptr<uint8_t[]>> _chunks;
+
+public:
+    static uint8_t SizeClassFor(size_t size) {
+        uint8_t sizeClass = 0;
+        while ((kMinSlotSize << sizeClass) < size) {
+            ++sizeClass;
+        }
+        dg_assert(sizeClass < kClassCount, "state group too big for the pool (%zu bytes)", size);
+        return sizeClass;
+    }
+
+    void* Allocate(uint8_t sizeClass) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_freeLists[sizeClass] == nullptr) {
+            size_t slotSize = kMinSlotSize << sizeClass;
+            _chunks.emplace_back(new uint8_t[kChunkSize]);
+            for (size_t offset = 0; offset + slotSize <= kChunkSize; offset += slotSize) {
+                FreeSlot* slot         = reinterpret_cast<FreeSlot*>(_chunks.back().get() + offset);
+                slot->next             = _freeLists[sizeClass];
+                _freeLists[sizeClass]  = slot;
+            }
+        }
+        FreeSlot* slot        = _freeLists[sizeClass];
+        _freeLists[sizeClass] = slot->next;
+        return slot;
+    }
+
+    void Free(void* ptr, uint8_t sizeClass) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        FreeSlot* slot        = static_cast<FreeSlot*>(ptr);
+        slot->next            = _freeLists[sizeClass];
+        _freeLists[sizeClass] = slot;
+    }
+};
+
+// never destroyed, groups held by statics can outlive it otherwise
+StateGroupPool& Pool() {
+    static StateGroupPool* pool = new StateGroupPool();
+    return *pool;
+}
+
+// Frame arena plus an open addressed table from input id stacks to merged groups. Clearing the table is bumping the
+// frame, slots from older frames count as empty
+struct TransientMerges {
+    struct Slot {
+        uint64_t          frame{0};
+        uint64_t          hash{0};
+        uint32_t          count{0};
+        uint64_t          ids[StateGroupEncoder::kMaxCachedMergeCount];
+        const StateGroup* group{nullptr};
+    };
+
+    std::mutex                        mutex;
+    LinearArena                       arena;
+    std::vector<Slot>                 slots = std::vector<Slot>(1024);
+    uint64_t                          frame{1};
+    size_t                            liveSlots{0};
+    StateGroupEncoder::TransientStats current;
+    StateGroupEncoder::TransientStats last;
+
+    // the matching slot, or the empty one the stack should go in
+    Slot* Find(const uint64_t* ids, uint32_t count, uint64_t hash) {
+        if ((liveSlots + 1) * 2 > slots.size()) {
+            Grow();
+        }
+        size_t mask = slots.size() - 1;
+        for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+            Slot& slot = slots[idx];
+            if (slot.frame != frame) {
+                return &slot;
+            }
+            if (slot.hash == hash && slot.count == count && memcmp(slot.ids, ids, sizeof(uint64_t) * count) == 0) {
+                return &slot;
+            }
+        }
+    }
+
+    void Grow() {
+        std::vector<Slot> old = std::move(slots);
+        slots.assign(old.size() * 2, Slot());
+        size_t mask = slots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.frame != frame) {
+                continue;
+            }
+            size_t idx = slot.hash & mask;
+            while (slots[idx].frame == frame) {
+                idx = (idx + 1) & mask;
+            }
+            slots[idx] = slot;
+        }
+    }
+};
+
+TransientMerges& Transient() {
+    static TransientMerges* transient = new TransientMerges();
+    return *transient;
+}
+}
+
+void StateGroup::operator delete(StateGroup* stateGroup, std::destroying_delete_t) {
+    dg_assert(stateGroup->sizeClass != kTransient, "transient state groups belong to the frame arena");
+    uint8_t sizeClass = stateGroup->sizeClass;
+    stateGroup->~StateGroup();
+    Pool().Free(stateGroup, sizeClass);
+}
+
 size_t GetStateGroupFieldSize(const StateGroupHeader& header, StateGroupIndex index) {
     switch(index) {
         case StateGroupIndex::VertexBuffer:
@@ -25,8 +154,7 @@ size_t GetStateGroupFieldSize(const StateGroupHeader& header, StateGroupIndex in
 void StateGroupEncoder::Begin(const StateGroup* inherit) {
     memset(&_currentHeader, 0, sizeof(StateGroupHeader));
     memset(&_currentHeader.offsets, -1, sizeof(int16_t) * StateGroupHeader::kMaxStateGroupFields);
-    _groupStagingBuffer.Reset();
-    _bindingStagingBuffer.clear();
+    _payloadSize = 0;
 
     if (inherit) {
         memcpy(&_currentHeader, inherit->data(), sizeof(StateGroupHeader));
@@ -41,15 +169,15 @@ void StateGroupEncoder::Begin(const StateGroup* inherit) {
         size_t bytesToCopy = inherit->size() - sizeof(StateGroupHeader);
         
         if(_currentHeader.bindingCount > 0) {
-            _bindingStagingBuffer.resize(_currentHeader.bindingCount);
-            Binding* b = _bindingStagingBuffer.data();
+            Binding* b = _bindings;
             decoder.ReadBindings(&b);
             bytesToCopy = _currentHeader.offsets[static_cast<uint16_t>(StateGroupIndex::Bindings)];
             assert(bytesToCopy != -1);
             _currentHeader.stateBitfield &= ~(AsBit(StateGroupIndex::Bindings));
             _currentHeader.payloadSizeInBytes = bytesToCopy;
         }
-        _groupStagingBuffer.Write(inherit->data() + sizeof(StateGroupHeader), bytesToCopy);
+        memcpy(_payload, inherit->data() + sizeof(StateGroupHeader), bytesToCopy);
+        _payloadSize = bytesToCopy;
     }
 }
 
@@ -62,10 +190,73 @@ const StateGroup* StateGroupEncoder::Merge(const StateGroup* const* stateGroups,
     }
 
     StateGroupEncoder encoder;
+    encoder.BeginMerge(stateGroups, count);
+    return encoder.End();
+}
+
+const StateGroup* StateGroupEncoder::MergeTransient(const StateGroup* const* stateGroups, uint32_t count) {
+    assert(stateGroups && stateGroups[0]);
+    if (count == 1) {
+        return stateGroups[0];
+    }
+
+    TransientMerges&            transient = Transient();
+    std::lock_guard<std::mutex> lock(transient.mutex);
+    ++transient.current.merges;
+
+    TransientMerges::Slot* slot = nullptr;
+    uint64_t               ids[kMaxCachedMergeCount];
+    uint64_t               hash = 0;
+    if (count <= kMaxCachedMergeCount) {
+        for (uint32_t idx = 0; idx < count; ++idx) {
+            ids[idx] = stateGroups[idx] ? stateGroups[idx]->id : 0;
+        }
+        hash = XXH3_64bits(ids, sizeof(uint64_t) * count);
+        slot = transient.Find(ids, count, hash);
+        if (slot->frame == transient.frame) {
+            ++transient.current.hits;
+            return slot->group;
+        }
+    }
+
+    StateGroupEncoder encoder;
+    encoder.BeginMerge(stateGroups, count);
+    size_t      size   = sizeof(StateGroup) + encoder.Finish();
+    StateGroup* merged = encoder.CopyTo(transient.arena.Allocate(size, alignof(StateGroup)), size, StateGroup::kTransient);
+
+    if (slot) {
+        slot->frame = transient.frame;
+        slot->hash  = hash;
+        slot->count = count;
+        slot->group = merged;
+        memcpy(slot->ids, ids, sizeof(uint64_t) * count);
+        ++transient.liveSlots;
+    }
+    return merged;
+}
+
+void StateGroupEncoder::ResetTransient() {
+    TransientMerges&            transient = Transient();
+    std::lock_guard<std::mutex> lock(transient.mutex);
+    transient.last            = transient.current;
+    transient.last.arenaBytes = transient.arena.BytesUsed();
+    transient.current         = TransientStats();
+    transient.liveSlots       = 0;
+    ++transient.frame;
+    transient.arena.Reset();
+}
+
+StateGroupEncoder::TransientStats StateGroupEncoder::GetTransientStats() {
+    TransientMerges&            transient = Transient();
+    std::lock_guard<std::mutex> lock(transient.mutex);
+    return transient.last;
+}
+
+void StateGroupEncoder::BeginMerge(const StateGroup* const* stateGroups, uint32_t count) {
     const StateGroup* primarySG = stateGroups[0];
     StateGroupDecoder primaryDecoder(primarySG);
 
-    encoder.Begin(primarySG);
+    Begin(primarySG);
     
     uint16_t openStates = ~(primaryDecoder.GetStateBitfield());
     openStates |= static_cast<uint16_t>(StateGroupBit::Bindings); // bindings is always open
@@ -95,7 +286,7 @@ const StateGroup* StateGroupEncoder::Merge(const StateGroup* const* stateGroups,
             switch (static_cast<StateGroupBit>(stateBit)) {
 #define LZY(x)                                                                                                         \
     case StateGroupBit::x: {                                                                                           \
-        encoder.WriteState(StateGroupBit::x, StateGroupIndex::x, &candidateSG->data()[header.offsets[static_cast<uint16_t>(StateGroupIndex::x)]], GetStateGroupFieldSize(header, StateGroupIndex::x));\
+        WriteState(StateGroupBit::x, StateGroupIndex::x, &candidateSG->data()[header.offsets[static_cast<uint16_t>(StateGroupIndex::x)]], GetStateGroupFieldSize(header, StateGroupIndex::x));\
         break;                                                                                                         \
     }
                 LZY(BlendState)
@@ -109,13 +300,12 @@ const StateGroup* StateGroupEncoder::Merge(const StateGroup* const* stateGroups,
                 LZY(PrimitiveType)
                 LZY(RenderPass)
                 case StateGroupBit::Bindings: {
-
-                    std::vector<Binding> bindings(header.bindingCount);
-                    Binding* ptr = bindings.data();
-                    candidateDecoder.ReadBindings(&ptr);
-
-                    for (const Binding& binding : bindings) {
-                        encoder.BindResource(binding.slot, binding.type, binding.resource, binding.stageFlags);
+                    // bindings in a serialized group aren't aligned, copy them out one at a time
+                    const uint8_t* bindings = candidateDecoder.GetPtr(StateGroupIndex::Bindings);
+                    for (uint32_t bindingIdx = 0; bindingIdx < header.bindingCount; ++bindingIdx) {
+                        Binding binding;
+                        memcpy(&binding, bindings + sizeof(Binding) * bindingIdx, sizeof(Binding));
+                        BindResource(binding);
                     }
                     break;
                 }
@@ -126,7 +316,6 @@ const StateGroup* StateGroupEncoder::Merge(const StateGroup* const* stateGroups,
             openStates |= AsBit(StateGroupIndex::Bindings);
         }
     }
-    return encoder.End();
 #undef LZY
 }
 
@@ -166,14 +355,21 @@ void StateGroupEncoder::BindTexture(uint32_t slot, TextureId tex, ShaderStageFla
 void StateGroupEncoder::BindConstantBuffer(uint32_t slot, BufferId cb, ShaderStageFlags flags) {
     BindResource(slot, Binding::Type::ConstantBuffer, cb, flags);
 }
+void StateGroupEncoder::BindDynamicConstantBuffer(uint32_t slot, BufferId cb, ShaderStageFlags flags) {
+    BindResource(slot, Binding::Type::DynamicConstantBuffer, cb, flags);
+}
 
 const StateGroup* StateGroupEncoder::End() {
-    StateGroup* sg = new StateGroup();
+    size_t size = sizeof(StateGroup) + Finish();
+    uint8_t sizeClass = StateGroupPool::SizeClassFor(size);
+    return CopyTo(Pool().Allocate(sizeClass), size, sizeClass);
+}
 
-    if (_bindingStagingBuffer.size() > 0) {
+// closes the header, returns the serialized size
+size_t StateGroupEncoder::Finish() {
+    if (_currentHeader.bindingCount > 0) {
         // TODO: pack the bindings?
-        WriteState(StateGroupBit::Bindings, StateGroupIndex::Bindings, _bindingStagingBuffer.data(),
-                   _bindingStagingBuffer.size() * sizeof(Binding));
+        WriteState(StateGroupBit::Bindings, StateGroupIndex::Bindings, _bindings, _currentHeader.bindingCount * sizeof(Binding));
     }
 
     for(uint32_t idx = 0; idx < 16; ++idx) {
@@ -182,16 +378,17 @@ const StateGroup* StateGroupEncoder::End() {
         }
     }
     
-    assert(_groupStagingBuffer.WritePos() <= kMaxStateGroupPayloadSize);
-    
-    _currentHeader.payloadSizeInBytes = _groupStagingBuffer.WritePos();
-    size_t stateGroupSize = sizeof(StateGroupHeader) + _currentHeader.payloadSizeInBytes;
-    sg->resize(stateGroupSize);
-    size_t offset = 0;
-    memcpy(sg->data() + offset, &_currentHeader, sizeof(StateGroupHeader));
-    offset += sizeof(StateGroupHeader);
-    memcpy(sg->data() + offset, _groupStagingBuffer.GetDataPtr(), _groupStagingBuffer.WritePos());
+    _currentHeader.payloadSizeInBytes = _payloadSize;
+    return sizeof(StateGroupHeader) + _payloadSize;
+}
 
+StateGroup* StateGroupEncoder::CopyTo(void* memory, size_t size, uint8_t sizeClass) {
+    StateGroup* sg = new (memory) StateGroup();
+    sg->id         = s_nextStateGroupId.fetch_add(1, std::memory_order_relaxed);
+    sg->byteSize   = static_cast<uint32_t>(size - sizeof(StateGroup));
+    sg->sizeClass  = sizeClass;
+    memcpy(sg->mutableData(), &_currentHeader, sizeof(StateGroupHeader));
+    memcpy(sg->mutableData() + sizeof(StateGroupHeader), _payload, _payloadSize);
     return sg;
 }
 
@@ -207,34 +404,33 @@ void StateGroupEncoder::BindResource(uint32_t slot, Binding::Type type, Resource
 
 void StateGroupEncoder::BindResource(const Binding& binding) {
     if (!HasBinding(binding)) {
-        ++_currentHeader.bindingCount;
-        _bindingStagingBuffer.push_back(binding);
+        dg_assert(_currentHeader.bindingCount < kMaxBindings, "too many bindings in a state group");
+        _bindings[_currentHeader.bindingCount++] = binding;
     }
 }
 void StateGroupEncoder::WriteState(StateGroupBit bit, StateGroupIndex idx, const void* data, size_t len) {
     assert(data);
     int16_t* offset = &_currentHeader.offsets[static_cast<int16_t>(idx)];
     
-    size_t padding = len % sizeof(void*);
-    
     if (!(_currentHeader.stateBitfield & static_cast<uint16_t>(bit))) {
+        size_t padding = len % sizeof(void*);
+        dg_assert(_payloadSize + len + padding <= kMaxPayloadSize, "state group payload over %zu bytes", kMaxPayloadSize);
         _currentHeader.stateBitfield |= static_cast<uint16_t>(bit);
-        *offset = _groupStagingBuffer.WritePos();
-        _groupStagingBuffer.Write((uint8_t*)data, len);
+        *offset = _payloadSize;
+        memcpy(_payload + _payloadSize, data, len);
+        memset(_payload + _payloadSize + len, 0, padding);
+        _payloadSize += len + padding;
     } else {
-        // why are we using bytebuffer anyway, its a piece of shit
-        memcpy(_groupStagingBuffer.GetDataPtr() + *offset, data, len);
+        memcpy(_payload + *offset, data, len);
     }
-    _groupStagingBuffer.WriteSkip(padding);
 }
 
 bool StateGroupEncoder::HasBinding(const Binding& binding) {
-    if (_currentHeader.bindingCount == 0) {
-        return false;
-    }
-
-    for (const Binding& activeBinding : _bindingStagingBuffer) {
-        if (memcmp(&binding, &activeBinding, sizeof(Binding)) == 0) {
+    for (uint32_t idx = 0; idx < _currentHeader.bindingCount; ++idx) {
+        const Binding& activeBinding = _bindings[idx];
+        // field by field, padding in bindings copied out of groups is whatever was there
+        if (activeBinding.type == binding.type && activeBinding.resource == binding.resource && activeBinding.slot == binding.slot &&
+            activeBinding.offset == binding.offset && activeBinding.stageFlags == binding.stageFlags) {
             return true;
         }
     }
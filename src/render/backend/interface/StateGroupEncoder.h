@@ -1,28 +1,50 @@
 #pragma once
 
 #include <stdint.h>
+#include <cassert>
 #include "StateGroup.h"
 #include "Binding.h"
 #include "RasterState.h"
 #include "BlendState.h"
 #include "DepthState.h"
-#include "Bytebuffer.h"
 #include "PrimitiveType.h"
 #include "ShaderStageFlags.h"
+#include <vector>
 
 namespace gfx {
 class StateGroupEncoder {
-private:
-    static constexpr size_t kStagingBufferSize = 256;
+public:
+    static constexpr size_t   kMaxStateGroupSize   = 512;
+    static constexpr size_t   kMaxPayloadSize      = kMaxStateGroupSize - sizeof(StateGroupHeader);
+    static constexpr size_t   kMaxBindings         = kMaxPayloadSize / sizeof(Binding);
+    static constexpr uint32_t kMaxCachedMergeCount = 8;
 
-    StateGroupHeader     _currentHeader;
-    ByteBuffer           _groupStagingBuffer;
-    std::vector<Binding> _bindingStagingBuffer;
+    // last frame's transient merges
+    struct TransientStats {
+        uint64_t merges{0};
+        uint64_t hits{0};
+        size_t   arenaBytes{0};
+    };
+
+private:
+    // staging lives in the encoder so an encoder on the stack never touches the heap
+    StateGroupHeader _currentHeader;
+    uint8_t          _payload[kMaxPayloadSize];
+    size_t           _payloadSize{0};
+    Binding          _bindings[kMaxBindings];
 
 public:
+    // persistent merge, the result is pooled and owned by the caller
     static const StateGroup* Merge(const StateGroup* const* stateGroups, uint32_t count);
     static const StateGroup* Merge(const std::vector<const StateGroup*>& stateGroups);
 
+    // merge that only has to last until ResetTransient, for encoding draw items. Results are allocated from a frame
+    // arena and cached on the ids of the input stack, so the same stack merged again in a frame is a lookup.
+    // Thread safe, but ResetTransient must only be called between frames when nothing is encoding
+    static const StateGroup* MergeTransient(const StateGroup* const* stateGroups, uint32_t count);
+    static void              ResetTransient();
+    static TransientStats    GetTransientStats();
+
     void Begin(const StateGroup* inherit = nullptr);
     const StateGroup* End();
 
@@ -38,6 +60,8 @@ public:
     void SetDepthState(const DepthState& ds);
     void BindTexture(uint32_t slot, TextureId tex, ShaderStageFlags flags = ShaderStageFlags::AllStages);
     void BindConstantBuffer(uint32_t slot, BufferId cb, ShaderStageFlags flags = ShaderStageFlags::AllStages);
+    // cb at whatever offset the draw gets queued with, one per draw item
+    void BindDynamicConstantBuffer(uint32_t slot, BufferId cb, ShaderStageFlags flags = ShaderStageFlags::AllStages);
     void BindResource(uint32_t slot, Binding::Type type, ResourceId resource,
                       ShaderStageFlags flags = ShaderStageFlags::AllStages);
     void BindResource(const Binding& binding);
@@ -45,5 +69,8 @@ public:
 private:
     void WriteState(StateGroupBit bit, StateGroupIndex idx, const void* data, size_t len);
     bool HasBinding(const Binding& binding);
+    void BeginMerge(const StateGroup* const* stateGroups, uint32_t count);
+    size_t Finish();
+    StateGroup* CopyTo(void* memory, size_t size, uint8_t sizeClass);
 };
 }
@@ -59,7 +59,7 @@ struct VertexLayoutElement {
         return (type == b.type) && (usage == b.usage) && (storage == b.storage);
     }
     inline bool operator!=(const VertexLayoutElement& b) const {
-        return (type != b.type) || (usage != b.usage) || (storage == b.storage);
+        return (type != b.type) || (usage != b.usage) || (storage != b.storage);
     }
 
     bool operator()(const VertexLayoutElement& l, const VertexLayoutElement& r) const {
@@ -18,4 +18,28 @@ enum class PixelFormat : uint8_t {
     Depth32FloatStencil8,
     Count,
 };
+
+// bytes per pixel of the first mip, 0 for formats that have no fixed size
+inline uint32_t PixelFormatByteSize(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::R8Unorm:
+        case PixelFormat::R8Uint:
+            return 1;
+        case PixelFormat::RGB8Unorm:
+            return 3;
+        case PixelFormat::RGBA8Unorm:
+        case PixelFormat::BGRA8Unorm:
+        case PixelFormat::R32Float:
+        case PixelFormat::Depth32Float:
+            return 4;
+        case PixelFormat::Depth32FloatStencil8:
+            return 8;
+        case PixelFormat::RGB32Float:
+            return 12;
+        case PixelFormat::RGBA32Float:
+            return 16;
+        default:
+            return 0;
+    }
+}
 }
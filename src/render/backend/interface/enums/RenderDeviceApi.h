@@ -5,7 +5,7 @@
 
 namespace gfx {
     
-enum class RenderDeviceApi : uint8_t { Unknown = 0, OpenGL, Metal, D3D11 };
+enum class RenderDeviceApi : uint8_t { Unknown = 0, OpenGL, Metal, D3D11, Null };
 RenderDeviceApi ApiFromString(const std::string& apiString);
 
 }
@@ -0,0 +1,64 @@
+#include "CaptureCommands.h"
+#include <chrono>
+#include <cstdio>
+#include "CaptureDevice.h"
+#include "ConsoleCommands.h"
+#include "File.h"
+#include "FrameReplayer.h"
+
+namespace gfx {
+namespace capture {
+
+std::string ReplayCapture(RenderDevice* device, const std::string& path, uint32_t frames) {
+    using Clock = std::chrono::high_resolution_clock;
+
+    FrameReplayer replayer(device);
+    Clock::time_point start = Clock::now();
+    if (!replayer.Load(path)) {
+        return "couldn't load capture " + path;
+    }
+    double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // first replay creates whatever the frame itself created, keep it out of the average
+    replayer.ReplayFrame();
+
+    start = Clock::now();
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        replayer.ReplayFrame();
+    }
+    double replayMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    char summary[256];
+    snprintf(summary, sizeof(summary), "%s: %zu resources, %llu draws/frame, load %.2fms, %u frames %.3fms/frame", path.c_str(), replayer.ResourceCount(),
+             static_cast<unsigned long long>(replayer.DrawCount()), loadMs, frames, frames > 0 ? replayMs / frames : 0.0);
+    return summary;
+}
+
+void RegisterConsoleCommands(RenderDevice* device) {
+    // params[0] is the command itself, when there are params at all
+    config::ConsoleCommands::getInstance().RegisterCommand("capture", [device](const std::vector<std::string>& params) -> std::string {
+        CaptureDevice* captureDevice = dynamic_cast<CaptureDevice*>(device);
+        if (captureDevice == nullptr) {
+            return "capture is off, set [RenderDeviceSettings] Capture=y";
+        }
+
+        std::string path = params.size() > 1 ? params[1] : fs::AppendPathProcessDir("/frame.plcap");
+        captureDevice->RequestCapture(path);
+        return "capturing next frame to " + path;
+    });
+
+    config::ConsoleCommands::getInstance().RegisterCommand("replay", [device](const std::vector<std::string>& params) -> std::string {
+        if (params.size() < 2) {
+            return "usage: /replay <path> [frames]";
+        }
+
+        // replaying through the capture device would just shadow the replay's own resources
+        CaptureDevice* captureDevice = dynamic_cast<CaptureDevice*>(device);
+        RenderDevice*  target        = captureDevice != nullptr ? captureDevice->inner() : device;
+
+        uint32_t frames = params.size() > 2 ? static_cast<uint32_t>(std::stoul(params[2])) : 100;
+        return ReplayCapture(target, params[1], frames);
+    });
+}
+}
+}
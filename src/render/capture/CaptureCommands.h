@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include "RenderDevice.h"
+
+namespace gfx {
+namespace capture {
+
+// '/capture [path]' writes the next frame out (needs [RenderDeviceSettings] Capture=y), '/replay <path> [frames]'
+// plays a capture back on the running device and reports the cost per frame
+void RegisterConsoleCommands(RenderDevice* device);
+
+// load, replay frames times and unload. Returns a one line summary, shared with planet-replay
+std::string ReplayCapture(RenderDevice* device, const std::string& path, uint32_t frames);
+}
+}
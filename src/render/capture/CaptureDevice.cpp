@@ -0,0 +1,323 @@
+#include "CaptureDevice.h"
+#include "DGAssert.h"
+#include "Log.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace gfx {
+using namespace capture;
+
+void CaptureRenderPassCommandBuffer::setPipelineState(PipelineStateId pipelineState) {
+    _writer->Write(CaptureOp::SetPipelineState, IdRecord{pipelineState});
+    _inner->setPipelineState(pipelineState);
+}
+
+void CaptureRenderPassCommandBuffer::setVertexBuffer(BufferId vertexBuffer) {
+    _writer->Write(CaptureOp::SetVertexBuffer, IdRecord{vertexBuffer});
+    _inner->setVertexBuffer(vertexBuffer);
+}
+
+void CaptureRenderPassCommandBuffer::setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages, uint32_t offset) {
+    _writer->Write(CaptureOp::SetShaderBuffer, ShaderBindingRecord{buffer, index, stages, offset});
+    _inner->setShaderBuffer(buffer, index, stages, offset);
+}
+
+void CaptureRenderPassCommandBuffer::setShaderTexture(TextureId texture, uint8_t index, ShaderStageFlags stages) {
+    _writer->Write(CaptureOp::SetShaderTexture, ShaderBindingRecord{texture, index, stages});
+    _inner->setShaderTexture(texture, index, stages);
+}
+
+void CaptureRenderPassCommandBuffer::drawPrimitives(uint32_t startOffset, uint32_t vertexCount) {
+    _writer->Write(CaptureOp::DrawPrimitives, DrawPrimitivesRecord{startOffset, vertexCount});
+    _inner->drawPrimitives(startOffset, vertexCount);
+}
+
+void CaptureRenderPassCommandBuffer::drawIndexed(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset) {
+    _writer->Write(CaptureOp::DrawIndexed, DrawIndexedRecord{indexBufferId, indexCount, indexOffset, baseVertexOffset});
+    _inner->drawIndexed(indexBufferId, indexCount, indexOffset, baseVertexOffset);
+}
+
+void CaptureRenderPassCommandBuffer::drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset,
+                                                          uint32_t instanceCount) {
+    _writer->Write(CaptureOp::DrawIndexedInstanced, DrawIndexedInstancedRecord{indexBufferId, indexCount, indexOffset, baseVertexOffset, instanceCount});
+    _inner->drawIndexedInstanced(indexBufferId, indexCount, indexOffset, baseVertexOffset, instanceCount);
+}
+
+CaptureCommandBuffer::CaptureCommandBuffer(CommandBuffer* inner) : _inner(inner) { dg_assert_nm(inner != nullptr); }
+
+RenderPassCommandBuffer* CaptureCommandBuffer::beginRenderPass(RenderPassId passId, const FrameBuffer& frameBuffer, const std::string& name) {
+    dg_assert_nm(_passCmdBuf.inner() == nullptr);
+    _writer.Write(CaptureOp::BeginRenderPass, BeginRenderPassRecord{passId, frameBuffer});
+    _passCmdBuf.setInner(_inner->beginRenderPass(passId, frameBuffer, name));
+    return &_passCmdBuf;
+}
+
+void CaptureCommandBuffer::endRenderPass(RenderPassCommandBuffer* commandBuffer) {
+    dg_assert_nm(commandBuffer == &_passCmdBuf);
+    _inner->endRenderPass(_passCmdBuf.inner());
+    _passCmdBuf.setInner(nullptr);
+    _writer.Write(CaptureOp::EndRenderPass);
+}
+
+CaptureDevice::CaptureDevice(RenderDevice* device) : _device(device) {
+    dg_assert_nm(device != nullptr);
+    // shader cache reads these to find the wrapped device's shaders
+    DeviceConfig = device->DeviceConfig;
+}
+
+void CaptureDevice::RequestCapture(const std::string& path) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pendingPath = path;
+}
+
+bool CaptureDevice::CapturePending() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capturing || !_pendingPath.empty();
+}
+
+template <typename Body>
+void CaptureDevice::AddResource(ResourceId id, CaptureOp op, const Body& body, const void* contents, size_t contentsSize) {
+    static_assert(std::is_trivially_copyable<Body>::value, "capture records are copied raw");
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ShadowResource&             resource = _resources[id];
+    resource.createOp                    = op;
+    resource.body.resize(sizeof(Body));
+    memcpy(resource.body.data(), &body, sizeof(Body));
+    resource.contents.assign(static_cast<const uint8_t*>(contents), static_cast<const uint8_t*>(contents) + contentsSize);
+
+    // created mid capture, replay creates it where it happened
+    if (_capturing) {
+        _writer.Write(op, body, contents, contentsSize);
+    }
+}
+
+BufferId CaptureDevice::AllocateBuffer(const BufferDesc& desc, const void* initialData) {
+    BufferId id = _device->AllocateBuffer(desc, initialData);
+
+    CreateBufferRecord record{id, desc.size, desc.usageFlags, desc.accessFlags, desc.lifetime, static_cast<uint8_t>(desc.isDynamic)};
+    if (initialData != nullptr) {
+        AddResource(id, CaptureOp::CreateBuffer, record, initialData, desc.size);
+    } else {
+        std::vector<uint8_t> zeroes(desc.size, 0);
+        AddResource(id, CaptureOp::CreateBuffer, record, zeroes.data(), zeroes.size());
+    }
+    return id;
+}
+
+ShaderId CaptureDevice::GetShader(ShaderType type, const std::string& functionName) {
+    ShaderId id = _device->GetShader(type, functionName);
+    if (id == NULL_ID) {
+        return id;
+    }
+
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        known = _resources.find(id) != _resources.end();
+    }
+    if (!known) {
+        AddResource(id, CaptureOp::CreateShader, CreateShaderRecord{id, type}, functionName.data(), functionName.size());
+    }
+    return id;
+}
+
+PipelineStateId CaptureDevice::CreatePipelineState(const PipelineStateDesc& desc) {
+    PipelineStateId id = _device->CreatePipelineState(desc);
+    AddResource(id, CaptureOp::CreatePipelineState, CreatePipelineStateRecord{id, desc}, nullptr, 0);
+    return id;
+}
+
+RenderPassId CaptureDevice::CreateRenderPass(const RenderPassInfo& renderPassInfo) {
+    RenderPassId id = _device->CreateRenderPass(renderPassInfo);
+    AddResource(id, CaptureOp::CreateRenderPass, CreateRenderPassRecord{id, renderPassInfo}, nullptr, 0);
+    return id;
+}
+
+// texture contents start empty and only get allocated by the first upload, render targets never pay for them
+void CaptureDevice::AddTexture(TextureId id, TextureKind kind, PixelFormat format, TextureUsageFlags usage, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth) {
+    AddResource(id, CaptureOp::CreateTexture, CreateTextureRecord{id, kind, format, usage, levels, width, height, depth}, nullptr, 0);
+}
+
+TextureId CaptureDevice::CreateTexture2D(PixelFormat format, TextureUsageFlags usage, uint32_t width, uint32_t height, void* data, const std::string& debugName) {
+    TextureId id = _device->CreateTexture2D(format, usage, width, height, data, debugName);
+    AddTexture(id, TextureKind::Texture2D, format, usage, 1, width, height, 1);
+    if (data != nullptr) {
+        ShadowTextureSlice(id, 0, data);
+    }
+    return id;
+}
+
+TextureId CaptureDevice::CreateTextureArray(PixelFormat format, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth, const std::string& debugName) {
+    TextureId id = _device->CreateTextureArray(format, levels, width, height, depth, debugName);
+    AddTexture(id, TextureKind::Array, format, TextureUsageFlags::ShaderRead, levels, width, height, depth);
+    return id;
+}
+
+TextureId CaptureDevice::CreateTextureCube(PixelFormat format, uint32_t width, uint32_t height, void** data, const std::string& debugName) {
+    TextureId id = _device->CreateTextureCube(format, width, height, data, debugName);
+    AddTexture(id, TextureKind::Cube, format, TextureUsageFlags::ShaderRead, 1, width, height, 6);
+    if (data != nullptr) {
+        for (uint32_t face = 0; face < 6; ++face) {
+            if (data[face] != nullptr) {
+                ShadowTextureSlice(id, face, data[face]);
+            }
+        }
+    }
+    return id;
+}
+
+VertexLayoutId CaptureDevice::CreateVertexLayout(const VertexLayoutDesc& layoutDesc) {
+    VertexLayoutId id = _device->CreateVertexLayout(layoutDesc);
+    AddResource(id, CaptureOp::CreateVertexLayout, CreateVertexLayoutRecord{id}, layoutDesc.elements.data(), layoutDesc.elements.size() * sizeof(VertexLayoutElement));
+    return id;
+}
+
+void CaptureDevice::DestroyResource(ResourceId resourceId) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _resources.erase(resourceId);
+        _mappedBuffers.erase(resourceId);
+        if (_capturing) {
+            _writer.Write(CaptureOp::DestroyResource, IdRecord{resourceId});
+        }
+    }
+    _device->DestroyResource(resourceId);
+}
+
+uint8_t* CaptureDevice::MapMemory(BufferId buffer, BufferAccess access) {
+    uint8_t* data = _device->MapMemory(buffer, access);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _mappedBuffers[buffer] = MappedBuffer{data, access};
+    return data;
+}
+
+void CaptureDevice::UnmapMemory(BufferId buffer) {
+    ShadowMappedBuffer(buffer);
+    _device->UnmapMemory(buffer);
+}
+
+void CaptureDevice::UnmapMemoryRange(BufferId buffer, size_t offset, size_t size) {
+    ShadowMappedBuffer(buffer);
+    _device->UnmapMemoryRange(buffer, offset, size);
+}
+
+// the mapped range is copied whole even when the caller says what it wrote, the replay updates whole buffers
+void CaptureDevice::ShadowMappedBuffer(BufferId buffer) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        mappedIt   = _mappedBuffers.find(buffer);
+    auto                        resourceIt = _resources.find(buffer);
+    if (mappedIt != _mappedBuffers.end() && resourceIt != _resources.end()) {
+        const MappedBuffer& mapped = mappedIt->second;
+        if (mapped.data != nullptr && mapped.access != BufferAccess::Read) {
+            std::vector<uint8_t>& contents = resourceIt->second.contents;
+            memcpy(contents.data(), mapped.data, contents.size());
+            if (_capturing) {
+                _writer.Write(CaptureOp::UpdateBuffer, UpdateBufferRecord{buffer, mapped.access}, contents.data(), contents.size());
+            }
+        }
+        _mappedBuffers.erase(mappedIt);
+    }
+}
+
+void CaptureDevice::UpdateTexture(TextureId texture, uint32_t slice, const void* srcData) {
+    _device->UpdateTexture(texture, slice, srcData);
+    ShadowTextureSlice(texture, slice, srcData);
+}
+
+void CaptureDevice::ShadowTextureSlice(TextureId texture, uint32_t slice, const void* srcData) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        it = _resources.find(texture);
+    if (it == _resources.end()) {
+        return;
+    }
+
+    ShadowResource&            resource = it->second;
+    const CreateTextureRecord* record   = reinterpret_cast<const CreateTextureRecord*>(resource.body.data());
+    size_t                     sliceSize = static_cast<size_t>(PixelFormatByteSize(record->format)) * record->width * record->height;
+    dg_assert_nm(slice < record->depth);
+
+    resource.contents.resize(sliceSize * record->depth, 0);
+    memcpy(resource.contents.data() + sliceSize * slice, srcData, sliceSize);
+    if (_capturing) {
+        _writer.Write(CaptureOp::UpdateTexture, UpdateTextureRecord{texture, slice}, srcData, sliceSize);
+    }
+}
+
+CommandBuffer* CaptureDevice::CreateCommandBuffer() {
+    CommandBuffer* cmdBuffer = _device->CreateCommandBuffer();
+    if (cmdBuffer == nullptr || !CapturePending()) {
+        return cmdBuffer;
+    }
+    return new CaptureCommandBuffer(cmdBuffer);
+}
+
+// frames end at Submit: a capture starts right after the one that saw the request and is written at the next
+void CaptureDevice::Submit(const std::vector<CommandBuffer*>& cmdBuffers) {
+    std::vector<CommandBuffer*> innerBuffers;
+    innerBuffers.reserve(cmdBuffers.size());
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (CommandBuffer* cmdBuffer : cmdBuffers) {
+            CaptureCommandBuffer* captureCmdBuffer = dynamic_cast<CaptureCommandBuffer*>(cmdBuffer);
+            if (captureCmdBuffer == nullptr) {
+                innerBuffers.push_back(cmdBuffer);
+                continue;
+            }
+
+            if (_capturing) {
+                _writer.Write(CaptureOp::BeginCommandBuffer);
+                _writer.Append(captureCmdBuffer->writer());
+            }
+            innerBuffers.push_back(captureCmdBuffer->inner());
+            delete captureCmdBuffer;
+        }
+
+        if (_capturing) {
+            _writer.Write(CaptureOp::Submit);
+        }
+    }
+
+    _device->Submit(innerBuffers);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_capturing) {
+        FinishCapture();
+    } else if (!_pendingPath.empty()) {
+        StartCapture();
+    }
+}
+
+void CaptureDevice::StartCapture() {
+    _writer.Clear();
+    for (const auto& pair : _resources) {
+        const ShadowResource& resource = pair.second;
+        _writer.WriteRaw(resource.createOp, resource.body.data(), resource.body.size(), resource.contents.data(), resource.contents.size());
+    }
+    _writer.Write(CaptureOp::FrameBegin);
+
+    _capturePath = _pendingPath;
+    _pendingPath.clear();
+    _capturing = true;
+}
+
+void CaptureDevice::FinishCapture() {
+    _capturing = false;
+
+    FileHeader header;
+    header.recordCount = _writer.RecordCount();
+
+    std::ofstream out(_capturePath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    out.write(reinterpret_cast<const char*>(_writer.Bytes().data()), _writer.Bytes().size());
+    if (out.fail()) {
+        LOG_E("capture: failed writing %s", _capturePath.c_str());
+    } else {
+        LOG_D("capture: wrote %llu records (%zu bytes) to %s", static_cast<unsigned long long>(header.recordCount), _writer.Bytes().size(), _capturePath.c_str());
+    }
+    _writer.Clear();
+}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CaptureFormat.h"
+#include "CommandBuffer.h"
+#include "RenderDevice.h"
+#include "RenderPassCommandBuffer.h"
+
+namespace gfx {
+
+class CaptureRenderPassCommandBuffer final : public RenderPassCommandBuffer {
+private:
+    capture::CaptureWriter*  _writer{nullptr};
+    RenderPassCommandBuffer* _inner{nullptr};
+
+public:
+    CaptureRenderPassCommandBuffer(capture::CaptureWriter* writer) : _writer(writer) {}
+
+    RenderPassCommandBuffer* inner() const { return _inner; }
+    void                     setInner(RenderPassCommandBuffer* inner) { _inner = inner; }
+
+    void setPipelineState(PipelineStateId pipelineState) final;
+    void setVertexBuffer(BufferId vertexBuffer) final;
+    void setShaderBuffer(BufferId buffer, uint8_t index, ShaderStageFlags stages, uint32_t offset) final;
+    void setShaderTexture(TextureId texture, uint8_t index, ShaderStageFlags stages) final;
+    void drawPrimitives(uint32_t startOffset, uint32_t vertexCount) final;
+    void drawIndexed(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset) final;
+    void drawIndexedInstanced(BufferId indexBufferId, uint32_t indexCount, uint32_t indexOffset, uint32_t baseVertexOffset, uint32_t instanceCount) final;
+};
+
+// Only handed out while a capture is running, records into its own writer so command buffers can still be filled on
+// different threads. CaptureDevice::Submit unwraps it
+class CaptureCommandBuffer final : public CommandBuffer {
+private:
+    CommandBuffer*                 _inner{nullptr};
+    capture::CaptureWriter         _writer;
+    CaptureRenderPassCommandBuffer _passCmdBuf{&_writer};
+
+public:
+    CaptureCommandBuffer(CommandBuffer* inner);
+
+    CommandBuffer*                inner() const { return _inner; }
+    const capture::CaptureWriter& writer() const { return _writer; }
+
+    RenderPassCommandBuffer* beginRenderPass(RenderPassId passId, const FrameBuffer& frameBuffer, const std::string& name = "") final;
+    void                     endRenderPass(RenderPassCommandBuffer* commandBuffer) final;
+};
+
+// Wraps a real device and forwards everything to it. On the side it keeps a CPU copy of every live resource (creation
+// desc plus buffer/texture contents) so that at any frame boundary it can write out the state needed to rebuild that
+// frame, followed by the frame's own updates and command stream. See CaptureFormat.h and FrameReplayer.
+//
+// Turn it on with [RenderDeviceSettings] Capture=y. The shadow copies double resource memory and every unmap pays a
+// read back of the mapped range, so it stays off otherwise.
+class CaptureDevice final : public RenderDevice {
+private:
+    struct ShadowResource {
+        capture::CaptureOp   createOp;
+        std::vector<uint8_t> body;     // create record, as written to the file
+        std::vector<uint8_t> contents; // create payload: buffer/texture bytes, shader name or layout elements
+    };
+
+    struct MappedBuffer {
+        uint8_t*     data{nullptr};
+        BufferAccess access{BufferAccess::Write};
+    };
+
+    RenderDevice* _device{nullptr};
+
+    std::mutex                                 _mutex;
+    std::map<ResourceId, ShadowResource>       _resources; // ordered so a snapshot recreates in id order
+    std::unordered_map<BufferId, MappedBuffer> _mappedBuffers;
+
+    capture::CaptureWriter _writer;
+    std::string            _pendingPath;
+    std::string            _capturePath;
+    bool                   _capturing{false};
+
+public:
+    CaptureDevice(RenderDevice* device);
+
+    RenderDevice* inner() const { return _device; }
+
+    // captures the next whole frame, written out at the Submit that ends it
+    void RequestCapture(const std::string& path);
+    bool CapturePending();
+
+    RenderDeviceApi GetDeviceApi() final { return _device->GetDeviceApi(); }
+
+    BufferId AllocateBuffer(const BufferDesc& desc, const void* initialData) final;
+
+    ShaderId GetShader(ShaderType type, const std::string& functionName) final;
+    void     AddOrUpdateShaders(const std::vector<ShaderData>& shaderData) final { _device->AddOrUpdateShaders(shaderData); }
+
+    PipelineStateId CreatePipelineState(const PipelineStateDesc& desc) final;
+    RenderPassId    CreateRenderPass(const RenderPassInfo& renderPassInfo) final;
+
+    TextureId CreateTexture2D(PixelFormat format, TextureUsageFlags usage, uint32_t width, uint32_t height, void* data, const std::string& debugName = "") final;
+    TextureId CreateTextureArray(PixelFormat format, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth, const std::string& debugName = "") final;
+    TextureId CreateTextureCube(PixelFormat format, uint32_t width, uint32_t height, void** data, const std::string& debugName = "") final;
+    VertexLayoutId CreateVertexLayout(const VertexLayoutDesc& layoutDesc) final;
+
+    void DestroyResource(ResourceId resourceId) final;
+
+    void Submit(const std::vector<CommandBuffer*>& cmdBuffers) final;
+
+    uint8_t* MapMemory(BufferId buffer, BufferAccess access) final;
+    void     UnmapMemory(BufferId buffer) final;
+    void     UnmapMemoryRange(BufferId buffer, size_t offset, size_t size) final;
+
+    void UpdateTexture(TextureId texture, uint32_t slice, const void* srcData) final;
+
+    CommandBuffer* CreateCommandBuffer() final;
+
+private:
+    template <typename Body>
+    void AddResource(ResourceId id, capture::CaptureOp op, const Body& body, const void* contents, size_t contentsSize);
+    void AddTexture(TextureId id, capture::TextureKind kind, PixelFormat format, TextureUsageFlags usage, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth);
+    void ShadowTextureSlice(TextureId texture, uint32_t slice, const void* srcData);
+    void ShadowMappedBuffer(BufferId buffer);
+
+    void StartCapture();
+    void FinishCapture();
+};
+}
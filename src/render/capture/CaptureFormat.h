@@ -0,0 +1,271 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "BufferAccess.h"
+#include "BufferDesc.h"
+#include "DGAssert.h"
+#include "Framebuffer.h"
+#include "PipelineStateDesc.h"
+#include "PixelFormat.h"
+#include "RenderPassInfo.h"
+#include "ShaderStageFlags.h"
+#include "ShaderType.h"
+#include "TextureUsage.h"
+#include "VertexLayoutDesc.h"
+
+namespace gfx {
+namespace capture {
+
+// A capture file is a FileHeader followed by records. Every record is a RecordHeader, a fixed size body struct and an
+// optional payload, padded out to 8 bytes so the whole thing can be read in place from a mapped file.
+//
+// Records up to FrameBegin recreate everything that was alive when the capture started, records after it are the
+// frame itself: buffer/texture updates plus command buffers in submission order. Ids in the file are the ids the
+// capturing device handed out, the replayer remaps them. Bodies are raw structs so files only replay on a build with
+// the same layout, bump kVersion when any of them change.
+
+static constexpr uint32_t kMagic   = 0x46434c50; // "PLCF"
+static constexpr uint32_t kVersion = 3;
+
+enum class CaptureOp : uint16_t {
+    CreateBuffer = 0,
+    CreateTexture,
+    CreateShader,
+    CreateVertexLayout,
+    CreateRenderPass,
+    CreatePipelineState,
+    DestroyResource,
+    FrameBegin,
+    UpdateBuffer,
+    UpdateTexture,
+    BeginCommandBuffer,
+    BeginRenderPass,
+    EndRenderPass,
+    SetPipelineState,
+    SetVertexBuffer,
+    SetShaderBuffer,
+    SetShaderTexture,
+    DrawPrimitives,
+    DrawIndexed,
+    DrawIndexedInstanced,
+    Submit,
+    Count,
+};
+
+struct FileHeader {
+    uint32_t magic{kMagic};
+    uint32_t version{kVersion};
+    uint64_t recordCount{0};
+};
+
+struct RecordHeader {
+    CaptureOp op;
+    uint16_t  reserved{0};
+    uint32_t  bodySize{0};
+    uint64_t  payloadSize{0};
+};
+
+enum class TextureKind : uint8_t { Texture2D = 0, Array, Cube };
+
+// payload: desc.size bytes of contents
+struct CreateBufferRecord {
+    uint64_t          id;
+    uint64_t          size;
+    BufferUsageFlags  usageFlags;
+    BufferAccessFlags accessFlags;
+    BufferLifetime    lifetime;
+    uint8_t           isDynamic;
+};
+
+// payload: every slice, slice after slice. Empty when nothing was ever uploaded (render targets)
+struct CreateTextureRecord {
+    uint64_t          id;
+    TextureKind       kind;
+    PixelFormat       format;
+    TextureUsageFlags usage;
+    uint32_t          levels;
+    uint32_t          width;
+    uint32_t          height;
+    uint32_t          depth;
+};
+
+// payload: function name, not terminated
+struct CreateShaderRecord {
+    uint64_t   id;
+    ShaderType type;
+};
+
+// payload: VertexLayoutElement array
+struct CreateVertexLayoutRecord {
+    uint64_t id;
+};
+
+struct CreateRenderPassRecord {
+    uint64_t       id;
+    RenderPassInfo info;
+};
+
+struct CreatePipelineStateRecord {
+    uint64_t          id;
+    PipelineStateDesc desc;
+};
+
+// also SetPipelineState, SetVertexBuffer and DestroyResource
+struct IdRecord {
+    uint64_t id;
+};
+
+// payload: the whole buffer as it was at unmap
+struct UpdateBufferRecord {
+    uint64_t     id;
+    BufferAccess access;
+};
+
+// payload: one slice
+struct UpdateTextureRecord {
+    uint64_t id;
+    uint32_t slice;
+};
+
+struct BeginRenderPassRecord {
+    uint64_t    passId;
+    FrameBuffer frameBuffer;
+};
+
+struct ShaderBindingRecord {
+    uint64_t         id;
+    uint8_t          index;
+    ShaderStageFlags stages;
+    uint32_t         offset; // shader buffers only
+};
+
+struct DrawPrimitivesRecord {
+    uint32_t startOffset;
+    uint32_t vertexCount;
+};
+
+struct DrawIndexedRecord {
+    uint64_t indexBuffer;
+    uint32_t indexCount;
+    uint32_t indexOffset;
+    uint32_t baseVertexOffset;
+};
+
+struct DrawIndexedInstancedRecord {
+    uint64_t indexBuffer;
+    uint32_t indexCount;
+    uint32_t indexOffset;
+    uint32_t baseVertexOffset;
+    uint32_t instanceCount;
+};
+
+// EndRenderPass, BeginCommandBuffer, FrameBegin and Submit have no body
+
+static constexpr size_t kRecordAlignment = 8;
+
+inline size_t PaddedRecordSize(size_t bodySize, size_t payloadSize) {
+    size_t size = sizeof(RecordHeader) + bodySize + payloadSize;
+    return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+// Appends records to a byte stream. Not thread safe, give each recording thread its own writer and Append them
+class CaptureWriter {
+private:
+    std::vector<uint8_t> _bytes;
+    uint64_t             _recordCount{0};
+
+public:
+    template <typename Body>
+    void Write(CaptureOp op, const Body& body, const void* payload = nullptr, size_t payloadSize = 0) {
+        static_assert(std::is_trivially_copyable<Body>::value, "capture records are copied raw");
+        WriteRaw(op, &body, sizeof(Body), payload, payloadSize);
+    }
+
+    void Write(CaptureOp op) { WriteRaw(op, nullptr, 0, nullptr, 0); }
+
+    void Append(const CaptureWriter& other) {
+        _bytes.insert(_bytes.end(), other._bytes.begin(), other._bytes.end());
+        _recordCount += other._recordCount;
+    }
+
+    void Clear() {
+        _bytes.clear();
+        _recordCount = 0;
+    }
+
+    const std::vector<uint8_t>& Bytes() const { return _bytes; }
+    uint64_t                    RecordCount() const { return _recordCount; }
+
+    void WriteRaw(CaptureOp op, const void* body, size_t bodySize, const void* payload, size_t payloadSize) {
+        RecordHeader header;
+        header.op          = op;
+        header.bodySize    = static_cast<uint32_t>(bodySize);
+        header.payloadSize = payloadSize;
+
+        size_t offset = _bytes.size();
+        _bytes.resize(offset + PaddedRecordSize(bodySize, payloadSize), 0);
+
+        uint8_t* dst = _bytes.data() + offset;
+        memcpy(dst, &header, sizeof(RecordHeader));
+        if (bodySize > 0) {
+            memcpy(dst + sizeof(RecordHeader), body, bodySize);
+        }
+        if (payloadSize > 0) {
+            memcpy(dst + sizeof(RecordHeader) + bodySize, payload, payloadSize);
+        }
+        ++_recordCount;
+    }
+};
+
+// Walks records in place, data must stay alive and 8 byte aligned (a mapped file is)
+class CaptureReader {
+private:
+    const uint8_t* _cursor{nullptr};
+    const uint8_t* _end{nullptr};
+
+public:
+    struct Record {
+        CaptureOp      op;
+        const void*    body;
+        size_t         bodySize;
+        const uint8_t* payload;
+        size_t         payloadSize;
+
+        template <typename Body>
+        const Body& As() const {
+            dg_assert(bodySize == sizeof(Body), "capture record body doesn't match op %d", static_cast<int>(op));
+            return *static_cast<const Body*>(body);
+        }
+    };
+
+    CaptureReader() = default;
+    CaptureReader(const uint8_t* data, size_t size) : _cursor(data), _end(data + size) {}
+
+    // false at the end of the stream or on a record that doesn't fit in what's left
+    bool Next(Record* record) {
+        if (static_cast<size_t>(_end - _cursor) < sizeof(RecordHeader)) {
+            return false;
+        }
+
+        const RecordHeader* header = reinterpret_cast<const RecordHeader*>(_cursor);
+        size_t              size   = PaddedRecordSize(header->bodySize, header->payloadSize);
+        if (header->op >= CaptureOp::Count || size > static_cast<size_t>(_end - _cursor)) {
+            return false;
+        }
+
+        record->op          = header->op;
+        record->body        = _cursor + sizeof(RecordHeader);
+        record->bodySize    = header->bodySize;
+        record->payload     = _cursor + sizeof(RecordHeader) + header->bodySize;
+        record->payloadSize = header->payloadSize;
+        _cursor += size;
+        return true;
+    }
+
+    const uint8_t* Position() const { return _cursor; }
+};
+}
+}
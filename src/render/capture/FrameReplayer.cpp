@@ -0,0 +1,303 @@
+#include "FrameReplayer.h"
+#include "DGAssert.h"
+#include "Log.h"
+#include "RenderPassCommandBuffer.h"
+
+#include <cstring>
+
+namespace gfx {
+using namespace capture;
+
+FrameReplayer::FrameReplayer(RenderDevice* device) : _device(device) { dg_assert_nm(device != nullptr); }
+
+FrameReplayer::~FrameReplayer() { Unload(); }
+
+bool FrameReplayer::Load(const std::string& path) {
+    Unload();
+
+    if (!_file.Open(path)) {
+        LOG_E("replay: couldn't open %s", path.c_str());
+        return false;
+    }
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(_file.data());
+    if (_file.size() < sizeof(FileHeader) || header->magic != kMagic || header->version != kVersion) {
+        LOG_E("replay: %s isn't a version %u capture", path.c_str(), kVersion);
+        _file.Close();
+        return false;
+    }
+
+    CaptureReader         reader(_file.data() + sizeof(FileHeader), _file.size() - sizeof(FileHeader));
+    CaptureReader::Record record;
+    while (reader.Next(&record)) {
+        if (record.op == CaptureOp::FrameBegin) {
+            _frame = reader;
+            return true;
+        }
+        CreateResource(record);
+    }
+
+    LOG_E("replay: %s has no frame in it", path.c_str());
+    Unload();
+    return false;
+}
+
+void FrameReplayer::Unload() {
+    for (size_t id : _created) {
+        _device->DestroyResource(id);
+    }
+
+    _created.clear();
+    _ids.clear();
+    _colorTargets.clear();
+    _textures.clear();
+    _renderPasses.clear();
+    _frame = CaptureReader();
+    _file.Close();
+}
+
+size_t FrameReplayer::Resolve(uint64_t capturedId) const {
+    auto it = _ids.find(capturedId);
+    return it == _ids.end() ? NULL_ID : it->second;
+}
+
+// the only attachments the capture doesn't know are swapchain backbuffers. Stand in with a target of the pass's
+// format, sized like the depth buffer it's paired with
+TextureId FrameReplayer::ResolveColorTarget(uint64_t capturedId, uint64_t capturedPass, uint32_t attachment, uint64_t capturedDepth) {
+    TextureId texture = Resolve(capturedId);
+    if (texture != NULL_ID || capturedId == NULL_ID) {
+        return texture;
+    }
+
+    auto targetIt = _colorTargets.find(capturedId);
+    if (targetIt != _colorTargets.end()) {
+        return targetIt->second;
+    }
+
+    PixelFormat format     = PixelFormat::BGRA8Unorm;
+    auto        renderPass = _renderPasses.find(capturedPass);
+    if (renderPass != _renderPasses.end() && renderPass->second->info.attachments[attachment].format != PixelFormat::Invalid) {
+        format = renderPass->second->info.attachments[attachment].format;
+    }
+
+    uint32_t width  = kDefaultTargetWidth;
+    uint32_t height = kDefaultTargetHeight;
+    auto     depth  = _textures.find(capturedDepth);
+    if (depth != _textures.end()) {
+        width  = depth->second->width;
+        height = depth->second->height;
+    }
+
+    texture = _device->CreateTexture2D(format, TextureUsageFlags::RenderTarget, width, height, nullptr, "ReplayTarget");
+    _colorTargets.emplace(capturedId, texture);
+    _created.push_back(texture);
+    return texture;
+}
+
+void FrameReplayer::CreateResource(const CaptureReader::Record& record) {
+    switch (record.op) {
+        case CaptureOp::CreateBuffer: {
+            const CreateBufferRecord& buffer = record.As<CreateBufferRecord>();
+            if (_ids.count(buffer.id) > 0) {
+                return;
+            }
+
+            BufferDesc desc;
+            desc.usageFlags  = buffer.usageFlags;
+            desc.accessFlags = buffer.accessFlags;
+            desc.lifetime    = buffer.lifetime;
+            desc.isDynamic   = buffer.isDynamic != 0;
+            desc.size        = buffer.size;
+            desc.debugName   = "Replay";
+            _ids[buffer.id]  = _device->AllocateBuffer(desc, record.payloadSize > 0 ? record.payload : nullptr);
+            _created.push_back(_ids[buffer.id]);
+            return;
+        }
+        case CaptureOp::CreateTexture: {
+            const CreateTextureRecord& texture = record.As<CreateTextureRecord>();
+            if (_ids.count(texture.id) > 0) {
+                return;
+            }
+
+            size_t   sliceSize = static_cast<size_t>(PixelFormatByteSize(texture.format)) * texture.width * texture.height;
+            uint8_t* contents  = record.payloadSize > 0 ? const_cast<uint8_t*>(record.payload) : nullptr;
+            dg_assert_nm(contents == nullptr || record.payloadSize == sliceSize * texture.depth);
+
+            TextureId id = NULL_ID;
+            if (texture.kind == TextureKind::Texture2D) {
+                id = _device->CreateTexture2D(texture.format, texture.usage, texture.width, texture.height, contents, "Replay");
+            } else if (texture.kind == TextureKind::Cube) {
+                void* faces[6] = {nullptr};
+                for (uint32_t face = 0; face < 6 && contents != nullptr; ++face) {
+                    faces[face] = contents + sliceSize * face;
+                }
+                id = _device->CreateTextureCube(texture.format, texture.width, texture.height, contents != nullptr ? faces : nullptr, "Replay");
+            } else {
+                id = _device->CreateTextureArray(texture.format, texture.levels, texture.width, texture.height, texture.depth, "Replay");
+                for (uint32_t slice = 0; slice < texture.depth && contents != nullptr; ++slice) {
+                    _device->UpdateTexture(id, slice, contents + sliceSize * slice);
+                }
+            }
+            _ids[texture.id]      = id;
+            _created.push_back(id);
+            _textures[texture.id] = &texture;
+            return;
+        }
+        case CaptureOp::CreateShader: {
+            const CreateShaderRecord& shader = record.As<CreateShaderRecord>();
+            if (_ids.count(shader.id) > 0) {
+                return;
+            }
+
+            std::string functionName(reinterpret_cast<const char*>(record.payload), record.payloadSize);
+            ShaderId    id = _device->GetShader(shader.type, functionName);
+            if (id == NULL_ID) {
+                LOG_E("replay: device has no %s %s", ToString(shader.type).c_str(), functionName.c_str());
+                return;
+            }
+            // shaders belong to the device's library, Unload leaves them alone
+            _ids[shader.id] = id;
+            return;
+        }
+        case CaptureOp::CreateVertexLayout: {
+            const CreateVertexLayoutRecord& layout = record.As<CreateVertexLayoutRecord>();
+            if (_ids.count(layout.id) > 0) {
+                return;
+            }
+
+            VertexLayoutDesc desc;
+            desc.elements.resize(record.payloadSize / sizeof(VertexLayoutElement));
+            memcpy(desc.elements.data(), record.payload, desc.elements.size() * sizeof(VertexLayoutElement));
+            _ids[layout.id] = _device->CreateVertexLayout(desc);
+            _created.push_back(_ids[layout.id]);
+            return;
+        }
+        case CaptureOp::CreateRenderPass: {
+            const CreateRenderPassRecord& renderPass = record.As<CreateRenderPassRecord>();
+            if (_ids.count(renderPass.id) > 0) {
+                return;
+            }
+
+            _ids[renderPass.id]          = _device->CreateRenderPass(renderPass.info);
+            _renderPasses[renderPass.id] = &renderPass;
+            _created.push_back(_ids[renderPass.id]);
+            return;
+        }
+        case CaptureOp::CreatePipelineState: {
+            const CreatePipelineStateRecord& pipelineState = record.As<CreatePipelineStateRecord>();
+            if (_ids.count(pipelineState.id) > 0) {
+                return;
+            }
+
+            PipelineStateDesc desc = pipelineState.desc;
+            desc.renderPass        = Resolve(desc.renderPass);
+            desc.vertexShader      = Resolve(desc.vertexShader);
+            desc.pixelShader       = Resolve(desc.pixelShader);
+            desc.vertexLayout      = Resolve(desc.vertexLayout);
+            _ids[pipelineState.id] = _device->CreatePipelineState(desc);
+            _created.push_back(_ids[pipelineState.id]);
+            return;
+        }
+        default:
+            dg_assert_fail("replay: op %d isn't a resource", static_cast<int>(record.op));
+    }
+}
+
+void FrameReplayer::ReplayFrame() {
+    dg_assert(_file.isOpen(), "replay: nothing loaded");
+
+    CaptureReader            reader    = _frame;
+    CommandBuffer*           cmdBuffer = nullptr;
+    RenderPassCommandBuffer* pass      = nullptr;
+    CaptureReader::Record    record;
+    _drawCount = 0;
+
+    while (reader.Next(&record)) {
+        switch (record.op) {
+            case CaptureOp::CreateBuffer:
+            case CaptureOp::CreateTexture:
+            case CaptureOp::CreateShader:
+            case CaptureOp::CreateVertexLayout:
+            case CaptureOp::CreateRenderPass:
+            case CaptureOp::CreatePipelineState:
+                CreateResource(record);
+                break;
+            case CaptureOp::DestroyResource:
+                // kept until Unload, the next replay still needs it
+                break;
+            case CaptureOp::UpdateBuffer: {
+                const UpdateBufferRecord& update = record.As<UpdateBufferRecord>();
+                BufferId                  buffer = Resolve(update.id);
+                uint8_t*                  mapped = _device->MapMemory(buffer, update.access);
+                memcpy(mapped, record.payload, record.payloadSize);
+                _device->UnmapMemory(buffer);
+                break;
+            }
+            case CaptureOp::UpdateTexture: {
+                const UpdateTextureRecord& update = record.As<UpdateTextureRecord>();
+                _device->UpdateTexture(Resolve(update.id), update.slice, record.payload);
+                break;
+            }
+            case CaptureOp::BeginCommandBuffer:
+                cmdBuffer = _device->CreateCommandBuffer();
+                _submitList.push_back(cmdBuffer);
+                break;
+            case CaptureOp::BeginRenderPass: {
+                const BeginRenderPassRecord& begin       = record.As<BeginRenderPassRecord>();
+                FrameBuffer                  frameBuffer = begin.frameBuffer;
+                for (uint32_t idx = 0; idx < frameBuffer.colorCount; ++idx) {
+                    frameBuffer.color[idx] = ResolveColorTarget(begin.frameBuffer.color[idx], begin.passId, idx, begin.frameBuffer.depth);
+                }
+                frameBuffer.depth = Resolve(begin.frameBuffer.depth);
+                pass              = cmdBuffer->beginRenderPass(Resolve(begin.passId), frameBuffer, "Replay");
+                break;
+            }
+            case CaptureOp::EndRenderPass:
+                cmdBuffer->endRenderPass(pass);
+                pass = nullptr;
+                break;
+            case CaptureOp::SetPipelineState:
+                pass->setPipelineState(Resolve(record.As<IdRecord>().id));
+                break;
+            case CaptureOp::SetVertexBuffer:
+                pass->setVertexBuffer(Resolve(record.As<IdRecord>().id));
+                break;
+            case CaptureOp::SetShaderBuffer: {
+                const ShaderBindingRecord& binding = record.As<ShaderBindingRecord>();
+                pass->setShaderBuffer(Resolve(binding.id), binding.index, binding.stages, binding.offset);
+                break;
+            }
+            case CaptureOp::SetShaderTexture: {
+                const ShaderBindingRecord& binding = record.As<ShaderBindingRecord>();
+                pass->setShaderTexture(Resolve(binding.id), binding.index, binding.stages);
+                break;
+            }
+            case CaptureOp::DrawPrimitives: {
+                const DrawPrimitivesRecord& draw = record.As<DrawPrimitivesRecord>();
+                pass->drawPrimitives(draw.startOffset, draw.vertexCount);
+                ++_drawCount;
+                break;
+            }
+            case CaptureOp::DrawIndexed: {
+                const DrawIndexedRecord& draw = record.As<DrawIndexedRecord>();
+                pass->drawIndexed(Resolve(draw.indexBuffer), draw.indexCount, draw.indexOffset, draw.baseVertexOffset);
+                ++_drawCount;
+                break;
+            }
+            case CaptureOp::DrawIndexedInstanced: {
+                const DrawIndexedInstancedRecord& draw = record.As<DrawIndexedInstancedRecord>();
+                pass->drawIndexedInstanced(Resolve(draw.indexBuffer), draw.indexCount, draw.indexOffset, draw.baseVertexOffset, draw.instanceCount);
+                ++_drawCount;
+                break;
+            }
+            case CaptureOp::Submit:
+                _device->Submit(_submitList);
+                _submitList.clear();
+                cmdBuffer = nullptr;
+                break;
+            default:
+                dg_assert_fail("replay: unexpected op %d in frame", static_cast<int>(record.op));
+        }
+    }
+}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CaptureFormat.h"
+#include "File.h"
+#include "RenderDevice.h"
+
+namespace gfx {
+
+// Plays a CaptureDevice capture back onto any RenderDevice. Load maps the file and recreates the captured resources,
+// ReplayFrame then re-issues the frame's updates and command buffers as fast as the device takes them and can be
+// called over and over on the same state. The swapchain backbuffer was never created through the capture so its id
+// is unknown here, color attachments that don't resolve draw into an offscreen target made by the replayer instead.
+// Nothing is presented.
+class FrameReplayer {
+private:
+    static constexpr uint32_t kDefaultTargetWidth  = 1280;
+    static constexpr uint32_t kDefaultTargetHeight = 720;
+
+    RenderDevice*                        _device{nullptr};
+    fs::MappedFile                       _file;
+    capture::CaptureReader               _frame;        // records after FrameBegin
+    std::unordered_map<uint64_t, size_t> _ids;          // captured id -> id on _device
+    std::unordered_map<uint64_t, size_t> _colorTargets; // unresolved color attachment -> offscreen target
+    std::vector<size_t>                  _created;      // everything Unload destroys
+
+    std::unordered_map<uint64_t, const capture::CreateTextureRecord*>    _textures; // point into _file
+    std::unordered_map<uint64_t, const capture::CreateRenderPassRecord*> _renderPasses;
+
+    std::vector<CommandBuffer*> _submitList;
+    uint64_t                    _drawCount{0};
+
+public:
+    FrameReplayer(RenderDevice* device);
+    ~FrameReplayer();
+
+    bool Load(const std::string& path);
+    void Unload();
+
+    // resources created or destroyed during the captured frame are only created on the first replay and kept until
+    // Unload so every replay sees the same state
+    void ReplayFrame();
+
+    uint64_t DrawCount() const { return _drawCount; }
+    size_t   ResourceCount() const { return _ids.size(); }
+
+private:
+    void      CreateResource(const capture::CaptureReader::Record& record);
+    size_t    Resolve(uint64_t capturedId) const;
+    TextureId ResolveColorTarget(uint64_t capturedId, uint64_t capturedPass, uint32_t attachment, uint64_t capturedDepth);
+};
+}
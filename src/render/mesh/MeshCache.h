@@ -21,12 +21,13 @@ private:
     uint32_t indexOffset{ 0 };
 
     gfx::RenderDevice* _device{ nullptr };
+    VertexLayoutCache* _vertexLayouts{ nullptr };
 
 public:
     using CacheItemType = MeshPtr;
     using FileDataType = meshImport::MeshData;
 
-    MeshCachePolicy(gfx::RenderDevice* device) : _device(device) {
+    MeshCachePolicy(gfx::RenderDevice* device, VertexLayoutCache* vertexLayouts) : _device(device), _vertexLayouts(vertexLayouts) {
         gfx::BufferDesc vBufDesc = gfx::BufferDesc::vbPersistent(MAX_VERT_BUFF_SIZE, "MeshSharedVB");
 
         gfx::BufferDesc iBufDesc = gfx::BufferDesc::ibPersistent(MAX_INDEX_BUFF_SIZE, "MeshSharedIB");
@@ -65,7 +66,7 @@ private:
                 existBuffer.vertexBuffer = vertBufferId;
                 existBuffer.vertexOffset = vertOffset;
 
-                meshGeom.push_back({ _device, data, &existBuffer });
+                meshGeom.push_back({ _device, _vertexLayouts, data, &existBuffer });
                 meshGeom.back().meshMaterialId = part.matIdx;
 
                 vertOffset += data.vertexCount();
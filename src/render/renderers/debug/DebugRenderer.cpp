@@ -23,7 +23,7 @@ DebugRenderer::DebugRenderer() : Renderer(RendererType::Debug) {}
 void DebugRenderer::OnInit() {
     MeshGeometryData geometryData;
     dgen::GenerateIcoSphere(3, &geometryData);
-    _sphereGeometry = new MeshGeometry(device(), { geometryData });
+    _sphereGeometry = new MeshGeometry(device(), services()->vertexLayoutCache(), { geometryData });
 
     _sphereCache.reset(new SphereVertexCache(16, [&](const size_t& key, std::vector<DebugVertex>*& value) { delete value; }));
     _3DviewConstants = services()->constantBufferManager()->GetConstantBuffer(sizeof(DebugViewConstants), "debug3Dview");
@@ -206,7 +206,7 @@ void DebugRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
 
             memcpy(ptr + drawCall.startOffset, _buffers.filled2D.data(), sizeof(DebugVertex) * _buffers.filled2D.size());
 
-            _drawItems.push_back(encoder.Encode(device(), drawCall, {_2DfilledSG, renderQueue->defaults}));
+            _drawItems.push_back(encoder.Encode(services()->pipelineStateCache(), drawCall, {_2DfilledSG, renderQueue->defaults}));
             drawCall.startOffset += _buffers.filled2D.size();
             _buffers.filled2D.clear();
         }
@@ -216,7 +216,7 @@ void DebugRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
 
             memcpy(ptr + drawCall.startOffset, _buffers.wireframe2D.data(), sizeof(DebugVertex) * _buffers.wireframe2D.size());
 
-            _drawItems.push_back(encoder.Encode(device(), drawCall, {_2DwireframeSG, renderQueue->defaults}));
+            _drawItems.push_back(encoder.Encode(services()->pipelineStateCache(), drawCall, {_2DwireframeSG, renderQueue->defaults}));
             drawCall.startOffset += _buffers.wireframe2D.size();
             _buffers.wireframe2D.clear();
         }
@@ -226,7 +226,7 @@ void DebugRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
 
             memcpy(ptr + drawCall.startOffset, _buffers.filled3D.data(), sizeof(DebugVertex) * _buffers.filled3D.size());
 
-            _drawItems.push_back(encoder.Encode(device(), drawCall, {_3DfilledSG, renderQueue->defaults}));
+            _drawItems.push_back(encoder.Encode(services()->pipelineStateCache(), drawCall, {_3DfilledSG, renderQueue->defaults}));
             drawCall.startOffset += _buffers.filled3D.size();
             _buffers.filled3D.clear();
         }
@@ -236,7 +236,7 @@ void DebugRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
 
             memcpy(ptr + drawCall.startOffset, _buffers.wireframe3D.data(), sizeof(DebugVertex) * _buffers.wireframe3D.size());
 
-            _drawItems.push_back(encoder.Encode(device(), drawCall, {_3DwireframeSG, renderQueue->defaults}));
+            _drawItems.push_back(encoder.Encode(services()->pipelineStateCache(), drawCall, {_3DwireframeSG, renderQueue->defaults}));
             drawCall.startOffset += _buffers.wireframe3D.size();
             _buffers.wireframe3D.clear();
         }
@@ -257,7 +257,7 @@ void DebugRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
     // TODODODODODO; recycle and clean up transient buffers for spheres
 
     for (const gfx::DrawItem* item : _drawItems) {
-        renderQueue->AddDrawItem(5, item);
+        renderQueue->AddDrawItem(SortKey::Ordered(RenderLayer::Debug), item);
     }
 
     _buffers.filled2D.clear();
@@ -6,6 +6,7 @@
 #include "RenderDevice.h"
 #include "ResourceTypes.h"
 #include "StateGroupEncoder.h"
+#include "VertexLayoutCache.h"
 #include <memory>
 
 struct MeshGeomExistBuffer {
@@ -58,11 +59,11 @@ public:
     // temp: probly should move this
     uint32_t            meshMaterialId{ 0 };
 
-    MeshGeometry(gfx::RenderDevice* device, const MeshGeometryData& meshData, const MeshGeomExistBuffer* existingBufData = nullptr) : _device(device) {
+    MeshGeometry(gfx::RenderDevice* device, VertexLayoutCache* vertexLayouts, const MeshGeometryData& meshData, const MeshGeomExistBuffer* existingBufData = nullptr) : _device(device) {
 
-        // vertex layout *should* be fine to recreate every time as it should be cached
+        // every part of every mesh asks, the cache hands back the same layout for the same attributes
         gfx::VertexLayoutDesc vld = meshData.vertexLayout();
-        vertexlayout              = _device->CreateVertexLayout(vld);
+        vertexlayout              = vertexLayouts->Get(vld);
 
         // this will blow up if the layouts are not all the same currently
         assert(vertexlayoutStride == 0 || vertexlayoutStride == vld.stride());
@@ -73,4 +73,5 @@ public:
     }
 
     const gfx::StateGroup* stateGroup() { return _stateGroup.get(); }
+    gfx::TextureId         diffuseTexture() const { return textureid; }
 };
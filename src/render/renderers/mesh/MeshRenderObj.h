@@ -22,9 +22,22 @@ private:
     std::vector<std::unique_ptr<MeshMaterial>> meshMaterial;
     std::vector<std::unique_ptr<MeshGeometry>> meshGeometry;
     std::vector<glm::mat4> _boneOffsets;
-    ConstantBuffer* perObject{ nullptr };
+    // what actually gets uploaded, either _boneOffsets or a palette owned by a FrameSnapshot
+    const glm::mat4* _bonePalette{ nullptr };
+    uint32_t _bonePaletteCount{ 0 };
     std::unique_ptr<const gfx::StateGroup>   stateGroup;
-    
+
+    // one per mesh geometry, built by MeshRenderer the first time it's submitted and kept until something they were
+    // encoded from changes. per frame constants are a TransientBufferRing allocation the draw is queued with, so moving or
+    // animating doesn't dirty them
+    struct CachedDrawItem {
+        std::unique_ptr<const gfx::DrawItem> item;
+        uint32_t                             materialKey{0};
+    };
+    std::vector<CachedDrawItem> _drawItems;
+    const gfx::StateGroup*      _drawItemDefaults{ nullptr }; // queue defaults they were merged with
+    bool                        _drawItemsDirty{ true };
+
     dm::Transform _transform;
 
 public:
@@ -35,10 +48,21 @@ public:
     const std::vector<glm::mat4>& boneOffsets() const { return _boneOffsets; }
     dm::Transform* transform() { return &_transform; };
 
+    // call after changing anything the draw items are built from (mesh, materials, state groups), they get rebuilt on
+    // the next submit
+    void invalidateDrawItems() { _drawItemsDirty = true; }
+
     void boneOffsets(const std::vector<glm::mat4>& offsets) {
         // todo: ehh... maybe this could be a std::array with a max size for bones instead of a vector.
         // would help out, and with the shader neeeding hardcode of max anyway is probly better
         _boneOffsets = std::vector<glm::mat4>(offsets);
+        bonePalette(_boneOffsets.data(), static_cast<uint32_t>(_boneOffsets.size()));
+    }
+
+    // references bones owned by someone else, they have to stay put until this object has been submitted
+    void bonePalette(const glm::mat4* bones, uint32_t count) {
+        _bonePalette = bones;
+        _bonePaletteCount = count;
     }
     
     ~MeshRenderObj() {}
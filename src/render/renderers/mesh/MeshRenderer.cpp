@@ -1,32 +1,44 @@
 #include "MeshRenderer.h"
 #include "Log.h"
 #include <glm/gtx/transform.hpp>
-#include "ConstantBuffer.h"
-#include "ConstantBufferManager.h"
 #include "StateGroupEncoder.h"
 #include "MeshGeometry.h"
 #include "DrawItemEncoder.h"
 #include "Image.h"
 #include "Config.h"
 #include "MeshRenderObj.h"
-
-struct MeshConstants {
-    glm::mat4 world;
-    std::array<glm::mat4, 255> boneOffsets;
+#include "TaskScheduler.h"
+#include "TransientBufferRing.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+// a run copies at least one bone palette, a few of them is worth a task
+static constexpr size_t kSubmitChunkSize = 16;
+
+// what a 64k constant binding holds after the header, blinn's instanceMatrices
+static constexpr uint32_t kMaxInstanceMatrices = 1023;
+
+// a run of instances, each one's world then its bones, instanceInfo.x matrices apart
+struct MeshInstanceConstants {
+    glm::uvec4                                  instanceInfo;
+    std::array<glm::mat4, kMaxInstanceMatrices> matrices;
 };
+static_assert(sizeof(MeshInstanceConstants) <= TransientBufferRing::kBindWindow, "has to fit one binding");
+
+static size_t MeshInstanceConstantsSize(uint32_t matrixCount) {
+    return offsetof(MeshInstanceConstants, matrices) + matrixCount * sizeof(glm::mat4);
+}
 
 MeshRenderer::~MeshRenderer() {
-    // TODO: Cleanup renderObjs
-    assert(false);
+    // objects belong to whoever registered them and can already be gone here, their cached draw items go with them
 }
 
 void MeshRenderer::OnInit() {    
 }
 
 void MeshRenderer::Register(MeshRenderObj* meshObj) {
-    meshObj->perObject = services()->constantBufferManager()->GetConstantBuffer(sizeof(MeshConstants), "MeshWorld");    
-
-
     gfx::RasterState rs;
     rs.cullMode = gfx::CullMode::None;  
     rs.windingOrder = gfx::WindingOrder::FrontCW;
@@ -40,78 +52,167 @@ void MeshRenderer::Register(MeshRenderObj* meshObj) {
     
     gfx::StateGroupEncoder encoder;
     encoder.Begin();
-    encoder.BindResource(meshObj->perObject->GetBinding(1));
+    encoder.BindDynamicConstantBuffer(1, services()->transientConstants()->buffer());
     encoder.SetVertexShader(services()->shaderCache()->Get(gfx::ShaderType::VertexShader, "blinn"));
     //encoder.SetRasterState(rs);
     encoder.SetBlendState(blendState);
     meshObj->stateGroup.reset(encoder.End());
 
-    for (const MaterialData& matdata : meshObj->mat->matData) {
-        std::string shaderName;
-        switch (matdata.shadingModel) {
-            // oh how convienient, they're all blinn
-        default:
-            shaderName = "blinn";
-        }
-        gfx::ShaderId ps = services()->shaderCache()->Get(gfx::ShaderType::PixelShader, shaderName);
-        meshObj->meshMaterial.push_back(std::make_unique<MeshMaterial>(device(), matdata, ps));
-    }
-
     for (const auto& boneInfo : meshObj->mesh->GetBones()) {
         meshObj->_boneOffsets.emplace_back(boneInfo.second);
     }
+    meshObj->bonePalette(meshObj->_boneOffsets.data(), static_cast<uint32_t>(meshObj->_boneOffsets.size()));
 
+    meshObj->invalidateDrawItems();
     meshRenderObjs.push_back(meshObj);
 }
 
+void MeshRenderer::Unregister(MeshRenderObj* renderObj) {
+    auto it = std::find(begin(meshRenderObjs), end(meshRenderObjs), renderObj);
+    if (it == meshRenderObjs.end()) {
+        return;
+    }
+
+    ReleaseDrawItems(renderObj);
+    meshRenderObjs.erase(it);
+}
+
+void MeshRenderer::EncodeDrawItems(MeshRenderObj* renderObj, const gfx::StateGroup* defaults) {
+    ReleaseDrawItems(renderObj);
+
+    // materials own device textures, only objects that end up leading a batch get theirs built
+    if (renderObj->meshMaterial.empty()) {
+        for (const MaterialData& matdata : renderObj->mat->matData) {
+            std::string shaderName;
+            switch (matdata.shadingModel) {
+                // oh how convienient, they're all blinn
+            default:
+                shaderName = "blinn";
+            }
+            gfx::ShaderId ps = services()->shaderCache()->Get(gfx::ShaderType::PixelShader, shaderName);
+            renderObj->meshMaterial.push_back(std::make_unique<MeshMaterial>(device(), matdata, ps));
+        }
+    }
+
+    for (const auto& mg : renderObj->mesh->GetMeshGeometry()) {
+        uint32_t meshMatIdx = mg.meshMaterialId;
+        assert(renderObj->meshMaterial.size() > meshMatIdx);
+
+        const gfx::StateGroup* groups[] = {
+            renderObj->stateGroup.get(),
+            mg.stateGroup(),
+            renderObj->meshMaterial[meshMatIdx]->stateGroup(),
+            defaults
+        };
+
+        MeshRenderObj::CachedDrawItem cached;
+        cached.item.reset(gfx::DrawItemEncoder::Encode(services()->pipelineStateCache(), mg.drawCall(), groups, 4));
+        // the queue groups by pipeline then diffuse texture, near to far inside that
+        cached.materialKey = SortKey::MaterialKey(renderObj->meshMaterial[meshMatIdx]->diffuseTexture());
+        renderObj->_drawItems.emplace_back(std::move(cached));
+    }
+
+    renderObj->_drawItemDefaults = defaults;
+    renderObj->_drawItemsDirty   = false;
+}
+
+void MeshRenderer::ReleaseDrawItems(MeshRenderObj* renderObj) {
+    // pipeline states belong to the PipelineStateCache, other items can be sharing them
+    renderObj->_drawItems.clear();
+    renderObj->_drawItemsDirty = true;
+}
+
 void MeshRenderer::Submit(RenderQueue* renderQueue, const FrameView* renderView) {
-    _drawItems.clear();
-    sortedMatCache.clear();
-    
+    // encoding and batching stay on this thread since a pipeline state miss creates one. Allocating and filling the
+    // constants and adding the draw items is what goes wide
+    for (uint32_t idx = 0; idx < _batchCount; ++idx) {
+        _batches[idx].objs.clear();
+    }
+    _batchLookup.clear();
+    _batchCount = 0;
+
     // todo: switch this back to renderview
     for (RenderObj* baseRO : meshRenderObjs) {
         if (baseRO->GetRendererType() != Renderer::rendererType()) {
             continue;
         }
         MeshRenderObj* renderObj = static_cast<MeshRenderObj*>(baseRO);
-        
-        glm::mat4 world = renderObj->_transform.matrix();
-        
-        assert(renderObj->perObject);
+
         assert(renderObj->mat);
         assert(renderObj->mesh);
 
-        MeshConstants* meshBuffer = renderObj->perObject->Map<MeshConstants>();
-        assert(renderObj->_boneOffsets.size() <= meshBuffer->boneOffsets.size());
-
-        std::memcpy(meshBuffer->boneOffsets.data(), renderObj->_boneOffsets.data(), std::min(renderObj->_boneOffsets.size(), meshBuffer->boneOffsets.size()) * sizeof(glm::mat4));
-        meshBuffer->world = world;
-        renderObj->perObject->Unmap();
-
-        for (const auto& mg : renderObj->mesh->GetMeshGeometry()) {
-            gfx::DrawItemEncoder encoder;
-
-            std::unique_ptr<const gfx::DrawItem> drawItem;
-
-            uint32_t meshMatIdx = mg.meshMaterialId;
-            assert(renderObj->meshMaterial.size() > meshMatIdx);
-
-            std::vector<const gfx::StateGroup*> groups = { 
-                renderObj->stateGroup.get(),
-                mg.stateGroup(),
-                renderObj->meshMaterial[meshMatIdx]->stateGroup(),
-                renderQueue->defaults 
-            };
-
-            drawItem.reset(encoder.Encode(device(), mg.drawCall(), groups.data(), groups.size()));
+        if (renderObj->mesh->GetMeshGeometry().empty()) {
+            continue;
+        }
 
-            _drawItems.emplace_back(std::move(drawItem));
-            sortedMatCache.emplace(meshMatIdx, _drawItems.back().get());
+        BatchKey key{renderObj->mesh.get(), renderObj->mat.get()};
+        auto     it = _batchLookup.find(key);
+        if (it == _batchLookup.end()) {
+            if (_batchCount == _batches.size()) {
+                _batches.emplace_back();
+            }
+            Batch& batch = _batches[_batchCount];
+            // unskinned meshes still get an identity bone for the shader to read
+            batch.stride = 1 + std::max<uint32_t>(static_cast<uint32_t>(renderObj->mesh->GetBones().size()), 1);
+            assert(batch.stride <= kMaxInstanceMatrices);
+            it = _batchLookup.emplace(key, _batchCount++).first;
         }
+        _batches[it->second].objs.push_back(renderObj);
+    }
 
-        // cant find if iterator is guarenteed to go bucket by bucket, but still doing it live
-        for (auto it = sortedMatCache.begin(); it != sortedMatCache.end(); ++it) {
-            renderQueue->AddDrawItem(0, it->second);
+    _runs.clear();
+    for (uint32_t batchIdx = 0; batchIdx < _batchCount; ++batchIdx) {
+        const Batch& batch       = _batches[batchIdx];
+        uint32_t     maxPerRun   = kMaxInstanceMatrices / batch.stride;
+        uint32_t     objectCount = static_cast<uint32_t>(batch.objs.size());
+        for (uint32_t first = 0; first < objectCount; first += maxPerRun) {
+            _runs.push_back({batchIdx, first, std::min(maxPerRun, objectCount - first)});
+
+            // only the first object of a run gets drawn, the rest just contribute their matrices
+            MeshRenderObj* leader = batch.objs[first];
+            if (leader->_drawItemsDirty || leader->_drawItemDefaults != renderQueue->defaults) {
+                EncodeDrawItems(leader, renderQueue->defaults);
+            }
         }
     }
+
+    TransientBufferRing* constants = services()->transientConstants();
+    scheduler()->parallelFor(_runs.size(), kSubmitChunkSize, [this, renderQueue, renderView, constants](size_t begin, size_t end) {
+        for (size_t runIdx = begin; runIdx < end; ++runIdx) {
+            const InstanceRun& run   = _runs[runIdx];
+            const Batch&       batch = _batches[run.batch];
+
+            TransientBufferRing::Allocation allocation = constants->Allocate(MeshInstanceConstantsSize(run.count * batch.stride));
+            if (!allocation) {
+                continue;
+            }
+            MeshInstanceConstants* instances = reinterpret_cast<MeshInstanceConstants*>(allocation.data);
+            instances->instanceInfo          = glm::uvec4(batch.stride, run.count, 0, 0);
+
+            float depth = 1.f;
+            for (uint32_t idx = 0; idx < run.count; ++idx) {
+                MeshRenderObj* renderObj = batch.objs[run.first + idx];
+                glm::mat4*     matrices  = &instances->matrices[idx * batch.stride];
+                uint32_t       boneCount = std::min(renderObj->_bonePaletteCount, batch.stride - 1);
+                glm::mat4      world     = renderObj->_transform.matrix();
+
+                // mapped memory is write only as far as we're concerned, nothing gets read back out of it
+                matrices[0] = world;
+                if (boneCount > 0) {
+                    std::memcpy(matrices + 1, renderObj->_bonePalette, boneCount * sizeof(glm::mat4));
+                }
+                std::fill(matrices + 1 + boneCount, matrices + batch.stride, glm::mat4(1.f));
+
+                // the whole run sorts where its nearest instance would
+                depth = std::min(depth, glm::length(glm::vec3(world[3]) - renderView->eyePos) / renderView->zfar);
+            }
+
+            // every object in the batch has the same draw items up to the per instance data, the first one's get drawn
+            const MeshRenderObj* leader = batch.objs[run.first];
+            for (const MeshRenderObj::CachedDrawItem& cached : leader->_drawItems) {
+                renderQueue->AddDrawItem(SortKey::Opaque(RenderLayer::World, cached.item.get(), cached.materialKey, depth), cached.item.get(), allocation.offset,
+                                         run.count);
+            }
+        }
+    });
 }
@@ -2,16 +2,43 @@
 
 #include "Renderer.h"
 #include "MeshRenderObj.h"
+#include "Hash.h"
 #include <memory>
-#include <vector>
 #include <unordered_map>
+#include <vector>
 
 class MeshRenderer : public Renderer {
 private:
-    std::vector<MeshRenderObj*> meshRenderObjs;
-    std::vector<std::unique_ptr<const gfx::DrawItem>>  _drawItems;
+    // objects with the same mesh and material encode to the same draw items (their own state group is the same for all
+    // of them), so they draw instanced off the first one's
+    struct BatchKey {
+        const Mesh*     mesh;
+        const Material* material;
+
+        bool operator==(const BatchKey& other) const = default;
+    };
+
+    struct BatchKeyHash {
+        size_t operator()(const BatchKey& key) const { return HashCombine(key.mesh, key.material); }
+    };
 
-    std::unordered_multimap<uint32_t, const gfx::DrawItem*> sortedMatCache;
+    struct Batch {
+        std::vector<MeshRenderObj*> objs;
+        uint32_t                    stride; // matrices per instance, world then bones
+    };
+
+    // as many of a batch's instances as fit in one constant binding, one draw per geometry
+    struct InstanceRun {
+        uint32_t batch;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    std::vector<MeshRenderObj*>                          meshRenderObjs;
+    std::unordered_map<BatchKey, uint32_t, BatchKeyHash> _batchLookup;
+    std::vector<Batch>                                   _batches; // kept across frames with their storage, _batchCount live
+    uint32_t                                             _batchCount{0};
+    std::vector<InstanceRun>                             _runs; // draw items encoded, constants filled on workers
 
 public:
     MeshRenderer() : Renderer(RendererType::Mesh) {}
@@ -19,6 +46,10 @@ public:
 
     void OnInit() override;
     void Register(MeshRenderObj* renderObj);
-    void Unregister(MeshRenderObj* renderObj) { assert(false); }
+    void Unregister(MeshRenderObj* renderObj);
     void Submit(RenderQueue* renderQueue, const FrameView* view) final;
+
+private:
+    void EncodeDrawItems(MeshRenderObj* renderObj, const gfx::StateGroup* defaults);
+    void ReleaseDrawItems(MeshRenderObj* renderObj);
 };
@@ -111,12 +111,12 @@ void SkyRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
             drawCall.primitiveCount = 36;
 
             std::vector<const gfx::StateGroup*> groups = {skybox->_group, renderQueue->defaults};
-            skybox->_item                              = gfx::DrawItemEncoder::Encode(device(), drawCall, groups.data(), groups.size());
+            skybox->_item                              = gfx::DrawItemEncoder::Encode(services()->pipelineStateCache(), drawCall, groups.data(), groups.size());
         }
 
         skybox->_constantBuffer->Map<SkyboxConstants>()->world = world;
         skybox->_constantBuffer->Unmap();
 
-        renderQueue->AddDrawItem(0, skybox->_item);
+        renderQueue->AddDrawItem(SortKey::Ordered(RenderLayer::Sky), skybox->_item);
     }
 }
@@ -23,6 +23,8 @@ public:
         , tileResolution(resolution) {}
 
     virtual TerrainDataTile* GetTile(const TerrainQuadNode& quadNode) = 0;
-    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::set<TerrainTileKey>& keysLeaving,
-                        const std::set<TerrainTileKey>& keysEntering) = 0;
+    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::vector<TerrainTileKey>& keysLeaving,
+                        const std::vector<TerrainTileKey>& keysEntering) = 0;
+    // nodes that are expected to be visible soon, called after Update. producers that don't prefetch ignore it
+    virtual void Prefetch(const std::vector<const TerrainQuadNode*>& nodesAhead) {}
 };
@@ -10,5 +10,5 @@ public:
     FlatTerrain(double size) { _quadTree = addQuadTree(size, std::make_shared<NoDeformation>(), glm::mat4()); }
     ~FlatTerrain() {}
 
-    void setTransform(const glm::mat4& transform) { _quadTree->transform() = transform; }
+    void setTransform(const glm::mat4& transform) { _quadTree->SetTransform(transform); }
 };
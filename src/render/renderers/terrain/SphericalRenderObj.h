@@ -59,7 +59,7 @@ public:
 
     void setTransform(const glm::mat4& transform) {
         for (TerrainQuadTree* tree : _quadTrees) {
-            tree->transform() = transform * tree->transform();
+            tree->SetTransform(transform * tree->transform());
         }
     }
 };
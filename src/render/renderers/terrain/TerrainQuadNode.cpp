@@ -1,10 +1,17 @@
 #include "TerrainQuadNode.h"
+#include <limits>
 #include "TerrainQuadTree.h"
 
 using namespace dm;
 
-TerrainQuadNode::TerrainQuadNode(const TerrainQuadTree* terrain, const TerrainTileKey& key, const dm::Rect3Dd& local, const dm::Rect3Dd& sampleSpace, double size)
-    : terrain(terrain), key(key), size(size), localRect(local), sampleRect(sampleSpace) {}
+TerrainQuadNode::TerrainQuadNode(const TerrainQuadTree* terrain, const TerrainTileKey& key, const dm::Rect3Dd& local, const dm::Rect3Dd& sampleSpace, double size,
+                                 TerrainQuadNode* parent)
+    : terrain(terrain), parent(parent), key(key), size(size), localRect(local), sampleRect(sampleSpace) {
+    if (parent != nullptr) {
+        heightRange = parent->heightRange;
+    }
+    UpdateBounds();
+}
 
 glm::mat4 TerrainQuadNode::worldMatrix() const { return terrain->worldTransformForKey(key); }
 
@@ -31,6 +38,45 @@ void TerrainQuadNode::SubdivideIfNecessary() {
 
     children.reserve(4);
     for (uint32_t i = 0; i < 4; ++i) {
-        children.emplace_back(this->terrain, childrenKeys[i], childrenRects[i], childrenSampleRects[i], size / 2.0);
+        children.emplace_back(this->terrain, childrenKeys[i], childrenRects[i], childrenSampleRects[i], size / 2.0, this);
+    }
+}
+
+// children that haven't got their own tile yet keep following along
+void TerrainQuadNode::SetHeightRange(const glm::vec2& range) {
+    heightRange = range;
+    UpdateBounds();
+
+    std::vector<TerrainQuadNode*> nodes;
+    for (TerrainQuadNode& child : children) {
+        nodes.push_back(&child);
+    }
+    while (!nodes.empty()) {
+        TerrainQuadNode* node = nodes.back();
+        nodes.pop_back();
+        if (node->hasOwnHeightRange) {
+            continue;
+        }
+        node->heightRange = range;
+        node->UpdateBounds();
+        for (TerrainQuadNode& child : node->children) {
+            nodes.push_back(&child);
+        }
+    }
+    hasOwnHeightRange = true;
+}
+
+void TerrainQuadNode::UpdateBounds() {
+    const glm::mat4& transform = terrain->transform();
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    for (const glm::dvec3& corner : {localRect.bl(), localRect.br(), localRect.tl(), localRect.tr()}) {
+        for (float height : {heightRange.x, heightRange.y}) {
+            glm::vec3 p = glm::vec3(transform * glm::vec4(corner.x, corner.y, height * kTerrainHeightScale, 1.f));
+            min         = glm::min(min, p);
+            max         = glm::max(max, p);
+        }
     }
+    bounds = dm::BoundingBox(min, max);
 }
@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
+#include "BoundingBox.h"
 #include "Hash.h"
 #include "Rectangle.h"
 #include "TerrainTileKey.h"
@@ -11,16 +12,24 @@ class TerrainQuadTree;
 
 using LocalCoords = glm::dvec2;
 
+// heightmap value to local z, the terrain shaders scale by the same
+static constexpr float kTerrainHeightScale = 250.f;
+
 class TerrainQuadNode {
 public:
-    TerrainQuadNode(const TerrainQuadTree* terrain, const TerrainTileKey& key, const dm::Rect3Dd& local, const dm::Rect3Dd& sampleSpace, double size);
+    TerrainQuadNode(const TerrainQuadTree* terrain, const TerrainTileKey& key, const dm::Rect3Dd& local, const dm::Rect3Dd& sampleSpace, double size,
+                    TerrainQuadNode* parent = nullptr);
 
     const TerrainQuadTree*       terrain{nullptr};
+    TerrainQuadNode*             parent{nullptr};
     std::vector<TerrainQuadNode> children;
     const TerrainTileKey         key;
     const double                 size;
     const dm::Rect3Dd            localRect;
     const dm::Rect3Dd            sampleRect;
+    glm::vec2                    heightRange{-1.f, 1.f}; // heightmap values, the parent's until this node's tile arrives
+    bool                         hasOwnHeightRange{false};
+    dm::BoundingBox              bounds; // world space, localRect raised to heightRange
 
     glm::dvec3  deformedPosition() const;
     glm::dvec3  normal() const;
@@ -28,6 +37,8 @@ public:
     glm::mat4   worldMatrix() const;
     bool        HasChildren() const { return children.size() == 4; }
     void        SubdivideIfNecessary();
+    void        SetHeightRange(const glm::vec2& range);
+    void        UpdateBounds();
 
 private:
 };
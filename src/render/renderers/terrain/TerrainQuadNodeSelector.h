@@ -1,60 +1,199 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
 #include <queue>
-#include <random>
-#include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
-#include "Camera.h"
-#include "ConsoleCommands.h"
 #include "DGAssert.h"
+#include "RenderView.h"
 #include "TerrainQuadNode.h"
 #include "TerrainQuadTree.h"
 
-static int32_t maxLod = 5;
-static uint32_t seed = 0;
+struct TerrainLodParams {
+    uint32_t tileResolution{128};
+    float    maxScreenError{8.f}; // pixels
+};
 
+// Keeps the cut through one quad tree (the leaves of the tree as refined for the view, in view or not) from frame to
+// frame and only splits or merges where the view moved enough to change it. The cut is kept depth first, so the
+// children of a node always sit next to each other: a node that stops refining has its children merged back as the
+// walk reaches the last of them, and that cascades up as far as it needs to in the same walk.
+// Selected nodes are the cut nodes in view. Entering and leaving fall out of the walk, nothing diffs whole scenes,
+// and once the vectors have grown nothing allocates.
+// A node refines while it's in view and drawing it instead of its children would be off by more than maxScreenError
+// pixels. It only merges back once that's under kMergeHysteresis of it, so nodes right at the threshold don't pop
+// back and forth as the camera moves
 class TerrainQuadNodeSelector {
+private:
+    static constexpr uint32_t kMaxLod          = 15;
+    static constexpr float    kMergeHysteresis = 0.75f;
+
+    struct CutNode {
+        TerrainQuadNode* node;
+        bool             selected; // in view last time it was walked
+    };
+
+    const TerrainLodParams _params;
+    std::vector<CutNode>   _cut;
+    std::vector<CutNode>   _next;
+
 public:
-    void SelectQuadNodes(const FrameView* view, TerrainQuadTree* tree, std::vector<const TerrainQuadNode*>* outputVector) {
+    struct CheckStats {
+        uint32_t matching{0}; // selected, and breadth first selects it too
+        uint32_t held{0};     // finer than breadth first, but no finer than the merge threshold keeps
+        uint32_t wrong{0};    // selected where breadth first never would
+        uint32_t missing{0};  // breadth first nodes with nothing selected in them
+    };
 
-        std::queue<TerrainQuadNode*> q;
-        q.push(tree->rootNode());
+    TerrainQuadNodeSelector(TerrainQuadTree* tree, const TerrainLodParams& params) : _params(params), _cut({{tree->rootNode(), false}}) {}
 
-        while (!q.empty()) {
-            TerrainQuadNode* node = q.front();
-            q.pop();
+    // view is null for a tree that isn't in view at all, anything selected leaves. entering and leaving can be null
+    void Update(const FrameView* view, std::vector<const TerrainQuadNode*>* selected, std::vector<TerrainTileKey>* entering,
+                std::vector<TerrainTileKey>* leaving) {
+        _next.clear();
+        for (const CutNode& cut : _cut) {
+            if (view != nullptr && ShouldRefine(view, cut.node, _params.maxScreenError)) {
+                Leave(cut, leaving);
+                Split(view, cut.node);
+                continue;
+            }
 
-            if (!IsNodeInView(view, node)) {
+            _next.push_back(cut);
+            while (_next.size() >= 4) {
+                // four in a row with the same parent can only be all of its children
+                TerrainQuadNode* parent = _next.back().node->parent;
+                if (parent == nullptr || _next[_next.size() - 4].node->parent != parent) {
+                    break;
+                }
+                if (view != nullptr && ShouldRefine(view, parent, _params.maxScreenError * kMergeHysteresis)) {
+                    break;
+                }
+                for (size_t idx = _next.size() - 4; idx < _next.size(); ++idx) {
+                    Leave(_next[idx], leaving);
+                }
+                _next.resize(_next.size() - 4);
+                _next.push_back({parent, false});
+            }
+        }
+        std::swap(_cut, _next);
+
+        for (CutNode& cut : _cut) {
+            bool inView = view != nullptr && IsNodeInView(view, cut.node);
+            if (inView) {
+                selected->push_back(cut.node);
+                if (!cut.selected && entering != nullptr) {
+                    entering->push_back(cut.node->key);
+                }
+            } else if (cut.selected && leaving != nullptr) {
+                leaving->push_back(cut.node->key);
+            }
+            cut.selected = inView;
+        }
+    }
+
+    // compares what the last Update selected with the selection worked out from scratch, breadth first, at the split
+    // and at the merge threshold. Same view as that Update, slow, for checking only
+    void Check(const FrameView* view, TerrainQuadTree* tree, CheckStats* stats) {
+        std::vector<const TerrainQuadNode*> coarse;
+        std::vector<const TerrainQuadNode*> fine;
+        SelectBreadthFirst(view, tree, _params.maxScreenError, &coarse);
+        SelectBreadthFirst(view, tree, _params.maxScreenError * kMergeHysteresis, &fine);
+
+        std::unordered_set<const TerrainQuadNode*> coarseNodes(begin(coarse), end(coarse));
+        std::unordered_set<const TerrainQuadNode*> fineOrAbove;
+        std::unordered_set<const TerrainQuadNode*> covered;
+        for (const TerrainQuadNode* node : fine) {
+            for (; node != nullptr && fineOrAbove.insert(node).second; node = node->parent) {}
+        }
+
+        for (const CutNode& cut : _cut) {
+            if (!cut.selected) {
+                continue;
+            }
+            const TerrainQuadNode* ancestor = cut.node;
+            while (ancestor != nullptr && coarseNodes.count(ancestor) == 0) {
+                ancestor = ancestor->parent;
+            }
+            if (ancestor == cut.node) {
+                ++stats->matching;
+            } else if (ancestor != nullptr && fineOrAbove.count(cut.node) > 0) {
+                ++stats->held;
+            } else {
+                ++stats->wrong;
                 continue;
             }
+            covered.insert(ancestor);
+        }
+        for (const TerrainQuadNode* node : coarse) {
+            if (covered.count(node) == 0) {
+                ++stats->missing;
+            }
+        }
+    }
 
-            if (ShouldSplitNode(view, node)) {
+private:
+    // how selection worked before the cut was kept, every node from the root down every time
+    void SelectBreadthFirst(const FrameView* view, TerrainQuadTree* tree, float maxScreenError, std::vector<const TerrainQuadNode*>* selected) {
+        std::queue<TerrainQuadNode*> queue;
+        queue.push(tree->rootNode());
+        while (!queue.empty()) {
+            TerrainQuadNode* node = queue.front();
+            queue.pop();
+            if (!IsNodeInView(view, node)) {
+                continue;
+            }
+            if (ShouldRefine(view, node, maxScreenError)) {
                 node->SubdivideIfNecessary();
-
                 for (TerrainQuadNode& child : node->children) {
-                    q.push(&child);
+                    queue.push(&child);
                 }
             } else {
-                outputVector->push_back(node);
+                selected->push_back(node);
             }
         }
     }
 
-private:
-    bool IsNodeInView(const FrameView* view, const TerrainQuadNode* node) {
-        dm::Rect3Dd rect = node->worldRect();
-        dm::BoundingBox box(rect.bl(), rect.tr());
-        return view->frustum.IsBoxInFrustum(box);
+    // children go in depth first, refining as far as the view needs
+    void Split(const FrameView* view, TerrainQuadNode* node) {
+        node->SubdivideIfNecessary();
+        dg_assert_nm(node->HasChildren());
+        for (TerrainQuadNode& child : node->children) {
+            if (ShouldRefine(view, &child, _params.maxScreenError)) {
+                Split(view, &child);
+            } else {
+                _next.push_back({&child, false});
+            }
+        }
+    }
+
+    void Leave(const CutNode& cut, std::vector<TerrainTileKey>* leaving) {
+        if (cut.selected && leaving != nullptr) {
+            leaving->push_back(cut.node->key);
+        }
     }
-    bool ShouldSplitNode(const FrameView* view, const TerrainQuadNode* node) {
-        if (node->key.lod >= 15)
-            return false;
-        dm::Rect3Dd rect = node->worldRect();
-        dm::BoundingBox box(rect.bl(), rect.tr());
-        float d = box.distance(view->eyePos);
-        if (d < 1.5f * node->size) {
-            return true;
-        }
-        return false;
+
+    bool ShouldRefine(const FrameView* view, const TerrainQuadNode* node, float maxScreenError) {
+        return node->key.lod < kMaxLod && IsNodeInView(view, node) && ScreenError(view, node) > maxScreenError;
+    }
+
+    bool IsNodeInView(const FrameView* view, const TerrainQuadNode* node) { return view->frustum.IsBoxInFrustum(node->bounds); }
+
+    // pixels off at the closest point of the node's box. The world error of a tile is taken as its sample spacing
+    // (slopes up to 45 degrees) but never more than its height range, so flat tiles stop refining early
+    float ScreenError(const FrameView* view, const TerrainQuadNode* node) {
+        float spacing = static_cast<float>(node->size) / (_params.tileResolution - 1);
+        float error   = std::min(spacing, (node->heightRange.y - node->heightRange.x) * kTerrainHeightScale);
+        if (error <= 0.f) {
+            return 0.f;
+        }
+        float distance = static_cast<float>(node->bounds.distance(view->eyePos));
+        if (distance <= 0.f) {
+            return std::numeric_limits<float>::max();
+        }
+        // projection[1][1] is 1 / tan(fovy / 2)
+        float pixelsPerUnit = view->viewport.height * view->projection[1][1] * 0.5f;
+        return error * pixelsPerUnit / distance;
     }
 };
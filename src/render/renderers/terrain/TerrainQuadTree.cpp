@@ -21,7 +21,35 @@ glm::dvec3 TerrainQuadTree::localToWorld(const glm::dvec3& localPosition) const
     glm::dvec4 res = _transform * glm::dvec4(localPosition.x, localPosition.y, 0, 1);
     return glm::dvec3(res);
 }
-glm::mat4& TerrainQuadTree::transform() { return _transform; }
+void TerrainQuadTree::SetTransform(const glm::mat4& transform) {
+    _transform = transform;
+
+    std::vector<TerrainQuadNode*> nodes = {_rootNode.get()};
+    while (!nodes.empty()) {
+        TerrainQuadNode* node = nodes.back();
+        nodes.pop_back();
+        node->UpdateBounds();
+        for (TerrainQuadNode& child : node->children) {
+            nodes.push_back(&child);
+        }
+    }
+}
+
+TerrainQuadNode* TerrainQuadTree::FindNode(const TerrainTileKey& key) {
+    dg_assert_nm(key.tid == _terrainId);
+
+    // each level down picks the child from the next bit of tx/ty, in TerrainTileKey::subdivide's order
+    TerrainQuadNode* node = _rootNode.get();
+    for (uint32_t lod = key.lod; lod > 0 && node != nullptr; --lod) {
+        if (!node->HasChildren()) {
+            return nullptr;
+        }
+        uint32_t x = (key.tx >> (lod - 1)) & 1;
+        uint32_t y = (key.ty >> (lod - 1)) & 1;
+        node       = &node->children[y * 2 + x];
+    }
+    return node;
+}
 
 glm::mat4 TerrainQuadTree::worldTransformForKey(const TerrainTileKey& key) const {
     dg_assert_nm(key.tid == _terrainId);
@@ -27,7 +27,11 @@ public:
 
     glm::dvec3 localToDeformed(const glm::dvec3& localPosition) const;
     glm::dvec3 localToWorld(const glm::dvec3& localPosition) const;
-    glm::mat4& transform();
+    const glm::mat4& transform() const { return _transform; }
+    void             SetTransform(const glm::mat4& transform); // moves the bounds of every node along
+
+    // null when the tree hasn't been split down that far
+    TerrainQuadNode* FindNode(const TerrainTileKey& key);
 
     glm::mat4 worldTransformForKey(const TerrainTileKey& key) const;
 
@@ -1,10 +1,14 @@
 #include "TerrainRenderer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <glm/gtx/transform.hpp>
-#include <queue>
-#include <set>
+#include "Config.h"
+#include "ConsoleCommands.h"
 #include "DMath.h"
 #include "ElevationDataTileProducer.h"
+#include "File.h"
 #include "Log.h"
 #include "Log.h"
 #include "MeshGeneration.h"
@@ -13,6 +17,7 @@
 #include "TerrainDataTile.h"
 #include "TerrainElevationLayerRenderer.h"
 #include "TerrainQuadNode.h"
+#include "TerrainTilePack.h"
 
 TerrainRenderer::TerrainRenderer()  : TypedRenderer<TerrainRenderObj>(RendererType::Terrain) {}
 
@@ -20,18 +25,65 @@ TerrainRenderer::~TerrainRenderer() {}
 
 // TODO: Layer abstraction in TerrainRenderer is no good. Think of something better.
 // TODO: Producers have alot of duplicate code. Do something about it
-// TODO: Quadnodes needs bounding boxes with proper elevation data
 // TODO: Properly rendering partial tiles. (ex. Scale texure coords). Necessary to fix flickering
 // TODO: producers need to walk tree instead of jumping straight to tile so that we have high lod fallback
-// TODO: selection can select too many tiles, raping caches
 // TODO: Borders for normalmaps
 
+static constexpr float    kDefaultPrefetchHorizon = 0.5f;
+static constexpr uint64_t kDefaultTilePackMaxMB   = 1024;
+
+// [TerrainSettings] name as a float, defaultValue when it's empty or isn't a number
+static float terrainSetting(const char* name, float defaultValue) {
+    std::string value = config::Config::getInstance().GetConfigString("TerrainSettings", name);
+    if (value.empty()) {
+        return defaultValue;
+    }
+    char* end    = nullptr;
+    float parsed = std::strtof(value.c_str(), &end);
+    if (end == value.c_str() || *end != '\0' || !std::isfinite(parsed)) {
+        LOG_E("TerrainSettings: %s=%s isn't a number, using %g", name, value.c_str(), defaultValue);
+        return defaultValue;
+    }
+    return parsed;
+}
+
 void TerrainRenderer::OnInit() {
-    uint32_t resolution = 128;
+    uint32_t             resolution = 128;
+    HeightmapNoiseParams noiseParams;
+
+    if (config::Config::getInstance().GetConfigString("TerrainSettings", "TilePack") == "y") {
+        std::string maxMB = config::Config::getInstance().GetConfigString("TerrainSettings", "TilePackMaxMB");
+        uint64_t    maxBytes = (maxMB.empty() ? kDefaultTilePackMaxMB : std::strtoull(maxMB.c_str(), nullptr, 10)) << 20;
+        _tilePack.reset(new TerrainTilePack(fs::GetProcessDirectory() + "tilecache/", {resolution, resolution}, noiseParams, maxBytes));
+        config::ConsoleCommands::getInstance().RegisterCommand("tilepack", [this](const std::vector<std::string>& params) -> std::string {
+            const TerrainTilePack::Stats& stats = _tilePack->GetStats();
+            return "tiles:" + std::to_string(stats.tiles) + " bytes:" + std::to_string(stats.bytes) + " hits:" + std::to_string(stats.hits) +
+                   " misses:" + std::to_string(stats.misses) + " written:" + std::to_string(stats.written) + (stats.full ? " (full)" : "");
+        });
+    }
+
+    _lodParams.tileResolution = resolution;
+    _lodParams.maxScreenError = std::max(0.1f, terrainSetting("MaxScreenError", _lodParams.maxScreenError));
 
-    _producers.elevations.cpu.reset(new CPUElevationDataTileProducer({resolution, resolution}));
-    _producers.elevations.gpu.reset(new ElevationDataTileProducer(device(), _producers.elevations.cpu.get()));
-    _producers.normals.cpu.reset(new CPUNormalDataTileProducer(_producers.elevations.cpu.get()));
+    _prefetchHorizon = std::max(0.f, terrainSetting("PrefetchHorizon", kDefaultPrefetchHorizon));
+    config::ConsoleCommands::getInstance().RegisterCommand("prefetch", [this](const std::vector<std::string>& params) -> std::string {
+        return "elevations " + toString(_producers.elevations.cpu->GetPrefetchStats()) + "\nnormals " + toString(_producers.normals.cpu->GetPrefetchStats());
+    });
+
+    config::ConsoleCommands::getInstance().RegisterCommand("terraincheck", [this](const std::vector<std::string>& params) -> std::string {
+        // params[0] is the command itself
+        long frames = params.size() > 1 ? std::strtol(params[1].c_str(), nullptr, 10) : 1;
+        if (frames <= 0) {
+            return "usage: /terraincheck [frames]";
+        }
+        _checkFrames = static_cast<uint32_t>(frames);
+        _checkStats  = {};
+        return "checking terrain selection against breadth first for " + std::to_string(frames) + " frames, results go to the log";
+    });
+
+    _producers.elevations.cpu.reset(new CPUElevationDataTileProducer({resolution, resolution}, noiseParams, _tilePack.get()));
+    _producers.elevations.gpu.reset(new ElevationDataTileProducer(device(), services()->vertexLayoutCache(), _producers.elevations.cpu.get()));
+    _producers.normals.cpu.reset(new CPUNormalDataTileProducer(_producers.elevations.cpu.get(), _tilePack.get()));
     _producers.normals.gpu.reset(new NormalDataTileProducer(device(), _producers.normals.cpu.get()));
     _renderers.baseLayer.reset(new TerrainElevationLayerRenderer(_producers.elevations.gpu.get(), _producers.normals.gpu.get()));
 
@@ -50,29 +102,25 @@ void TerrainRenderer::Register(TerrainRenderObj* renderObj) { _renderObjs.push_b
 
 void TerrainRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
     _nodesInScene.clear();
+    _keysEntering.clear();
+    _keysLeaving.clear();
 
-    for (const RenderObj* baseRO : view->_visibleObjects) {
-        if (baseRO->GetRendererType() != Renderer::rendererType()) {
-            continue;
-        }
-        
-        const TerrainRenderObj* terrain = static_cast<const TerrainRenderObj*>(baseRO);
-        
+    // terrains out of view still get walked so whatever they had selected leaves
+    for (TerrainRenderObj* terrain : _renderObjs) {
+        bool inView = std::find(begin(view->_visibleObjects), end(view->_visibleObjects), terrain) != end(view->_visibleObjects);
         for (TerrainQuadTree* tree : terrain->getQuadTrees()) {
-            TerrainQuadNodeSelector().SelectQuadNodes(view, tree, &_nodesInScene);
+            SelectorFor(&_selectors, tree).Update(inView ? view : nullptr, &_nodesInScene, &_keysEntering, &_keysLeaving);
         }
     }
 
-    _keysEntering.clear();
-    _keysLeaving.clear();
-    _keysInPrevScene = std::move(_keysInScene);
-
-    for (const TerrainQuadNode* quad : _nodesInScene) {
-        _keysInScene.insert(quad->key);
+    if (_checkFrames > 0) {
+        CheckSelection(view);
     }
 
-    std::set_difference(begin(_keysInPrevScene), end(_keysInPrevScene), begin(_keysInScene), end(_keysInScene), std::inserter(_keysLeaving, begin(_keysLeaving)));
-    std::set_difference(begin(_keysInScene), end(_keysInScene), begin(_keysInPrevScene), end(_keysInPrevScene), std::inserter(_keysEntering, begin(_keysEntering)));
+    for (const TerrainTileKey& key : _keysLeaving) {
+        _keysInScene.erase(key);
+    }
+    _keysInScene.insert(begin(_keysEntering), end(_keysEntering));
 
     // draw nodes in 3D
     for (const TerrainQuadNode* quad : _nodesInScene) {
@@ -109,7 +157,95 @@ void TerrainRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
         producer->Update(_nodesInScene, _keysLeaving, _keysEntering);
     }
 
+    // arrived heights tighten the bounds the next selection culls and measures error against
+    for (const CPUElevationDataTileProducer::HeightRange& arrived : _producers.elevations.cpu->GetArrivedHeightRanges()) {
+        TerrainQuadNode* node = FindNode(arrived.key);
+        if (node != nullptr) {
+            node->SetHeightRange(arrived.range);
+        }
+    }
+
+    // with nothing ahead this still cancels prefetches that stopped being predicted
+    SelectNodesAhead(view);
+    for (DataTileProducer* producer : _tileProducers) {
+        producer->Prefetch(_nodesAhead);
+    }
+
+    // what the producers wrote this frame becomes loadable next frame
+    if (_tilePack != nullptr) {
+        _tilePack->Flush();
+    }
+
     for (TerrainLayerRenderer* layer : _layerRenderers) {
         layer->Submit(renderQueue, view, _nodesInScene);
     }
 }
+
+void TerrainRenderer::SelectNodesAhead(const FrameView* view) {
+    _nodesAhead.clear();
+    _viewPredictor.Update(view);
+    if (_prefetchHorizon <= 0.f || !_viewPredictor.IsMoving(_prefetchHorizon)) {
+        return;
+    }
+
+    std::vector<const TerrainQuadNode*>& selected = _nodesAheadScratch;
+    _keysAhead.clear();
+    for (uint32_t step = 1; step <= kPrefetchSteps; ++step) {
+        FrameView ahead = _viewPredictor.Predict(view, _prefetchHorizon * step / kPrefetchSteps);
+
+        // every terrain, ones behind the camera now can be in front of it then
+        selected.clear();
+        for (TerrainRenderObj* terrain : _renderObjs) {
+            for (TerrainQuadTree* tree : terrain->getQuadTrees()) {
+                SelectorFor(&_aheadSelectors[step - 1], tree).Update(&ahead, &selected, nullptr, nullptr);
+            }
+        }
+
+        for (const TerrainQuadNode* node : selected) {
+            if (_keysInScene.count(node->key) == 0 && _keysAhead.insert(node->key).second) {
+                _nodesAhead.push_back(node);
+            }
+        }
+    }
+}
+
+// runs right after the selectors' Update so both see the same view and height ranges
+void TerrainRenderer::CheckSelection(const FrameView* view) {
+    for (TerrainRenderObj* terrain : _renderObjs) {
+        if (std::find(begin(view->_visibleObjects), end(view->_visibleObjects), terrain) == end(view->_visibleObjects)) {
+            continue;
+        }
+        for (TerrainQuadTree* tree : terrain->getQuadTrees()) {
+            SelectorFor(&_selectors, tree).Check(view, tree, &_checkStats);
+        }
+    }
+
+    if (--_checkFrames > 0) {
+        return;
+    }
+    const TerrainQuadNodeSelector::CheckStats& stats = _checkStats;
+    if (stats.wrong > 0 || stats.missing > 0) {
+        LOG_E("terraincheck: matching:%u held:%u wrong:%u missing:%u", stats.matching, stats.held, stats.wrong, stats.missing);
+    } else {
+        LOG_D("terraincheck: matching:%u held:%u, same as breadth first", stats.matching, stats.held);
+    }
+}
+
+TerrainQuadNodeSelector& TerrainRenderer::SelectorFor(SelectorMap* selectors, TerrainQuadTree* tree) {
+    auto it = selectors->find(tree);
+    if (it == selectors->end()) {
+        it = selectors->emplace(tree, TerrainQuadNodeSelector(tree, _lodParams)).first;
+    }
+    return it->second;
+}
+
+TerrainQuadNode* TerrainRenderer::FindNode(const TerrainTileKey& key) {
+    for (TerrainRenderObj* terrain : _renderObjs) {
+        for (TerrainQuadTree* tree : terrain->getQuadTrees()) {
+            if (tree->terrainId() == key.tid) {
+                return tree->FindNode(key);
+            }
+        }
+    }
+    return nullptr;
+}
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <memory>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "DataTileProducer.h"
 #include "Renderer.h"
@@ -9,6 +10,7 @@
 #include "TerrainQuadNodeSelector.h"
 #include "TerrainQuadTree.h"
 #include "TerrainRenderObj.h"
+#include "TerrainViewPredictor.h"
 
 class TerrainElevationLayerRenderer;
 
@@ -16,9 +18,15 @@ class CPUElevationDataTileProducer;
 class CPUNormalDataTileProducer;
 class NormalDataTileProducer;
 class ElevationDataTileProducer;
+class TerrainTilePack;
 
 class TerrainRenderer : public TypedRenderer<TerrainRenderObj> {
 private:
+    // predicted views between now and the horizon, nodes from the nearer ones are queued first
+    static constexpr uint32_t kPrefetchSteps = 2;
+
+    std::unique_ptr<TerrainTilePack> _tilePack; // null unless TerrainSettings.TilePack is on
+
     struct {
         struct {
             std::unique_ptr<CPUElevationDataTileProducer> cpu;
@@ -40,12 +48,23 @@ private:
     std::vector<DataTileProducer*> _tileProducers;
     std::vector<TerrainLayerRenderer*> _layerRenderers;
 
+    using SelectorMap = std::unordered_map<const TerrainQuadTree*, TerrainQuadNodeSelector>;
+
+    TerrainLodParams                    _lodParams;
+    SelectorMap                         _selectors;
     std::vector<const TerrainQuadNode*> _nodesInScene;
+    std::unordered_set<TerrainTileKey>  _keysInScene;
+    std::vector<TerrainTileKey>         _keysLeaving;
+    std::vector<TerrainTileKey>         _keysEntering;
+    uint32_t                            _checkFrames{0}; // frames left checking selection against breadth first
+    TerrainQuadNodeSelector::CheckStats _checkStats;
 
-    std::set<TerrainTileKey> _keysInPrevScene;
-    std::set<TerrainTileKey> _keysInScene;
-    std::set<TerrainTileKey> _keysLeaving;
-    std::set<TerrainTileKey> _keysEntering;
+    TerrainViewPredictor                _viewPredictor;
+    float                               _prefetchHorizon{0.f}; // seconds, 0 turns prefetching off
+    SelectorMap                         _aheadSelectors[kPrefetchSteps]; // one per step
+    std::vector<const TerrainQuadNode*> _nodesAhead;           // not in scene yet, soonest first
+    std::vector<const TerrainQuadNode*> _nodesAheadScratch;
+    std::unordered_set<TerrainTileKey>  _keysAhead;
 
 public:
     TerrainRenderer();
@@ -55,4 +74,10 @@ public:
     void Register(TerrainRenderObj* renderObj) final;
     void Unregister(TerrainRenderObj* renderObj) final { assert(false); }
     void Submit(RenderQueue* renderQueue, const FrameView* view) final;
+
+private:
+    void                     SelectNodesAhead(const FrameView* view);
+    void                     CheckSelection(const FrameView* view);
+    TerrainQuadNodeSelector& SelectorFor(SelectorMap* selectors, TerrainQuadTree* tree);
+    TerrainQuadNode*         FindNode(const TerrainTileKey& key);
 };
@@ -0,0 +1,236 @@
+#include "TerrainTilePack.h"
+#include <xxhash.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include "DGAssert.h"
+#include "Log.h"
+
+using namespace tilepack;
+
+namespace {
+constexpr uint32_t Align8(uint32_t size) { return (size + 7) & ~7u; }
+
+uint32_t PayloadSize(TerrainLayerType layer, size_t texels) {
+    switch (layer) {
+        case TerrainLayerType::Heightmap: return static_cast<uint32_t>(texels * sizeof(float));
+        case TerrainLayerType::Normalmap: return static_cast<uint32_t>(texels * 3 * sizeof(int16_t));
+        default: return 0;
+    }
+}
+}
+
+TerrainTilePack::TerrainTilePack(const std::string& dir, const glm::uvec2& tileResolution, const HeightmapNoiseParams& params, uint64_t maxBytes)
+    : _maxBytes(maxBytes) {
+    _header.tileWidth   = tileResolution.x;
+    _header.tileHeight  = tileResolution.y;
+    _header.seed        = params.seed;
+    _header.octaveCount = params.octaveCount;
+    _header.frequency   = params.frequency;
+
+    if (!fs::mkdirs(dir)) {
+        LOG_E("TerrainTilePack: couldn't make %s, tiles won't be kept", dir.c_str());
+        return;
+    }
+    RemoveOtherVersions(dir);
+
+    // one pack per header, switching noise back and forth keeps both
+    char name[64];
+    snprintf(name, sizeof(name), "terrain_%016llx.tilepack", static_cast<unsigned long long>(XXH3_64bits(&_header, sizeof(FileHeader))));
+    _path = dir + name;
+
+    if (fs::exists(_path)) {
+        std::shared_ptr<fs::MappedFile> file = std::make_shared<fs::MappedFile>();
+        if (file->Open(_path) && file->size() >= sizeof(FileHeader) && memcmp(file->data(), &_header, sizeof(FileHeader)) == 0) {
+            _file        = std::move(file);
+            _indexedSize = sizeof(FileHeader);
+            IndexRecords();
+        }
+    }
+
+    if (_file == nullptr) {
+        if (!Create()) {
+            return;
+        }
+    } else {
+        // a run that died mid write leaves part of a record on the end, cut it off so appends follow whole records
+        if (_indexedSize < _file->size()) {
+            LOG_E("TerrainTilePack: dropping %llu bytes of partial record from %s", static_cast<unsigned long long>(_file->size() - _indexedSize), _path.c_str());
+            _file.reset();
+            std::error_code error;
+            std::filesystem::resize_file(_path, _indexedSize, error);
+            if (error) {
+                LOG_E("TerrainTilePack: couldn't truncate %s, starting over", _path.c_str());
+                _indexedSize = 0;
+                for (auto& index : _index) {
+                    index.clear();
+                }
+                _stats = Stats();
+                if (!Create()) {
+                    return;
+                }
+            } else {
+                Remap();
+            }
+        }
+        if (!_out.is_open()) {
+            _out.open(_path, std::ios::binary | std::ios::app);
+        }
+    }
+
+    _stats.full = _indexedSize >= _maxBytes;
+    LOG_D("TerrainTilePack: %s has %u tiles (%llu bytes)", _path.c_str(), _stats.tiles, static_cast<unsigned long long>(_stats.bytes));
+}
+
+TerrainTilePack::~TerrainTilePack() { Flush(); }
+
+TerrainTilePack::Tile TerrainTilePack::Find(const TerrainTileKey& key, TerrainLayerType layer) {
+    const std::unordered_map<TerrainTileKey, uint64_t>& index = _index[static_cast<uint32_t>(layer)];
+    auto                                                it    = index.find(key);
+    if (it == index.end() || _file == nullptr) {
+        ++_stats.misses;
+        return Tile();
+    }
+    ++_stats.hits;
+    return {_file, reinterpret_cast<const RecordHeader*>(_file->data() + it->second)};
+}
+
+void TerrainTilePack::WriteHeightmap(const TerrainTileKey& key, const std::vector<float>& heights) {
+    dg_assert(heights.size() == TileTexels(), "heightmap is %zu texels, pack tiles are %zu", heights.size(), TileTexels());
+    Append(key, TerrainLayerType::Heightmap, heights.data(), PayloadSize(TerrainLayerType::Heightmap, heights.size()));
+}
+
+void TerrainTilePack::WriteNormalmap(const TerrainTileKey& key, const std::vector<glm::vec4>& normals) {
+    dg_assert(normals.size() == TileTexels(), "normalmap is %zu texels, pack tiles are %zu", normals.size(), TileTexels());
+    std::vector<int16_t> packed(normals.size() * 3);
+    for (size_t idx = 0; idx < normals.size(); ++idx) {
+        for (int c = 0; c < 3; ++c) {
+            packed[idx * 3 + c] = static_cast<int16_t>(std::lround(std::clamp(normals[idx][c], -1.f, 1.f) * 32767.f));
+        }
+    }
+    Append(key, TerrainLayerType::Normalmap, packed.data(), PayloadSize(TerrainLayerType::Normalmap, normals.size()));
+}
+
+void TerrainTilePack::Flush() {
+    if (_unflushedBytes == 0) {
+        return;
+    }
+    _unflushedBytes = 0;
+    _out.flush();
+    if (_out.fail()) {
+        LOG_E("TerrainTilePack: failed writing %s, not keeping any more tiles", _path.c_str());
+        _out.close();
+    }
+    Remap();
+}
+
+void TerrainTilePack::ReadHeightmap(const Tile& tile, std::vector<float>* heights) {
+    dg_assert_nm(tile && tile.record->layer == TerrainLayerType::Heightmap);
+    heights->resize(tile.record->payloadSize / sizeof(float));
+    memcpy(heights->data(), tile.record + 1, tile.record->payloadSize);
+}
+
+void TerrainTilePack::ReadNormalmap(const Tile& tile, std::vector<glm::vec4>* normals) {
+    dg_assert_nm(tile && tile.record->layer == TerrainLayerType::Normalmap);
+    const int16_t* packed = reinterpret_cast<const int16_t*>(tile.record + 1);
+    normals->resize(tile.record->payloadSize / (3 * sizeof(int16_t)));
+    for (glm::vec4& normal : *normals) {
+        normal = glm::vec4(glm::normalize(glm::vec3(packed[0], packed[1], packed[2])), 0.f);
+        packed += 3;
+    }
+}
+
+// the version is part of the name hash, so packs an older build wrote never get opened again
+void TerrainTilePack::RemoveOtherVersions(const std::string& dir) {
+    for (const std::string& name : fs::ListFilesInDirectory(dir)) {
+        if (name.rfind("terrain_", 0) != 0 || name.size() < 9 || name.compare(name.size() - 9, 9, ".tilepack") != 0) {
+            continue;
+        }
+
+        FileHeader    header;
+        std::ifstream in(dir + name, std::ios::binary);
+        in.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+        bool current = in.good() && header.magic == kMagic && header.version == kVersion;
+        in.close();
+        if (current) {
+            continue;
+        }
+
+        std::error_code error;
+        if (std::filesystem::remove(dir + name, error)) {
+            LOG_D("TerrainTilePack: removed %s, it's from another version", name.c_str());
+        }
+    }
+}
+
+bool TerrainTilePack::Create() {
+    _out.close();
+    _out.open(_path, std::ios::binary | std::ios::trunc);
+    _out.write(reinterpret_cast<const char*>(&_header), sizeof(FileHeader));
+    _out.flush();
+    if (_out.fail()) {
+        LOG_E("TerrainTilePack: couldn't create %s, tiles won't be kept", _path.c_str());
+        _out.close();
+        return false;
+    }
+    _indexedSize = sizeof(FileHeader);
+    Remap();
+    return true;
+}
+
+void TerrainTilePack::Remap() {
+    std::shared_ptr<fs::MappedFile> file = std::make_shared<fs::MappedFile>();
+    if (!file->Open(_path)) {
+        LOG_E("TerrainTilePack: couldn't map %s", _path.c_str());
+        return;
+    }
+    _file = std::move(file);
+    IndexRecords();
+}
+
+// walks whole records from where the last walk stopped, anything past the last one isn't there yet or got cut off
+void TerrainTilePack::IndexRecords() {
+    const uint8_t* data = _file->data();
+    uint64_t       size = _file->size();
+    while (_indexedSize + sizeof(RecordHeader) <= size) {
+        const RecordHeader* record = reinterpret_cast<const RecordHeader*>(data + _indexedSize);
+        uint32_t            layer  = static_cast<uint32_t>(record->layer);
+        if (layer >= kTerrainLayerTypeCount || record->payloadSize != PayloadSize(record->layer, TileTexels())) {
+            break;
+        }
+        uint64_t recordSize = sizeof(RecordHeader) + Align8(record->payloadSize);
+        if (_indexedSize + recordSize > size) {
+            break;
+        }
+
+        TerrainTileKey key(record->tid, record->tx, record->ty, record->lod);
+        if (_index[layer].insert_or_assign(key, _indexedSize).second) {
+            ++_stats.tiles;
+        }
+        _indexedSize += recordSize;
+    }
+    _stats.bytes = _indexedSize;
+}
+
+void TerrainTilePack::Append(const TerrainTileKey& key, TerrainLayerType layer, const void* payload, uint32_t payloadSize) {
+    if (!_out.is_open() || _stats.full) {
+        return;
+    }
+
+    uint64_t recordSize = sizeof(RecordHeader) + Align8(payloadSize);
+    if (_indexedSize + _unflushedBytes + recordSize > _maxBytes) {
+        LOG_D("TerrainTilePack: %s is full, not keeping any more tiles", _path.c_str());
+        _stats.full = true;
+        return;
+    }
+
+    static const char kPadding[8] = {};
+    RecordHeader      record{key.tid, key.tx, key.ty, key.lod, layer, {}, payloadSize};
+    _out.write(reinterpret_cast<const char*>(&record), sizeof(RecordHeader));
+    _out.write(static_cast<const char*>(payload), payloadSize);
+    _out.write(kPadding, Align8(payloadSize) - payloadSize);
+
+    _unflushedBytes += recordSize;
+    ++_stats.written;
+}
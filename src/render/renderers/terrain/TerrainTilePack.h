@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <fstream>
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "File.h"
+#include "GenerateHeightmapTask.h"
+#include "TerrainLayerType.h"
+#include "TerrainTileKey.h"
+
+namespace tilepack {
+// A pack is a FileHeader followed by tile records, each a RecordHeader and its payload padded out to 8 bytes so
+// payloads can be read in place from the mapped file. Records are only ever appended, a key that shows up twice
+// (can't happen from the producers but costs nothing to allow) resolves to the later one.
+//   heightmap  float per texel, exactly what was generated
+//   normalmap  3 snorm16 per texel, renormalized on the way out
+// A pack whose header doesn't match the running version, tile size and noise gets thrown away and started over.
+// Packs for other tile sizes or noise are left alone, packs from another version are deleted on startup.
+
+static constexpr uint32_t kMagic   = 0x50544c50; // "PLTP"
+static constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+    uint32_t magic{kMagic};
+    uint32_t version{kVersion};
+    uint32_t tileWidth{0};
+    uint32_t tileHeight{0};
+    int32_t  seed{0};
+    int32_t  octaveCount{0};
+    double   frequency{0.0};
+};
+
+struct RecordHeader {
+    uint32_t         tid;
+    uint32_t         tx;
+    uint32_t         ty;
+    uint32_t         lod;
+    TerrainLayerType layer;
+    uint8_t          reserved[3]{};
+    uint32_t         payloadSize;
+};
+
+static_assert(sizeof(FileHeader) == 32 && sizeof(RecordHeader) == 24, "pack headers are written raw, keep them unpadded");
+}
+
+// Generated terrain tiles kept on disk between runs. Lookups and writes happen on the frame thread from the cpu
+// producers, reads happen on scheduler workers: a Tile keeps the mapping it points into alive, so a Flush remapping
+// the file under a running load is fine.
+// Written tiles are only findable after the next Flush, which the terrain renderer does once per frame
+class TerrainTilePack {
+public:
+    struct Tile {
+        std::shared_ptr<const fs::MappedFile> file;
+        const tilepack::RecordHeader*         record{nullptr};
+
+        explicit operator bool() const { return record != nullptr; }
+    };
+
+    struct Stats {
+        uint32_t tiles{0};
+        uint32_t hits{0};
+        uint32_t misses{0};
+        uint32_t written{0};
+        uint64_t bytes{0};
+        bool     full{false}; // hit maxBytes, nothing more gets written
+    };
+
+private:
+    std::string                                  _path;
+    tilepack::FileHeader                         _header;
+    std::shared_ptr<const fs::MappedFile>        _file;
+    std::unordered_map<TerrainTileKey, uint64_t> _index[kTerrainLayerTypeCount]; // record offsets in _file
+    uint64_t                                     _indexedSize{0};                // bytes of whole records in _file
+    uint64_t                                     _maxBytes{0};
+    std::ofstream                                _out;
+    uint64_t                                     _unflushedBytes{0};
+    Stats                                        _stats;
+
+public:
+    // opens or starts the pack for these params in dir. Once the pack is maxBytes big new tiles aren't kept anymore
+    TerrainTilePack(const std::string& dir, const glm::uvec2& tileResolution, const HeightmapNoiseParams& params, uint64_t maxBytes);
+    ~TerrainTilePack();
+
+    TerrainTilePack(const TerrainTilePack&) = delete;
+    TerrainTilePack& operator=(const TerrainTilePack&) = delete;
+
+    bool isOpen() const { return _out.is_open(); }
+
+    Tile Find(const TerrainTileKey& key, TerrainLayerType layer);
+
+    void WriteHeightmap(const TerrainTileKey& key, const std::vector<float>& heights);
+    void WriteNormalmap(const TerrainTileKey& key, const std::vector<glm::vec4>& normals);
+    void Flush();
+
+    // any thread
+    static void ReadHeightmap(const Tile& tile, std::vector<float>* heights);
+    static void ReadNormalmap(const Tile& tile, std::vector<glm::vec4>* normals);
+
+    const Stats& GetStats() const { return _stats; }
+
+private:
+    void   RemoveOtherVersions(const std::string& dir);
+    bool   Create();
+    void   Remap();
+    void   IndexRecords();
+    void   Append(const TerrainTileKey& key, TerrainLayerType layer, const void* payload, uint32_t payloadSize);
+    size_t TileTexels() const { return static_cast<size_t>(_header.tileWidth) * _header.tileHeight; }
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtx/rotate_vector.hpp>
+#include "RenderView.h"
+
+// Where the camera will be a little while from now, extrapolated from how it moved between the last few frames.
+// Velocity and turn rate are smoothed over frames so a single jerky frame doesn't throw the prediction across the
+// map; a frame that took too long (hitch, breakpoint, teleport) resets the history instead of turning into a huge
+// velocity
+class TerrainViewPredictor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr float kSmoothing    = 0.25f; // weight of the newest frame
+    static constexpr float kMaxFrameTime = 0.25f; // seconds
+    static constexpr float kMaxTurn      = 1.5707964f; // quarter turn, radians
+
+private:
+    bool              _hasHistory{false};
+    Clock::time_point _lastTime;
+    glm::vec3         _lastEyePos;
+    glm::vec3         _lastLook;
+    glm::vec3         _velocity{0.f};
+    glm::vec3         _turnAxis{0.f, 1.f, 0.f};
+    float             _turnRate{0.f}; // radians per second about _turnAxis
+
+public:
+    void Update(const FrameView* view) { Update(view, Clock::now()); }
+
+    void Update(const FrameView* view, Clock::time_point now) {
+        if (_hasHistory) {
+            float dt = std::chrono::duration<float>(now - _lastTime).count();
+            if (dt <= 0.f) {
+                return;
+            }
+            if (dt > kMaxFrameTime) {
+                _velocity = glm::vec3(0.f);
+                _turnRate = 0.f;
+            } else {
+                _velocity = glm::mix(_velocity, (view->eyePos - _lastEyePos) / dt, kSmoothing);
+
+                glm::vec3 axis     = glm::cross(_lastLook, view->look);
+                float     sinAngle = glm::length(axis);
+                float     turnRate = 0.f;
+                if (sinAngle > 1e-6f) {
+                    // keep turning the same way, a turn that reverses direction starts over from zero
+                    axis = axis / sinAngle;
+                    if (glm::dot(axis, _turnAxis) < 0.f) {
+                        _turnRate = 0.f;
+                    }
+                    _turnAxis = axis;
+                    turnRate  = std::atan2(sinAngle, glm::dot(_lastLook, view->look)) / dt;
+                }
+                _turnRate = glm::mix(_turnRate, turnRate, kSmoothing);
+            }
+        }
+        _hasHistory = true;
+        _lastTime   = now;
+        _lastEyePos = view->eyePos;
+        _lastLook   = view->look;
+    }
+
+    // false when the camera is (near enough) still and the predicted view would just be the current one
+    bool IsMoving(float seconds) const { return glm::length(_velocity) * seconds > 1e-3f || _turnRate * seconds > 1e-3f; }
+
+    // the view seconds from now, same projection and viewport, objects aren't carried over
+    FrameView Predict(const FrameView* view, float seconds) const {
+        float     turn       = glm::min(_turnRate * seconds, kMaxTurn);
+        glm::vec3 up         = {view->view[0][1], view->view[1][1], view->view[2][1]}; // second row of the view rotation
+        glm::vec3 eyePos     = view->eyePos + _velocity * seconds;
+        glm::vec3 look       = glm::normalize(glm::rotate(view->look, turn, _turnAxis));
+        glm::mat4 viewMatrix = glm::lookAt(eyePos, eyePos + look, glm::rotate(up, turn, _turnAxis));
+        return {eyePos, view->projection, viewMatrix, view->ortho, look, {view->projection, viewMatrix}, view->viewport, view->zfar};
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "TerrainTileKey.h"
+
+// Bookkeeping for tiles a cpu producer queued before they were visible. A prefetched key is in flight until its task
+// arrives, then waits to either become visible (hit, or late if it was still in flight) or get evicted unused (wasted).
+// In flight prefetches that stop being predicted get canceled, which also counts as wasted. Frame thread only
+class TilePrefetchTracker {
+public:
+    struct Stats {
+        uint32_t requested{0};
+        uint32_t hits{0};   // resident by the time they were visible
+        uint32_t late{0};   // visible while still in flight
+        uint32_t wasted{0}; // canceled or evicted without ever being visible
+    };
+
+private:
+    std::unordered_set<TerrainTileKey> _inFlight;
+    std::unordered_set<TerrainTileKey> _arrived;
+    Stats                              _stats;
+
+public:
+    size_t       inFlight() const { return _inFlight.size(); }
+    bool         isInFlight(const TerrainTileKey& key) const { return _inFlight.count(key) > 0; }
+    const Stats& GetStats() const { return _stats; }
+
+    void Requested(const TerrainTileKey& key) {
+        _inFlight.insert(key);
+        ++_stats.requested;
+    }
+
+    void Arrived(const TerrainTileKey& key) {
+        if (_inFlight.erase(key) > 0) {
+            _arrived.insert(key);
+        }
+    }
+
+    void Visible(const TerrainTileKey& key) {
+        if (_inFlight.erase(key) > 0) {
+            ++_stats.late;
+        } else if (_arrived.erase(key) > 0) {
+            ++_stats.hits;
+        }
+    }
+
+    void Evicted(const TerrainTileKey& key) {
+        if (_arrived.erase(key) > 0) {
+            ++_stats.wasted;
+        }
+    }
+
+    // in flight keys that aren't wanted anymore, the caller cancels their tasks
+    void TakeStale(const std::unordered_set<TerrainTileKey>& wanted, std::vector<TerrainTileKey>* stale) {
+        for (auto it = begin(_inFlight); it != end(_inFlight);) {
+            if (wanted.count(*it) == 0) {
+                stale->push_back(*it);
+                it = _inFlight.erase(it);
+                ++_stats.wasted;
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
+inline std::string toString(const TilePrefetchTracker::Stats& stats) {
+    uint32_t used = stats.hits + stats.late;
+    return "requested:" + std::to_string(stats.requested) + " hits:" + std::to_string(stats.hits) + " late:" + std::to_string(stats.late) +
+           " wasted:" + std::to_string(stats.wasted) + " hitrate:" + std::to_string(used > 0 ? 100 * stats.hits / used : 0) + "%";
+}
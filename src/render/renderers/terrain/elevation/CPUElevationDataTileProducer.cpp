@@ -3,18 +3,27 @@
 #include "File.h"
 #include "Image.h"
 #include "TaskScheduler.h"
+#include "TerrainTilePack.h"
 
 static const std::string kEDPChannel = "tileproducer.cpuelevation";
 #define EDPLog_W(fmt, ...) LOG(Log::Level::Warn, kEDPChannel, fmt, ##__VA_ARGS__)
 
-CPUElevationDataTileProducer::CPUElevationDataTileProducer(const glm::uvec2& tileResolution)
-    : DataTileProducer(TerrainLayerType::Heightmap, tileResolution) {
+// no point generating more tiles at once than the cpu tile cache holds, the rest get queued on later frames
+static constexpr size_t kMaxTasksInFlight = 256;
+// twice the cap: tasks canceled while already running can still deliver after their key was freed up for another task
+static constexpr size_t kResultQueueCapacity = 2 * kMaxTasksInFlight;
+// prefetches stay well under the cache so they can't push out what's on screen
+static constexpr size_t kMaxPrefetchesInFlight = 32;
+
+CPUElevationDataTileProducer::CPUElevationDataTileProducer(const glm::uvec2& tileResolution, const HeightmapNoiseParams& noiseParams, TerrainTilePack* tilePack)
+    : DataTileProducer(TerrainLayerType::Heightmap, tileResolution), _noiseParams(noiseParams), _tilePack(tilePack) {
     config::ConsoleCommands::getInstance().RegisterCommand("dumphm", [&](const std::vector<std::string>& params) -> std::string {
         this->dumpCachedHeightmapsToDisk();
         return "success";
     });
     _cpuTileBuffer.reset(new HeightmapCPUTileBuffer(DataTileProducer::tileResolution.x, DataTileProducer::tileResolution.y, 256));
     _cpuTileCache.reset(new HeightmapCPUTileCache(_cpuTileBuffer.get(), [&](const TerrainTileKey& key, const HeightmapCPUTileSlot* slot) {
+        _prefetch.Evicted(key);
         auto it = _dataTiles.find(key);
         if (it != end(_dataTiles)) {
             CPUElevationDataTile* tile = it->second;
@@ -23,7 +32,7 @@ CPUElevationDataTileProducer::CPUElevationDataTileProducer(const glm::uvec2& til
             delete tile;
         }
     }));
-    _generateHeightmapTaskOutput.reset(new BlockingQueue<GenerateHeightmapTaskResults>());
+    _generateHeightmapTaskOutput.reset(new MPSCQueue<GenerateHeightmapTaskResults>(kResultQueueCapacity));
 }
 
 CPUElevationDataTile* CPUElevationDataTileProducer::GetTile(const TerrainQuadNode& node) {
@@ -37,13 +46,14 @@ CPUElevationDataTile* CPUElevationDataTileProducer::GetTile(const TerrainQuadNod
     }
 }
 
-void CPUElevationDataTileProducer::Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::set<TerrainTileKey>& keysLeaving,
-                                          const std::set<TerrainTileKey>& keysEntering) {
+void CPUElevationDataTileProducer::Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::vector<TerrainTileKey>& keysLeaving,
+                                          const std::vector<TerrainTileKey>& keysEntering) {
     // process arrivals
     std::vector<GenerateHeightmapTaskResults> completed;
-    _generateHeightmapTaskOutput->flush(&completed);
+    _generateHeightmapTaskOutput->drain(&completed);
+    _arrivedHeightRanges.clear();
 
-    for (const GenerateHeightmapTaskResults& results : completed) {
+    for (GenerateHeightmapTaskResults& results : completed) {
         if (_pendingTasks.find(results.key) == end(_pendingTasks)) {
             EDPLog_W("Processing arrival of unexpected key %s -- skipping", toString(results.key).c_str());
             continue;
@@ -56,9 +66,14 @@ void CPUElevationDataTileProducer::Update(const std::vector<const TerrainQuadNod
         dg_assert_nm(!wasCPUTileInCache);
         dg_assert_nm(elevationDataTile->cpuData);
 
-        elevationDataTile->cpuData->data = results.data;
+        if (_tilePack != nullptr && !results.loaded) {
+            _tilePack->WriteHeightmap(results.key, results.data);
+        }
+        elevationDataTile->cpuData->data = std::move(results.data);
         _dataTiles.insert({results.key, elevationDataTile});
         _pendingTasks.erase(results.key);
+        _prefetch.Arrived(results.key);
+        _arrivedHeightRanges.push_back({results.key, {static_cast<float>(results.min), static_cast<float>(results.max)}});
     }
 
     // push tasks
@@ -76,13 +91,23 @@ void CPUElevationDataTileProducer::Update(const std::vector<const TerrainQuadNod
     for (const TerrainQuadNode* node : nodesInScene) {
         TerrainDataTile* tile = GetTile(*node);
         if (tile == nullptr) {
-            if (_pendingTasks.find(node->key) != end(_pendingTasks)) {
-                continue;
+            auto pending = _pendingTasks.find(node->key);
+            if (pending != end(_pendingTasks)) {
+                // a prefetch that hasn't started would wait behind every other low priority task, queue it again as visible
+                if (!_prefetch.isInFlight(node->key) || pending->second->state() != TaskState::Pending) {
+                    continue;
+                }
+                pending->second->tryCancel();
+                _pendingTasks.erase(pending);
             }
 
             HeightmapCPUTileSlot* cpuSlot = _cpuTileCache->find(node->key);
             if (cpuSlot == nullptr) {
-                TaskPtr task = std::make_shared<GenerateHeightmapTask>(node->key, node->sampleRect, DataTileProducer::tileResolution, _generateHeightmapTaskOutput.get());
+                if (_pendingTasks.size() >= kMaxTasksInFlight) {
+                    continue;
+                }
+                TaskPtr task = MakeTileTask(node);
+                task->setPriority(TaskPriority::High); // visible this frame
                 _pendingTasks.emplace(node->key, task);
                 tasksToQueue.push_back(task);
             } else {
@@ -98,8 +123,78 @@ void CPUElevationDataTileProducer::Update(const std::vector<const TerrainQuadNod
     }
 
     if (tasksToQueue.size() > 0) {
-        scheduler()->queue()->enqueueAll(tasksToQueue);
+        scheduler()->enqueueAll(tasksToQueue);
+    }
+
+    // after the requeues above, they need to know which keys were still prefetching
+    for (const TerrainTileKey& key : keysEntering) {
+        _prefetch.Visible(key);
+    }
+}
+
+// runs behind everything visible, tiles arrive the same way and wait in the cache to be picked up by Update
+void CPUElevationDataTileProducer::Prefetch(const std::vector<const TerrainQuadNode*>& nodesAhead) {
+    std::unordered_set<TerrainTileKey> wanted;
+    for (const TerrainQuadNode* node : nodesAhead) {
+        wanted.insert(node->key);
+    }
+
+    std::vector<TerrainTileKey> stale;
+    _prefetch.TakeStale(wanted, &stale);
+    for (const TerrainTileKey& key : stale) {
+        auto it = _pendingTasks.find(key);
+        if (it != end(_pendingTasks)) {
+            it->second->tryCancel();
+            _pendingTasks.erase(it);
+        }
+    }
+
+    std::vector<TaskPtr> tasksToQueue;
+    for (const TerrainQuadNode* node : nodesAhead) {
+        if (_prefetch.inFlight() >= kMaxPrefetchesInFlight || _pendingTasks.size() >= kMaxTasksInFlight) {
+            break;
+        }
+        if (_dataTiles.find(node->key) != end(_dataTiles) || _pendingTasks.find(node->key) != end(_pendingTasks) || _cpuTileCache->find(node->key) != nullptr) {
+            continue;
+        }
+
+        TaskPtr task = MakeTileTask(node);
+        task->setPriority(TaskPriority::Low);
+        _pendingTasks.emplace(node->key, task);
+        _prefetch.Requested(node->key);
+        tasksToQueue.push_back(task);
+    }
+
+    if (tasksToQueue.size() > 0) {
+        scheduler()->enqueueAll(tasksToQueue);
+    }
+}
+
+TaskPtr CPUElevationDataTileProducer::MakeTileTask(const TerrainQuadNode* node) {
+    TaskPtr task = LoadFromTilePack(node->key);
+    if (task == nullptr) {
+        task = makeTask<GenerateHeightmapTask>(node->key, node->sampleRect, DataTileProducer::tileResolution, _noiseParams, _generateHeightmapTaskOutput.get());
+    }
+    return task;
+}
+
+// a copy out of the mapped pack on a worker, page faults and all, arriving through the same queue generated tiles do
+TaskPtr CPUElevationDataTileProducer::LoadFromTilePack(const TerrainTileKey& key) {
+    TerrainTilePack::Tile packed = _tilePack != nullptr ? _tilePack->Find(key, TerrainLayerType::Heightmap) : TerrainTilePack::Tile();
+    if (!packed) {
+        return nullptr;
     }
+
+    MPSCQueue<GenerateHeightmapTaskResults>* output = _generateHeightmapTaskOutput.get();
+    return makeTask<LambdaTask>([packed, key, output]() {
+        GenerateHeightmapTaskResults results(key);
+        TerrainTilePack::ReadHeightmap(packed, &results.data);
+        auto range     = std::minmax_element(begin(results.data), end(results.data));
+        results.min    = *range.first;
+        results.max    = *range.second;
+        results.loaded = true;
+        output->enqueue(std::move(results));
+    });
 }
 
 CPUElevationDataTile* CPUElevationDataTileProducer::FindTile(const TerrainTileKey& key) {
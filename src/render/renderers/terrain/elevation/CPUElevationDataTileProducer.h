@@ -2,7 +2,7 @@
 
 #include <memory>
 #include <vector>
-#include "BlockingQueue.h"
+#include "MPSCQueue.h"
 #include "DataTileProducer.h"
 #include "ElevationDataTile.h"
 #include "GPUTileBuffer.h"
@@ -10,8 +10,17 @@
 #include "MeshGeometry.h"
 #include "RenderDevice.h"
 #include "TileCache.h"
+#include "TilePrefetchTracker.h"
+
+class TerrainTilePack;
 
 class CPUElevationDataTileProducer : public DataTileProducer, public DataTileSampler<CPUElevationDataTile> {
+public:
+    struct HeightRange {
+        TerrainTileKey key;
+        glm::vec2      range; // min, max
+    };
+
 private:
     using HeightmapCPUTileBuffer = CPUTileBuffer<float>;
     using HeightmapCPUTileCache  = CPUTileCache<TerrainTileKey, float>;
@@ -20,24 +29,37 @@ private:
 private:
     std::unordered_map<TerrainTileKey, TaskPtr> _pendingTasks;
 
-    std::unique_ptr<BlockingQueue<GenerateHeightmapTaskResults>> _generateHeightmapTaskOutput;
+    std::unique_ptr<MPSCQueue<GenerateHeightmapTaskResults>> _generateHeightmapTaskOutput;
 
     std::map<TerrainTileKey, CPUElevationDataTile*> _dataTiles;
     std::unique_ptr<HeightmapCPUTileBuffer> _cpuTileBuffer;
     std::unique_ptr<HeightmapCPUTileCache>  _cpuTileCache;
 
+    const HeightmapNoiseParams _noiseParams;
+    TerrainTilePack*           _tilePack{nullptr}; // tiles load from here before they're generated, can be null
+
+    TilePrefetchTracker      _prefetch;
+    std::vector<HeightRange> _arrivedHeightRanges;
+
 public:
-    CPUElevationDataTileProducer(const glm::uvec2& tileResolution);
+    CPUElevationDataTileProducer(const glm::uvec2& tileResolution, const HeightmapNoiseParams& noiseParams, TerrainTilePack* tilePack);
     ~CPUElevationDataTileProducer() {}
 
     // DataTileProducer interface
     virtual CPUElevationDataTile* GetTile(const TerrainQuadNode& node) final;
-    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::set<TerrainTileKey>& keysLeaving,
-                        const std::set<TerrainTileKey>& keysEntering) final;
+    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::vector<TerrainTileKey>& keysLeaving,
+                        const std::vector<TerrainTileKey>& keysEntering) final;
+    virtual void Prefetch(const std::vector<const TerrainQuadNode*>& nodesAhead) final;
+
+    const TilePrefetchTracker::Stats& GetPrefetchStats() const { return _prefetch.GetStats(); }
+    // heights of the tiles that arrived in the last Update
+    const std::vector<HeightRange>& GetArrivedHeightRanges() const { return _arrivedHeightRanges; }
 
     // DataTileSampler interface
     virtual CPUElevationDataTile* FindTile(const TerrainTileKey& key) final;
 
 private:
-    void dumpCachedHeightmapsToDisk();
+    TaskPtr MakeTileTask(const TerrainQuadNode* node);
+    TaskPtr LoadFromTilePack(const TerrainTileKey& key);
+    void    dumpCachedHeightmapsToDisk();
 };
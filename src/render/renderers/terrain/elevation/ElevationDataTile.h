@@ -1,6 +1,5 @@
 #pragma once
 
-#include "ConstantBuffer.h"
 #include "GPUTileBuffer.h"
 #include "MeshGeometry.h"
 #include "TerrainDataTile.h"
@@ -14,7 +13,6 @@ public:
 
     GPUTileSlot<gfx::PixelFormat::R32Float>* gpuData{nullptr};
     MeshGeometry*                            geometry{nullptr};
-    ConstantBuffer*                          perTileConstants{nullptr};
     std::unique_ptr<const gfx::StateGroup>   stateGroup;
     gfx::DrawItemPtr                         drawItem;
 };
@@ -8,7 +8,7 @@
 static const std::string kEDPChannel = "tileproducer.elevation";
 #define EDPLog_W(fmt, ...) LOG(Log::Level::Warn, kEDPChannel, fmt, ##__VA_ARGS__)
 
-ElevationDataTileProducer::ElevationDataTileProducer(gfx::RenderDevice* device, CPUElevationDataTileProducer* cpuElevationDataTileProducer)
+ElevationDataTileProducer::ElevationDataTileProducer(gfx::RenderDevice* device, VertexLayoutCache* vertexLayouts, CPUElevationDataTileProducer* cpuElevationDataTileProducer)
     : DataTileProducer(TerrainLayerType::Heightmap, cpuElevationDataTileProducer->tileResolution)
     , _device(device)
     , _dataProducer(cpuElevationDataTileProducer) {
@@ -26,7 +26,7 @@ ElevationDataTileProducer::ElevationDataTileProducer(gfx::RenderDevice* device,
 
     MeshGeometryData geometryData;
     dgen::GenerateGrid(glm::vec3(0, 0, 0), {2, 2}, DataTileProducer::tileResolution, &geometryData);
-    _tileGeometry.reset(new MeshGeometry(_device, {geometryData}));
+    _tileGeometry.reset(new MeshGeometry(_device, vertexLayouts, {geometryData}));
 }
 
 ElevationDataTileProducer::~ElevationDataTileProducer() {}
@@ -42,8 +42,8 @@ GPUElevationDataTile* ElevationDataTileProducer::GetTile(const TerrainQuadNode&
     }
 }
 
-void ElevationDataTileProducer::Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::set<TerrainTileKey>& keysLeaving,
-                                       const std::set<TerrainTileKey>& keysEntering) {
+void ElevationDataTileProducer::Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::vector<TerrainTileKey>& keysLeaving,
+                                       const std::vector<TerrainTileKey>& keysEntering) {
     for (const TerrainQuadNode* node : nodesInScene) {
         TerrainDataTile* tile = GetTile(*node);
         if (tile == nullptr) {
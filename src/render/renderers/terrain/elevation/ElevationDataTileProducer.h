@@ -2,7 +2,6 @@
 
 #include <memory>
 #include <vector>
-#include "BlockingQueue.h"
 #include "CPUElevationDataTileProducer.h"
 #include "DataTileProducer.h"
 #include "ElevationDataTile.h"
@@ -33,13 +32,13 @@ private:
     std::unique_ptr<MeshGeometry> _tileGeometry;
 
 public:
-    ElevationDataTileProducer(gfx::RenderDevice* device, CPUElevationDataTileProducer* cpuElevationDataTileProducer);
+    ElevationDataTileProducer(gfx::RenderDevice* device, VertexLayoutCache* vertexLayouts, CPUElevationDataTileProducer* cpuElevationDataTileProducer);
     ~ElevationDataTileProducer();
 
     // DataTileProducer interface
     virtual GPUElevationDataTile* GetTile(const TerrainQuadNode& node) final;
-    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::set<TerrainTileKey>& keysLeaving,
-                        const std::set<TerrainTileKey>& keysEntering) final;
+    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::vector<TerrainTileKey>& keysLeaving,
+                        const std::vector<TerrainTileKey>& keysEntering) final;
 
     // DataTileSampler interface
     virtual GPUElevationDataTile* FindTile(const TerrainTileKey& key) final;
@@ -1,40 +1,57 @@
 #include "GenerateHeightmapTask.h"
+#include <algorithm>
+
+// samples are scaled by a float, kept as one so the heights don't move
+static constexpr double kSampleScale = 0.005f;
 
 GenerateHeightmapTask::GenerateHeightmapTask(const TerrainTileKey& key, const dm::Rect3Dd& region, const glm::uvec2& resolution,
-                                             BlockingQueue<GenerateHeightmapTaskResults>* outputQueue)
+                                             const HeightmapNoiseParams& params, MPSCQueue<GenerateHeightmapTaskResults>* outputQueue)
     : _results({key}), _region(region), _resolution(resolution), _outputQueue(outputQueue) {
 
-    _noise.SetSeed(32);
-    _noise.SetFrequency(0.05);
-    _noise.SetOctaveCount(8);
+    _noise.SetSeed(params.seed);
+    _noise.SetFrequency(params.frequency);
+    _noise.SetOctaveCount(params.octaveCount);
 }
 
 void GenerateHeightmapTask::execute() {
     double dx = _region.width() / (double)(_resolution.x - 1);
     double dy = _region.height() / (double)(_resolution.y - 1);
 
+    // a row's positions are laid out x, y, z, then the noise for them
+    std::vector<double> row(_resolution.x * 4);
+    double*             xs     = row.data();
+    double*             ys     = xs + _resolution.x;
+    double*             zs     = ys + _resolution.x;
+    double*             values = zs + _resolution.x;
+
+    _results.data.reserve(_resolution.x * _resolution.y);
     for (uint32_t i = 0; i < _resolution.y; ++i) {
+        if (isCanceled()) {
+            return;
+        }
+
         double     t1       = dy * i / _region.height();
         glm::dvec3 rowStart = dm::lerp(_region.bl(), _region.tl(), t1);
         glm::dvec3 rowEnd   = dm::lerp(_region.br(), _region.tr(), t1);
 
+        // dm::lerp(rowStart, rowEnd, t2) per axis
+        for (uint32_t j = 0; j < _resolution.x; ++j) {
+            double t2 = dx * j / _region.width();
+            xs[j]     = (((1.f - t2) * rowStart.x) + (t2 * rowEnd.x)) * kSampleScale;
+            ys[j]     = (((1.f - t2) * rowStart.y) + (t2 * rowEnd.y)) * kSampleScale;
+            zs[j]     = (((1.f - t2) * rowStart.z) + (t2 * rowEnd.z)) * kSampleScale;
+        }
+
+        _noise.GetValues(xs, ys, zs, values, _resolution.x);
+
         for (uint32_t j = 0; j < _resolution.x; ++j) {
-            double     t2     = dx * j / _region.width();
-            glm::dvec3 sample = dm::lerp(rowStart, rowEnd, t2);
-            sample *= 0.005f;
-            double val = _noise.GetValue(sample.x, sample.y, sample.z);
-
-            if (val > _results.max) {
-                _results.max = val;
-            } else if (val < _results.min) {
-                _results.min = val;
-            }
-
-            _results.data.push_back(val);
+            _results.min = std::min(_results.min, values[j]);
+            _results.max = std::max(_results.max, values[j]);
+            _results.data.push_back(values[j]);
         }
     }
 
     if (!isCanceled()) {
-        _outputQueue->enqueue(_results);
+        _outputQueue->enqueue(std::move(_results));
     }
 }
@@ -1,34 +1,44 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include <noise/noise.h>
+#include <limits>
 #include <vector>
-#include "BlockingQueue.h"
+#include "MPSCQueue.h"
 #include "Rectangle.h"
+#include "RidgedNoise.h"
 #include "Task.h"
 #include "TerrainTileKey.h"
 
+// the noise heightmaps are generated from, tiles kept on disk are only good for the params they were made with
+struct HeightmapNoiseParams {
+    int32_t seed{32};
+    int32_t octaveCount{8};
+    double  frequency{0.05};
+};
+
 class GenerateHeightmapTaskResults {
 public:
     GenerateHeightmapTaskResults(const TerrainTileKey& key) : key(key) {}
 
     TerrainTileKey     key;
     double             min{std::numeric_limits<double>::max()};
-    double             max{std::numeric_limits<double>::min()};
+    double             max{std::numeric_limits<double>::lowest()};
     std::vector<float> data;
+    bool               loaded{false}; // read back from the tile pack rather than generated
 };
 
 class GenerateHeightmapTask : public Task {
 private:
     GenerateHeightmapTaskResults _results;
 
-    const dm::Rect3Dd          _region;
-    const glm::uvec2           _resolution;
-    noise::module::RidgedMulti _noise;
+    const dm::Rect3Dd _region;
+    const glm::uvec2  _resolution;
+    RidgedNoise       _noise;
 
-    BlockingQueue<GenerateHeightmapTaskResults>* _outputQueue{nullptr};
+    MPSCQueue<GenerateHeightmapTaskResults>* _outputQueue{nullptr};
 
 public:
-    GenerateHeightmapTask(const TerrainTileKey& key, const dm::Rect3Dd& region, const glm::uvec2& resolution, BlockingQueue<GenerateHeightmapTaskResults>* outputQueue);
+    GenerateHeightmapTask(const TerrainTileKey& key, const dm::Rect3Dd& region, const glm::uvec2& resolution, const HeightmapNoiseParams& params,
+                          MPSCQueue<GenerateHeightmapTaskResults>* outputQueue);
     virtual void execute() final;
 };
@@ -0,0 +1,472 @@
+#include "RidgedNoise.h"
+#include <noise/noise.h>
+#include <cmath>
+#include "DGAssert.h"
+#include "Log.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RIDGED_NOISE_X86 1
+#include <immintrin.h>
+#include "CpuId.h"
+#endif
+
+#if defined(RIDGED_NOISE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RIDGED_NOISE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define RIDGED_NOISE_TARGET(isa)
+#endif
+
+namespace {
+// libnoise's noisegen.cpp constants
+constexpr uint32_t kXNoiseGen     = 1619;
+constexpr uint32_t kYNoiseGen     = 31337;
+constexpr uint32_t kZNoiseGen     = 6971;
+constexpr uint32_t kSeedNoiseGen  = 1013;
+constexpr uint32_t kShiftNoiseGen = 8;
+
+constexpr double kOffset   = 1.0;
+constexpr double kGain     = 2.0;
+constexpr double kInt32Max = 1073741824.0; // MakeInt32Range wraps past 2^30
+
+// one of libnoise's random vectors, already scaled by the 2.12 GradientNoise3D ends with. padded to 32 bytes so a
+// gradient is one aligned avx load or two sse ones
+struct alignas(32) Gradient {
+    double x, y, z, pad;
+};
+
+uint32_t VectorIndex(int ix, int iy, int iz, int seed) {
+    uint32_t v = kXNoiseGen * static_cast<uint32_t>(ix) + kYNoiseGen * static_cast<uint32_t>(iy) + kZNoiseGen * static_cast<uint32_t>(iz) +
+                 kSeedNoiseGen * static_cast<uint32_t>(seed);
+    // libnoise shifts a signed int, only bits 8-15 survive the mask so the sign bits it drags in don't matter
+    return (v ^ (v >> kShiftNoiseGen)) & 0xff;
+}
+
+// g_randomVectors isn't exported. GradientNoise3D with the point one unit down an axis from the lattice corner gives
+// back that component times 2.12, walking ix finds a corner that hashes to every index
+const Gradient* Gradients() {
+    static const Gradient* gradients = [] {
+        static Gradient table[256];
+        bool            found[256] = {};
+        uint32_t        remaining  = 256;
+        for (int ix = 0; ix < 0x10000 && remaining > 0; ++ix) {
+            uint32_t idx = VectorIndex(ix, 0, 0, 0);
+            if (found[idx]) {
+                continue;
+            }
+            double fx  = static_cast<double>(ix);
+            table[idx] = {noise::GradientNoise3D(fx + 1.0, 0.0, 0.0, ix, 0, 0, 0), noise::GradientNoise3D(fx, 1.0, 0.0, ix, 0, 0, 0),
+                          noise::GradientNoise3D(fx, 0.0, 1.0, ix, 0, 0, 0), 0.0};
+            found[idx] = true;
+            --remaining;
+        }
+        dg_assert(remaining == 0, "%u gradients not found", remaining);
+        return table;
+    }();
+    return gradients;
+}
+
+double MakeInt32Range(double n) {
+    if (n >= kInt32Max) {
+        return (2.0 * std::fmod(n, kInt32Max)) - kInt32Max;
+    } else if (n <= -kInt32Max) {
+        return (2.0 * std::fmod(n, kInt32Max)) + kInt32Max;
+    }
+    return n;
+}
+
+double SCurve3(double a) { return (a * a * (3.0 - 2.0 * a)); }
+double LinearInterp(double n0, double n1, double a) { return ((1.0 - a) * n0) + (a * n1); }
+
+double GradientNoise(const Gradient* gradients, double fx, double fy, double fz, int ix, int iy, int iz, int seed) {
+    const Gradient& g = gradients[VectorIndex(ix, iy, iz, seed)];
+    return (g.x * (fx - static_cast<double>(ix))) + (g.y * (fy - static_cast<double>(iy))) + (g.z * (fz - static_cast<double>(iz)));
+}
+
+double CoherentNoise(const Gradient* gradients, double x, double y, double z, int seed) {
+    int x0 = (x > 0.0 ? static_cast<int>(x) : static_cast<int>(x) - 1);
+    int y0 = (y > 0.0 ? static_cast<int>(y) : static_cast<int>(y) - 1);
+    int z0 = (z > 0.0 ? static_cast<int>(z) : static_cast<int>(z) - 1);
+    int x1 = x0 + 1;
+    int y1 = y0 + 1;
+    int z1 = z0 + 1;
+
+    double xs = SCurve3(x - static_cast<double>(x0));
+    double ys = SCurve3(y - static_cast<double>(y0));
+    double zs = SCurve3(z - static_cast<double>(z0));
+
+    double ix0 = LinearInterp(GradientNoise(gradients, x, y, z, x0, y0, z0, seed), GradientNoise(gradients, x, y, z, x1, y0, z0, seed), xs);
+    double ix1 = LinearInterp(GradientNoise(gradients, x, y, z, x0, y1, z0, seed), GradientNoise(gradients, x, y, z, x1, y1, z0, seed), xs);
+    double iy0 = LinearInterp(ix0, ix1, ys);
+    ix0        = LinearInterp(GradientNoise(gradients, x, y, z, x0, y0, z1, seed), GradientNoise(gradients, x, y, z, x1, y0, z1, seed), xs);
+    ix1        = LinearInterp(GradientNoise(gradients, x, y, z, x0, y1, z1, seed), GradientNoise(gradients, x, y, z, x1, y1, z1, seed), xs);
+    double iy1 = LinearInterp(ix0, ix1, ys);
+    return LinearInterp(iy0, iy1, zs);
+}
+
+double Ridged(const RidgedNoise::Settings& s, const Gradient* gradients, double x, double y, double z) {
+    x *= s.frequency;
+    y *= s.frequency;
+    z *= s.frequency;
+
+    double value  = 0.0;
+    double weight = 1.0;
+    for (int octave = 0; octave < s.octaveCount; ++octave) {
+        int    seed   = (s.seed + octave) & 0x7fffffff;
+        double signal = CoherentNoise(gradients, MakeInt32Range(x), MakeInt32Range(y), MakeInt32Range(z), seed);
+
+        signal = kOffset - std::fabs(signal);
+        signal *= signal;
+        signal *= weight;
+
+        weight = signal * kGain;
+        if (weight > 1.0) {
+            weight = 1.0;
+        }
+        if (weight < 0.0) {
+            weight = 0.0;
+        }
+
+        value += (signal * s.spectralWeights[octave]);
+
+        x *= s.lacunarity;
+        y *= s.lacunarity;
+        z *= s.lacunarity;
+    }
+    return (value * 1.25) - 1.0;
+}
+
+void RidgedRowScalar(const RidgedNoise::Settings& s, const double* x, const double* y, const double* z, double* out, size_t count) {
+    const Gradient* gradients = Gradients();
+    for (size_t idx = 0; idx < count; ++idx) {
+        out[idx] = Ridged(s, gradients, x[idx], y[idx], z[idx]);
+    }
+}
+
+#ifdef RIDGED_NOISE_X86
+// ---- SSE4.1, 2 samples
+// every step is the scalar one in the same order, so a lane comes out the same as Ridged() for that sample
+
+RIDGED_NOISE_TARGET("sse4.1")
+inline __m128d SCurve3SSE(__m128d a) {
+    return _mm_mul_pd(_mm_mul_pd(a, a), _mm_sub_pd(_mm_set1_pd(3.0), _mm_mul_pd(_mm_set1_pd(2.0), a)));
+}
+
+RIDGED_NOISE_TARGET("sse4.1")
+inline __m128d LinearInterpSSE(__m128d n0, __m128d n1, __m128d a) {
+    return _mm_add_pd(_mm_mul_pd(_mm_sub_pd(_mm_set1_pd(1.0), a), n0), _mm_mul_pd(a, n1));
+}
+
+// x > 0 ? (int)x : (int)x - 1, as a double
+RIDGED_NOISE_TARGET("sse4.1")
+inline __m128d LatticeSSE(__m128d v) {
+    __m128d truncated = _mm_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    return _mm_sub_pd(truncated, _mm_and_pd(_mm_cmple_pd(v, _mm_setzero_pd()), _mm_set1_pd(1.0)));
+}
+
+RIDGED_NOISE_TARGET("sse4.1")
+inline __m128d GradientNoiseSSE(const Gradient* gradients, __m128i hash, __m128d px, __m128d py, __m128d pz) {
+    __m128i         idx = _mm_and_si128(_mm_xor_si128(hash, _mm_srli_epi32(hash, kShiftNoiseGen)), _mm_set1_epi32(0xff));
+    const Gradient& g0  = gradients[_mm_cvtsi128_si32(idx)];
+    const Gradient& g1  = gradients[_mm_extract_epi32(idx, 1)];
+    __m128d         xy0 = _mm_load_pd(&g0.x);
+    __m128d         xy1 = _mm_load_pd(&g1.x);
+    __m128d         gz  = _mm_unpacklo_pd(_mm_load_pd(&g0.z), _mm_load_pd(&g1.z));
+    __m128d         dot = _mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(xy0, xy1), px), _mm_mul_pd(_mm_unpackhi_pd(xy0, xy1), py));
+    return _mm_add_pd(dot, _mm_mul_pd(gz, pz));
+}
+
+RIDGED_NOISE_TARGET("sse4.1")
+__m128d CoherentNoiseSSE(const Gradient* gradients, __m128d x, __m128d y, __m128d z, int seed) {
+    __m128d one = _mm_set1_pd(1.0);
+    __m128d x0  = LatticeSSE(x);
+    __m128d y0  = LatticeSSE(y);
+    __m128d z0  = LatticeSSE(z);
+
+    // corner offsets, fx - (double)ix
+    __m128d px0 = _mm_sub_pd(x, x0);
+    __m128d py0 = _mm_sub_pd(y, y0);
+    __m128d pz0 = _mm_sub_pd(z, z0);
+    __m128d px1 = _mm_sub_pd(x, _mm_add_pd(x0, one));
+    __m128d py1 = _mm_sub_pd(y, _mm_add_pd(y0, one));
+    __m128d pz1 = _mm_sub_pd(z, _mm_add_pd(z0, one));
+
+    __m128d xs = SCurve3SSE(px0);
+    __m128d ys = SCurve3SSE(py0);
+    __m128d zs = SCurve3SSE(pz0);
+
+    // the hash is a sum of per axis terms mod 2^32, corner +1 is the axis constant added on
+    __m128i xGen = _mm_set1_epi32(static_cast<int>(kXNoiseGen));
+    __m128i yGen = _mm_set1_epi32(static_cast<int>(kYNoiseGen));
+    __m128i zGen = _mm_set1_epi32(static_cast<int>(kZNoiseGen));
+    __m128i hx0  = _mm_mullo_epi32(_mm_cvttpd_epi32(x0), xGen);
+    __m128i hy0  = _mm_mullo_epi32(_mm_cvttpd_epi32(y0), yGen);
+    __m128i hz0  = _mm_add_epi32(_mm_mullo_epi32(_mm_cvttpd_epi32(z0), zGen), _mm_set1_epi32(static_cast<int>(kSeedNoiseGen * static_cast<uint32_t>(seed))));
+    __m128i hx1  = _mm_add_epi32(hx0, xGen);
+    __m128i hy1  = _mm_add_epi32(hy0, yGen);
+    __m128i hz1  = _mm_add_epi32(hz0, zGen);
+
+    __m128i h00 = _mm_add_epi32(hy0, hz0);
+    __m128i h10 = _mm_add_epi32(hy1, hz0);
+    __m128i h01 = _mm_add_epi32(hy0, hz1);
+    __m128i h11 = _mm_add_epi32(hy1, hz1);
+
+    __m128d ix0 = LinearInterpSSE(GradientNoiseSSE(gradients, _mm_add_epi32(hx0, h00), px0, py0, pz0),
+                                  GradientNoiseSSE(gradients, _mm_add_epi32(hx1, h00), px1, py0, pz0), xs);
+    __m128d ix1 = LinearInterpSSE(GradientNoiseSSE(gradients, _mm_add_epi32(hx0, h10), px0, py1, pz0),
+                                  GradientNoiseSSE(gradients, _mm_add_epi32(hx1, h10), px1, py1, pz0), xs);
+    __m128d iy0 = LinearInterpSSE(ix0, ix1, ys);
+    ix0         = LinearInterpSSE(GradientNoiseSSE(gradients, _mm_add_epi32(hx0, h01), px0, py0, pz1),
+                                  GradientNoiseSSE(gradients, _mm_add_epi32(hx1, h01), px1, py0, pz1), xs);
+    ix1         = LinearInterpSSE(GradientNoiseSSE(gradients, _mm_add_epi32(hx0, h11), px0, py1, pz1),
+                                  GradientNoiseSSE(gradients, _mm_add_epi32(hx1, h11), px1, py1, pz1), xs);
+    __m128d iy1 = LinearInterpSSE(ix0, ix1, ys);
+    return LinearInterpSSE(iy0, iy1, zs);
+}
+
+// lanes past 2^30 go through MakeInt32Range one at a time, coordinates that big don't come up on a planet
+RIDGED_NOISE_TARGET("sse4.1")
+inline __m128d MakeInt32RangeSSE(__m128d v) {
+    __m128d magnitude = _mm_andnot_pd(_mm_set1_pd(-0.0), v);
+    if (_mm_movemask_pd(_mm_cmpge_pd(magnitude, _mm_set1_pd(kInt32Max))) == 0) {
+        return v;
+    }
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, v);
+    return _mm_setr_pd(MakeInt32Range(lanes[0]), MakeInt32Range(lanes[1]));
+}
+
+RIDGED_NOISE_TARGET("sse4.1")
+void RidgedRowSSE41(const RidgedNoise::Settings& s, const double* xs, const double* ys, const double* zs, double* out, size_t count) {
+    const Gradient* gradients  = Gradients();
+    const __m128d   one        = _mm_set1_pd(1.0);
+    const __m128d   zero       = _mm_setzero_pd();
+    const __m128d   signMask   = _mm_set1_pd(-0.0);
+    const __m128d   gain       = _mm_set1_pd(kGain);
+    const __m128d   frequency  = _mm_set1_pd(s.frequency);
+    const __m128d   lacunarity = _mm_set1_pd(s.lacunarity);
+
+    size_t idx = 0;
+    for (; idx + 2 <= count; idx += 2) {
+        __m128d x = _mm_mul_pd(_mm_loadu_pd(xs + idx), frequency);
+        __m128d y = _mm_mul_pd(_mm_loadu_pd(ys + idx), frequency);
+        __m128d z = _mm_mul_pd(_mm_loadu_pd(zs + idx), frequency);
+
+        __m128d value  = zero;
+        __m128d weight = one;
+        for (int octave = 0; octave < s.octaveCount; ++octave) {
+            int     seed   = (s.seed + octave) & 0x7fffffff;
+            __m128d signal = CoherentNoiseSSE(gradients, MakeInt32RangeSSE(x), MakeInt32RangeSSE(y), MakeInt32RangeSSE(z), seed);
+
+            signal = _mm_sub_pd(one, _mm_andnot_pd(signMask, signal));
+            signal = _mm_mul_pd(signal, signal);
+            signal = _mm_mul_pd(signal, weight);
+            weight = _mm_max_pd(_mm_min_pd(_mm_mul_pd(signal, gain), one), zero);
+            value  = _mm_add_pd(value, _mm_mul_pd(signal, _mm_set1_pd(s.spectralWeights[octave])));
+
+            x = _mm_mul_pd(x, lacunarity);
+            y = _mm_mul_pd(y, lacunarity);
+            z = _mm_mul_pd(z, lacunarity);
+        }
+        _mm_storeu_pd(out + idx, _mm_sub_pd(_mm_mul_pd(value, _mm_set1_pd(1.25)), one));
+    }
+    RidgedRowScalar(s, xs + idx, ys + idx, zs + idx, out + idx, count - idx);
+}
+
+// ---- AVX2, 4 samples, the SSE path twice as wide
+
+RIDGED_NOISE_TARGET("avx2")
+inline __m256d SCurve3AVX(__m256d a) {
+    return _mm256_mul_pd(_mm256_mul_pd(a, a), _mm256_sub_pd(_mm256_set1_pd(3.0), _mm256_mul_pd(_mm256_set1_pd(2.0), a)));
+}
+
+RIDGED_NOISE_TARGET("avx2")
+inline __m256d LinearInterpAVX(__m256d n0, __m256d n1, __m256d a) {
+    return _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), a), n0), _mm256_mul_pd(a, n1));
+}
+
+RIDGED_NOISE_TARGET("avx2")
+inline __m256d LatticeAVX(__m256d v) {
+    __m256d truncated = _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    return _mm256_sub_pd(truncated, _mm256_and_pd(_mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_LE_OQ), _mm256_set1_pd(1.0)));
+}
+
+// the 4 gradients are loaded as rows and transposed, faster than three gathers out of a table this small
+RIDGED_NOISE_TARGET("avx2")
+inline __m256d GradientNoiseAVX(const Gradient* gradients, __m128i hash, __m256d px, __m256d py, __m256d pz) {
+    __m128i idx  = _mm_and_si128(_mm_xor_si128(hash, _mm_srli_epi32(hash, kShiftNoiseGen)), _mm_set1_epi32(0xff));
+    __m256d r0   = _mm256_load_pd(&gradients[_mm_cvtsi128_si32(idx)].x);
+    __m256d r1   = _mm256_load_pd(&gradients[_mm_extract_epi32(idx, 1)].x);
+    __m256d r2   = _mm256_load_pd(&gradients[_mm_extract_epi32(idx, 2)].x);
+    __m256d r3   = _mm256_load_pd(&gradients[_mm_extract_epi32(idx, 3)].x);
+    __m256d xz01 = _mm256_unpacklo_pd(r0, r1);
+    __m256d xz23 = _mm256_unpacklo_pd(r2, r3);
+    __m256d y01  = _mm256_unpackhi_pd(r0, r1);
+    __m256d y23  = _mm256_unpackhi_pd(r2, r3);
+    __m256d gx   = _mm256_permute2f128_pd(xz01, xz23, 0x20);
+    __m256d gy   = _mm256_permute2f128_pd(y01, y23, 0x20);
+    __m256d gz   = _mm256_permute2f128_pd(xz01, xz23, 0x31);
+    return _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(gx, px), _mm256_mul_pd(gy, py)), _mm256_mul_pd(gz, pz));
+}
+
+RIDGED_NOISE_TARGET("avx2")
+__m256d CoherentNoiseAVX(const Gradient* gradients, __m256d x, __m256d y, __m256d z, int seed) {
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d x0  = LatticeAVX(x);
+    __m256d y0  = LatticeAVX(y);
+    __m256d z0  = LatticeAVX(z);
+
+    __m256d px0 = _mm256_sub_pd(x, x0);
+    __m256d py0 = _mm256_sub_pd(y, y0);
+    __m256d pz0 = _mm256_sub_pd(z, z0);
+    __m256d px1 = _mm256_sub_pd(x, _mm256_add_pd(x0, one));
+    __m256d py1 = _mm256_sub_pd(y, _mm256_add_pd(y0, one));
+    __m256d pz1 = _mm256_sub_pd(z, _mm256_add_pd(z0, one));
+
+    __m256d xs = SCurve3AVX(px0);
+    __m256d ys = SCurve3AVX(py0);
+    __m256d zs = SCurve3AVX(pz0);
+
+    __m128i xGen = _mm_set1_epi32(static_cast<int>(kXNoiseGen));
+    __m128i yGen = _mm_set1_epi32(static_cast<int>(kYNoiseGen));
+    __m128i zGen = _mm_set1_epi32(static_cast<int>(kZNoiseGen));
+    __m128i hx0  = _mm_mullo_epi32(_mm256_cvttpd_epi32(x0), xGen);
+    __m128i hy0  = _mm_mullo_epi32(_mm256_cvttpd_epi32(y0), yGen);
+    __m128i hz0  = _mm_add_epi32(_mm_mullo_epi32(_mm256_cvttpd_epi32(z0), zGen), _mm_set1_epi32(static_cast<int>(kSeedNoiseGen * static_cast<uint32_t>(seed))));
+    __m128i hx1  = _mm_add_epi32(hx0, xGen);
+    __m128i hy1  = _mm_add_epi32(hy0, yGen);
+    __m128i hz1  = _mm_add_epi32(hz0, zGen);
+
+    __m128i h00 = _mm_add_epi32(hy0, hz0);
+    __m128i h10 = _mm_add_epi32(hy1, hz0);
+    __m128i h01 = _mm_add_epi32(hy0, hz1);
+    __m128i h11 = _mm_add_epi32(hy1, hz1);
+
+    __m256d ix0 = LinearInterpAVX(GradientNoiseAVX(gradients, _mm_add_epi32(hx0, h00), px0, py0, pz0),
+                                  GradientNoiseAVX(gradients, _mm_add_epi32(hx1, h00), px1, py0, pz0), xs);
+    __m256d ix1 = LinearInterpAVX(GradientNoiseAVX(gradients, _mm_add_epi32(hx0, h10), px0, py1, pz0),
+                                  GradientNoiseAVX(gradients, _mm_add_epi32(hx1, h10), px1, py1, pz0), xs);
+    __m256d iy0 = LinearInterpAVX(ix0, ix1, ys);
+    ix0         = LinearInterpAVX(GradientNoiseAVX(gradients, _mm_add_epi32(hx0, h01), px0, py0, pz1),
+                                  GradientNoiseAVX(gradients, _mm_add_epi32(hx1, h01), px1, py0, pz1), xs);
+    ix1         = LinearInterpAVX(GradientNoiseAVX(gradients, _mm_add_epi32(hx0, h11), px0, py1, pz1),
+                                  GradientNoiseAVX(gradients, _mm_add_epi32(hx1, h11), px1, py1, pz1), xs);
+    __m256d iy1 = LinearInterpAVX(ix0, ix1, ys);
+    return LinearInterpAVX(iy0, iy1, zs);
+}
+
+RIDGED_NOISE_TARGET("avx2")
+inline __m256d MakeInt32RangeAVX(__m256d v) {
+    __m256d magnitude = _mm256_andnot_pd(_mm256_set1_pd(-0.0), v);
+    if (_mm256_movemask_pd(_mm256_cmp_pd(magnitude, _mm256_set1_pd(kInt32Max), _CMP_GE_OQ)) == 0) {
+        return v;
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, v);
+    return _mm256_setr_pd(MakeInt32Range(lanes[0]), MakeInt32Range(lanes[1]), MakeInt32Range(lanes[2]), MakeInt32Range(lanes[3]));
+}
+
+RIDGED_NOISE_TARGET("avx2")
+void RidgedRowAVX2(const RidgedNoise::Settings& s, const double* xs, const double* ys, const double* zs, double* out, size_t count) {
+    const Gradient* gradients  = Gradients();
+    const __m256d   one        = _mm256_set1_pd(1.0);
+    const __m256d   zero       = _mm256_setzero_pd();
+    const __m256d   signMask   = _mm256_set1_pd(-0.0);
+    const __m256d   gain       = _mm256_set1_pd(kGain);
+    const __m256d   frequency  = _mm256_set1_pd(s.frequency);
+    const __m256d   lacunarity = _mm256_set1_pd(s.lacunarity);
+
+    size_t idx = 0;
+    for (; idx + 4 <= count; idx += 4) {
+        __m256d x = _mm256_mul_pd(_mm256_loadu_pd(xs + idx), frequency);
+        __m256d y = _mm256_mul_pd(_mm256_loadu_pd(ys + idx), frequency);
+        __m256d z = _mm256_mul_pd(_mm256_loadu_pd(zs + idx), frequency);
+
+        __m256d value  = zero;
+        __m256d weight = one;
+        for (int octave = 0; octave < s.octaveCount; ++octave) {
+            int     seed   = (s.seed + octave) & 0x7fffffff;
+            __m256d signal = CoherentNoiseAVX(gradients, MakeInt32RangeAVX(x), MakeInt32RangeAVX(y), MakeInt32RangeAVX(z), seed);
+
+            signal = _mm256_sub_pd(one, _mm256_andnot_pd(signMask, signal));
+            signal = _mm256_mul_pd(signal, signal);
+            signal = _mm256_mul_pd(signal, weight);
+            weight = _mm256_max_pd(_mm256_min_pd(_mm256_mul_pd(signal, gain), one), zero);
+            value  = _mm256_add_pd(value, _mm256_mul_pd(signal, _mm256_set1_pd(s.spectralWeights[octave])));
+
+            x = _mm256_mul_pd(x, lacunarity);
+            y = _mm256_mul_pd(y, lacunarity);
+            z = _mm256_mul_pd(z, lacunarity);
+        }
+        _mm256_storeu_pd(out + idx, _mm256_sub_pd(_mm256_mul_pd(value, _mm256_set1_pd(1.25)), one));
+    }
+    RidgedRowScalar(s, xs + idx, ys + idx, zs + idx, out + idx, count - idx);
+}
+#endif
+}
+
+RidgedNoise::RidgedNoise() { SetLacunarity(_settings.lacunarity); }
+
+void RidgedNoise::SetLacunarity(double lacunarity) {
+    // RidgedMulti::CalcSpectralWeights with h = 1
+    _settings.lacunarity = lacunarity;
+    double frequency     = 1.0;
+    for (int octave = 0; octave < kMaxOctaves; ++octave) {
+        _settings.spectralWeights[octave] = std::pow(frequency, -1.0);
+        frequency *= lacunarity;
+    }
+}
+
+void RidgedNoise::SetOctaveCount(int octaveCount) {
+    dg_assert(octaveCount >= 1 && octaveCount <= kMaxOctaves, "octave count %d out of range", octaveCount);
+    _settings.octaveCount = octaveCount;
+}
+
+double RidgedNoise::GetValue(double x, double y, double z) const { return Ridged(_settings, Gradients(), x, y, z); }
+
+void RidgedNoise::GetValues(const double* x, const double* y, const double* z, double* out, size_t count) const {
+    GetValues(BestPath(), x, y, z, out, count);
+}
+
+void RidgedNoise::GetValues(Path path, const double* x, const double* y, const double* z, double* out, size_t count) const {
+    dg_assert(IsSupported(path), "%s noise isn't supported on this cpu", PathName(path));
+    switch (path) {
+#ifdef RIDGED_NOISE_X86
+        case Path::AVX2: RidgedRowAVX2(_settings, x, y, z, out, count); return;
+        case Path::SSE41: RidgedRowSSE41(_settings, x, y, z, out, count); return;
+#endif
+        default: RidgedRowScalar(_settings, x, y, z, out, count); return;
+    }
+}
+
+bool RidgedNoise::IsSupported(Path path) {
+#ifdef RIDGED_NOISE_X86
+    static const bool hasSSE41 = CpuHasSSE41();
+    static const bool hasAVX2  = CpuHasAVX2();
+    switch (path) {
+        case Path::Scalar: return true;
+        case Path::SSE41: return hasSSE41;
+        case Path::AVX2: return hasAVX2;
+        default: return false;
+    }
+#else
+    return path == Path::Scalar;
+#endif
+}
+
+RidgedNoise::Path RidgedNoise::BestPath() {
+    static const Path best = [] {
+        Path path = IsSupported(Path::AVX2) ? Path::AVX2 : IsSupported(Path::SSE41) ? Path::SSE41 : Path::Scalar;
+        LOG_D("RidgedNoise: using the %s path", PathName(path));
+        return path;
+    }();
+    return best;
+}
+
+const char* RidgedNoise::PathName(Path path) {
+    switch (path) {
+        case Path::Scalar: return "scalar";
+        case Path::SSE41: return "sse4.1";
+        case Path::AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
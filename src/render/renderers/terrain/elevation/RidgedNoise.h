@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// libnoise's noise::module::RidgedMulti (QUALITY_STD, offset 1, gain 2) evaluated a row of samples at a time. Lattice
+// cells, hashes and the octave loop are libnoise's, done for 2 (SSE4.1) or 4 (AVX2) samples at once and picked at
+// runtime from cpuid. The gradient table is read back out of libnoise on first use with the gradient premultiplied by
+// libnoise's 2.12, so values match the module to a few ulps, not bit for bit. '/bench noise' reports how far off.
+// Settings are not thread safe, GetValues is
+class RidgedNoise {
+public:
+    static constexpr int kMaxOctaves = 30; // RIDGED_MAX_OCTAVE
+
+    enum class Path : uint8_t {
+        Scalar = 0,
+        SSE41,
+        AVX2,
+        Count,
+    };
+
+    struct Settings {
+        int    seed{0};
+        int    octaveCount{6};
+        double frequency{1.0};
+        double lacunarity{2.0};
+        double spectralWeights[kMaxOctaves];
+    };
+
+private:
+    Settings _settings;
+
+public:
+    RidgedNoise();
+
+    void SetSeed(int seed) { _settings.seed = seed; }
+    void SetFrequency(double frequency) { _settings.frequency = frequency; }
+    void SetLacunarity(double lacunarity);
+    void SetOctaveCount(int octaveCount);
+
+    const Settings& GetSettings() const { return _settings; }
+
+    double GetValue(double x, double y, double z) const;
+
+    // out[i] = GetValue(x[i], y[i], z[i]), on the best path this cpu has
+    void GetValues(const double* x, const double* y, const double* z, double* out, size_t count) const;
+    // on a given path, for the benchmark. the path has to be supported
+    void GetValues(Path path, const double* x, const double* y, const double* z, double* out, size_t count) const;
+
+    static bool        IsSupported(Path path);
+    static Path        BestPath();
+    static const char* PathName(Path path);
+};
@@ -3,7 +3,12 @@
 #include "DGAssert.h"
 #include "DrawItemEncoder.h"
 #include "StateGroupEncoder.h"
+#include "TaskScheduler.h"
 #include "TerrainQuadTree.h"
+#include "TransientBufferRing.h"
+
+// a tile is only a few stores, it takes a lot of them to be worth a task
+static constexpr size_t kSubmitChunkSize = 64;
 
 struct TileConstants {
     glm::mat4 world;
@@ -58,6 +63,9 @@ void TerrainElevationLayerRenderer::Submit(RenderQueue* renderQueue, const Frame
         }
     }
 
+    // encoding stays on this thread since a pipeline state miss creates one. Allocating and filling the constants and
+    // adding the draw items is what goes wide
+    _submitTiles.clear();
     for (uint32_t idx = 0; idx < dataTiles.size(); ++idx) {
         GPUElevationDataTile* tile        = dataTiles[idx];
         GPUNormalsDataTile*   normalsTile = dataTiles2[idx];
@@ -68,25 +76,12 @@ void TerrainElevationLayerRenderer::Submit(RenderQueue* renderQueue, const Frame
             continue;
         };
 
-        if (tile->perTileConstants == nullptr) {
-            tile->perTileConstants = services()->constantBufferManager()->GetConstantBuffer(sizeof(TileConstants), "perTile");
-        }
-
-        TileConstants* constants  = tile->perTileConstants->Map<TileConstants>();
-        constants->world          = transforms[idx];
-        constants->heightmapIndex = tile->gpuData->slotIndex;
-        constants->normalMapIndex = normalsTile->gpuData->slotIndex;
-        constants->heightmapLod   = tile->key.lod;
-        constants->lod            = tile->key.lod;
-
-        tile->perTileConstants->Unmap();
-
         if (tile->stateGroup == nullptr) {
             std::unique_ptr<const gfx::StateGroup> temp;
 
             gfx::StateGroupEncoder encoder;
             encoder.Begin(renderQueue->defaults);
-            encoder.BindResource(tile->perTileConstants->GetBinding(1));
+            encoder.BindDynamicConstantBuffer(1, services()->transientConstants()->buffer());
             encoder.BindTexture(0, tile->gpuData->texture, gfx::ShaderStageFlags::AllStages);
             encoder.BindTexture(1, normalsTile->gpuData->texture, gfx::ShaderStageFlags::AllStages);
             temp.reset(encoder.End());
@@ -96,9 +91,33 @@ void TerrainElevationLayerRenderer::Submit(RenderQueue* renderQueue, const Frame
 
         if (tile->drawItem == nullptr) {
             gfx::DrawItemEncoder encoder;
-            tile->drawItem.reset(encoder.Encode(device(), tile->geometry->drawCall(), {tile->stateGroup.get()}));
+            tile->drawItem.reset(encoder.Encode(services()->pipelineStateCache(), tile->geometry->drawCall(), {tile->stateGroup.get()}));
         }
 
-        renderQueue->AddDrawItem(0, tile->drawItem.get());
+        _submitTiles.push_back({tile, normalsTile, &transforms[idx]});
     }
+
+    TransientBufferRing* ring = services()->transientConstants();
+    scheduler()->parallelFor(_submitTiles.size(), kSubmitChunkSize, [this, renderQueue, view, ring](size_t begin, size_t end) {
+        for (size_t idx = begin; idx < end; ++idx) {
+            const SubmitTile&     submitTile = _submitTiles[idx];
+            GPUElevationDataTile* tile       = submitTile.tile;
+            const glm::mat4&      world      = *submitTile.world;
+
+            uint32_t       offset;
+            TileConstants* constants = ring->Allocate<TileConstants>(&offset);
+            if (constants == nullptr) {
+                continue;
+            }
+            constants->world          = world;
+            constants->heightmapIndex = tile->gpuData->slotIndex;
+            constants->normalMapIndex = submitTile.normalsTile->gpuData->slotIndex;
+            constants->heightmapLod   = tile->key.lod;
+            constants->lod            = tile->key.lod;
+
+            // every tile samples the same texture arrays, so pipeline then near to far
+            float depth = glm::length(glm::vec3(world[3]) - view->eyePos) / view->zfar;
+            renderQueue->AddDrawItem(SortKey::Opaque(RenderLayer::World, tile->drawItem.get(), SortKey::MaterialKey(tile->gpuData->texture), depth), tile->drawItem.get(), offset);
+        }
+    });
 }
@@ -9,6 +9,16 @@
 #include "TerrainQuadNode.h"
 
 class TerrainElevationLayerRenderer : public TerrainLayerRenderer {
+private:
+    // a tile's draw item is encoded before Submit goes wide, its constants are allocated and filled on workers
+    struct SubmitTile {
+        GPUElevationDataTile* tile;
+        GPUNormalsDataTile*   normalsTile;
+        const glm::mat4*      world;
+    };
+
+    std::vector<SubmitTile> _submitTiles;
+
 public:
     std::unique_ptr<const gfx::StateGroup> _base;
     DataTileSampler<GPUElevationDataTile>* _elevationSampler;
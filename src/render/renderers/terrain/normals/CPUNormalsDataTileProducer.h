@@ -6,30 +6,48 @@
 #include "DataTileProducer.h"
 #include "GPUTileBuffer.h"
 #include "RenderDevice.h"
+#include "SPSCQueue.h"
 #include "Task.h"
 #include "TaskScheduler.h"
 #include "TerrainDataTile.h"
+#include "TerrainTilePack.h"
 #include "TileCache.h"
+#include "TilePrefetchTracker.h"
 
 static const std::string kEDPChannel = "tileproducer.cpunormals";
 #define EDPLog_W(fmt, ...) LOG(Log::Level::Warn, kEDPChannel, fmt, ##__VA_ARGS__)
 
+// half the elevation producer's, the normals cache is half the size
+static constexpr size_t kMaxNormalPrefetchesInFlight = 16;
+static constexpr size_t kMaxNormalTasksInFlight      = 128;
+// see the elevation producer's kResultQueueCapacity
+static constexpr size_t kNormalResultQueueCapacity = 2 * kMaxNormalTasksInFlight;
+
 struct GenerateNormalmapTaskResults {
     TerrainTileKey         key;
     std::vector<glm::vec4> data;
+    bool                   loaded{false}; // read back from the tile pack rather than generated
 };
 
+// One single producer ring per scheduler thread slot, a task pushes into its own thread's and the frame thread drains
+// them all. Slot 0 is every thread that isn't a worker, those only ever help with High tasks and these never are
+using NormalmapResultLanes = std::vector<std::unique_ptr<SPSCQueue<GenerateNormalmapTaskResults>>>;
+
+inline void enqueueNormalmapResults(NormalmapResultLanes* lanes, GenerateNormalmapTaskResults&& results) {
+    (*lanes)[scheduler()->threadSlot()]->enqueue(std::move(results));
+}
+
 struct GenerateNormalmapTask : public Task {
 private:
     const CPUElevationDataTile*                  elevationData;
     const TerrainTileKey                         key;
-    BlockingQueue<GenerateNormalmapTaskResults>* _outputQueue;
+    NormalmapResultLanes*                        _outputLanes;
 
 public:
-    GenerateNormalmapTask(const TerrainTileKey& key, const CPUElevationDataTile* cpuElevationData, BlockingQueue<GenerateNormalmapTaskResults>* outputQueue)
+    GenerateNormalmapTask(const TerrainTileKey& key, const CPUElevationDataTile* cpuElevationData, NormalmapResultLanes* outputLanes)
         : elevationData(cpuElevationData)
         , key(key)
-        , _outputQueue(outputQueue) {}
+        , _outputLanes(outputLanes) {}
 
     virtual void execute() final {
         //        std::this_thread::sleep_for (std::chrono::seconds(1));
@@ -67,7 +85,7 @@ public:
                 data[getIndex(i, j)] = glm::normalize(glm::vec4(scale * x, scale * y, z, 0));
             }
         }
-        _outputQueue->enqueue({key, data});
+        enqueueNormalmapResults(_outputLanes, {key, std::move(data)});
     }
 
 private:
@@ -96,20 +114,24 @@ private:
 
 private:
     CPUElevationDataTileProducer* _residualProducer{nullptr};
+    TerrainTilePack*              _tilePack{nullptr}; // can be null
 
     std::map<TerrainTileKey, CPUNormalsDataTile*> _dataTiles;
 
     std::unique_ptr<NormalmapCPUTileBuffer>                      _cpuTileBuffer;
     std::unique_ptr<NormalmapCPUTileCache>                       _cpuTileCache;
-    std::unique_ptr<BlockingQueue<GenerateNormalmapTaskResults>> _generateNormalmapTaskOutput;
+    NormalmapResultLanes                                         _generateNormalmapTaskOutput;
     std::unordered_map<TerrainTileKey, TaskPtr> _pendingTasks;
+    TilePrefetchTracker                         _prefetch;
 
 public:
-    CPUNormalDataTileProducer(CPUElevationDataTileProducer* residualProducer)
+    CPUNormalDataTileProducer(CPUElevationDataTileProducer* residualProducer, TerrainTilePack* tilePack)
         : DataTileProducer(TerrainLayerType::Normalmap, residualProducer->tileResolution)
-        , _residualProducer(residualProducer) {
+        , _residualProducer(residualProducer)
+        , _tilePack(tilePack) {
         _cpuTileBuffer.reset(new NormalmapCPUTileBuffer(DataTileProducer::tileResolution.x, DataTileProducer::tileResolution.y, 128));
         _cpuTileCache.reset(new NormalmapCPUTileCache(_cpuTileBuffer.get(), [&](const TerrainTileKey& key, const NormalmapCPUTileSlot* slot) {
+            _prefetch.Evicted(key);
             auto it = _dataTiles.find(key);
             if (it != end(_dataTiles)) {
                 CPUNormalsDataTile* tile = it->second;
@@ -119,7 +141,10 @@ public:
             }
         }));
 
-        _generateNormalmapTaskOutput.reset(new BlockingQueue<GenerateNormalmapTaskResults>());
+        // any one worker could end up running every task in flight
+        for (uint32_t slot = 0; slot <= scheduler()->workerCount(); ++slot) {
+            _generateNormalmapTaskOutput.emplace_back(new SPSCQueue<GenerateNormalmapTaskResults>(kNormalResultQueueCapacity));
+        }
     }
     ~CPUNormalDataTileProducer() {}
 
@@ -135,14 +160,16 @@ public:
         }
     }
 
-    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::set<TerrainTileKey>& keysLeaving,
-                        const std::set<TerrainTileKey>& keysEntering) final {
+    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::vector<TerrainTileKey>& keysLeaving,
+                        const std::vector<TerrainTileKey>& keysEntering) final {
 
         // process arrivals
         std::vector<GenerateNormalmapTaskResults> completed;
-        _generateNormalmapTaskOutput->flush(&completed);
+        for (std::unique_ptr<SPSCQueue<GenerateNormalmapTaskResults>>& lane : _generateNormalmapTaskOutput) {
+            lane->drain(&completed);
+        }
 
-        for (const GenerateNormalmapTaskResults& results : completed) {
+        for (GenerateNormalmapTaskResults& results : completed) {
             if (_pendingTasks.find(results.key) == end(_pendingTasks)) {
                 EDPLog_W("Processing arrival of unexpected key %s -- skipping", toString(results.key).c_str());
                 continue;
@@ -155,9 +182,13 @@ public:
             dg_assert_nm(!wasCPUTileInCache);
             dg_assert_nm(normalsDataTile->cpuData);
 
-            normalsDataTile->cpuData->data = results.data;
+            if (_tilePack != nullptr && !results.loaded) {
+                _tilePack->WriteNormalmap(results.key, results.data);
+            }
+            normalsDataTile->cpuData->data = std::move(results.data);
             _dataTiles.insert({results.key, normalsDataTile});
             _pendingTasks.erase(results.key);
+            _prefetch.Arrived(results.key);
         }
 
         // cancel tasks
@@ -178,7 +209,9 @@ public:
                 continue;
             }
 
-            if (_pendingTasks.find(node->key) != end(_pendingTasks)) {
+            // a prefetch that hasn't started would wait behind every other low priority task, it gets queued again below
+            auto pending = _pendingTasks.find(node->key);
+            if (pending != end(_pendingTasks) && (!_prefetch.isInFlight(node->key) || pending->second->state() != TaskState::Pending)) {
                 continue;
             }
 
@@ -190,25 +223,100 @@ public:
                 _dataTiles.insert({node->key, normalsDataTile});
                 continue;
             }
+            // a requeue frees its own slot below
+            if (pending == end(_pendingTasks) && _pendingTasks.size() >= kMaxNormalTasksInFlight) {
+                continue;
+            }
 
-            // not cached, need to generate
-            CPUElevationDataTile* cpuElevationData = reinterpret_cast<CPUElevationDataTile*>(_residualProducer->GetTile(*node));
-            if (cpuElevationData == nullptr || cpuElevationData->cpuData == nullptr) {
-                // wait still waiting for elevation data to be generated
+            TaskPtr task = MakeTileTask(*node);
+            if (task == nullptr) {
+                // still waiting for elevation data to be generated
                 // TODO:: need to prod producer to generate the elevation data
                 continue;
-            } else {
-                TaskPtr task = std::make_shared<GenerateNormalmapTask>(node->key, cpuElevationData, _generateNormalmapTaskOutput.get());
-                _pendingTasks.emplace(node->key, task);
-                tasksToQueue.push_back(task);
             }
+            if (pending != end(_pendingTasks)) {
+                pending->second->tryCancel();
+                _pendingTasks.erase(pending);
+            }
+            _pendingTasks.emplace(node->key, task);
+            tasksToQueue.push_back(task);
+        }
+
+        if (tasksToQueue.size() > 0) {
+            scheduler()->enqueueAll(tasksToQueue);
+        }
+
+        // after the requeues above, they need to know which keys were still prefetching
+        for (const TerrainTileKey& key : keysEntering) {
+            _prefetch.Visible(key);
+        }
+    }
+
+    // normals for nodes ahead whose elevation tile is already around, which it will be once the elevation producer's
+    // prefetch of the same nodes lands
+    virtual void Prefetch(const std::vector<const TerrainQuadNode*>& nodesAhead) final {
+        std::unordered_set<TerrainTileKey> wanted;
+        for (const TerrainQuadNode* node : nodesAhead) {
+            wanted.insert(node->key);
+        }
+
+        std::vector<TerrainTileKey> stale;
+        _prefetch.TakeStale(wanted, &stale);
+        for (const TerrainTileKey& key : stale) {
+            auto it = _pendingTasks.find(key);
+            if (it != end(_pendingTasks)) {
+                it->second->tryCancel();
+                _pendingTasks.erase(it);
+            }
+        }
+
+        std::vector<TaskPtr> tasksToQueue;
+        for (const TerrainQuadNode* node : nodesAhead) {
+            if (_prefetch.inFlight() >= kMaxNormalPrefetchesInFlight || _pendingTasks.size() >= kMaxNormalTasksInFlight) {
+                break;
+            }
+            if (_dataTiles.find(node->key) != end(_dataTiles) || _pendingTasks.find(node->key) != end(_pendingTasks) || _cpuTileCache->find(node->key) != nullptr) {
+                continue;
+            }
+
+            TaskPtr task = MakeTileTask(*node);
+            if (task == nullptr) {
+                continue;
+            }
+            task->setPriority(TaskPriority::Low);
+            _pendingTasks.emplace(node->key, task);
+            _prefetch.Requested(node->key);
+            tasksToQueue.push_back(task);
         }
 
         if (tasksToQueue.size() > 0) {
-            scheduler()->queue()->enqueueAll(tasksToQueue);
+            scheduler()->enqueueAll(tasksToQueue);
         }
     }
 
+    const TilePrefetchTracker::Stats& GetPrefetchStats() const { return _prefetch.GetStats(); }
+
     // DataTileSampler interface
     virtual CPUNormalsDataTile* FindTile(const TerrainTileKey& key) final { return nullptr; };
+
+private:
+    // load from the pack or generate from the elevation tile, null when neither is possible yet
+    TaskPtr MakeTileTask(const TerrainQuadNode& node) {
+        // packed normals don't need the elevation tile
+        TerrainTilePack::Tile packed = _tilePack != nullptr ? _tilePack->Find(node.key, TerrainLayerType::Normalmap) : TerrainTilePack::Tile();
+        if (packed) {
+            NormalmapResultLanes* output = &_generateNormalmapTaskOutput;
+            return makeTask<LambdaTask>([packed, key = node.key, output]() {
+                GenerateNormalmapTaskResults results{key, {}, true};
+                TerrainTilePack::ReadNormalmap(packed, &results.data);
+                enqueueNormalmapResults(output, std::move(results));
+            });
+        }
+
+        CPUElevationDataTile* cpuElevationData = reinterpret_cast<CPUElevationDataTile*>(_residualProducer->GetTile(node));
+        if (cpuElevationData == nullptr || cpuElevationData->cpuData == nullptr) {
+            return nullptr;
+        }
+        return makeTask<GenerateNormalmapTask>(node.key, cpuElevationData, &_generateNormalmapTaskOutput);
+    }
 };
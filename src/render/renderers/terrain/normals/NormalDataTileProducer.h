@@ -59,8 +59,8 @@ public:
         }
     }
 
-    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::set<TerrainTileKey>& keysLeaving,
-                        const std::set<TerrainTileKey>& keysEntering) final {
+    virtual void Update(const std::vector<const TerrainQuadNode*>& nodesInScene, const std::vector<TerrainTileKey>& keysLeaving,
+                        const std::vector<TerrainTileKey>& keysEntering) final {
 
         for (const TerrainQuadNode* node : nodesInScene) {
             TerrainDataTile* tile = GetTile(*node);
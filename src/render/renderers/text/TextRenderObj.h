@@ -3,7 +3,6 @@
 #include <glm/glm.hpp>
 #include <memory>
 #include <string>
-#include "ConstantBuffer.h"
 #include "Mesh.h"
 #include "RenderObj.h"
 #include "StateGroup.h"
@@ -18,7 +17,6 @@ private:
     std::string        _text;
     uint32_t           _cursorPos{0};
     bool               _cursorEnabled{false};
-    ConstantBuffer*    _constantBuffer{nullptr};
     float              _posX;
     float              _posY;
     float              _posZ;
@@ -9,6 +9,7 @@
 #include "Log.h"
 #include "StateGroupEncoder.h"
 #include "DrawItemEncoder.h"
+#include "TransientBufferRing.h"
 
 struct TextViewConstants {
     glm::mat4 projection;
@@ -217,15 +218,14 @@ TextRenderer::~TextRenderer() {}
 void TextRenderer::Unregister(TextRenderObj* renderObj) { assert(false); }
 
 void TextRenderer::Register(TextRenderObj* textRenderObj) {
-    textRenderObj->_constantBuffer = services()->constantBufferManager()->GetConstantBuffer(sizeof(TextConstants), "textConstants");
-    textRenderObj->_cursorPos      = 0;
+    textRenderObj->_cursorPos = 0;
 
     gfx::StateGroupEncoder encoder;
     if (textRenderObj->_usePerspective)
         encoder.Begin(_base3D);
     else 
         encoder.Begin(_base);
-    encoder.BindResource(textRenderObj->_constantBuffer->GetBinding(2));
+    encoder.BindDynamicConstantBuffer(2, services()->transientConstants()->buffer());
     textRenderObj->_group = encoder.End();
 
     gfx::StateGroupEncoder cEncoder;
@@ -233,7 +233,7 @@ void TextRenderer::Register(TextRenderObj* textRenderObj) {
         encoder.Begin(_cursorBase3D);
     else
         cEncoder.Begin(_cursorBase);
-    cEncoder.BindResource(textRenderObj->_constantBuffer->GetBinding(2));
+    cEncoder.BindDynamicConstantBuffer(2, services()->transientConstants()->buffer());
     textRenderObj->_cursorGroup = cEncoder.End();
 
     const std::string& text = textRenderObj->_text;
@@ -322,7 +322,7 @@ const gfx::DrawItem* TextRenderer::CreateDrawItem(TextRenderObj* renderObj, cons
         LOG_E("TextBuffer overwriting itself");
     }
 
-    return gfx::DrawItemEncoder::Encode(device(), drawCall, { renderObj->_group, defaults });
+    return gfx::DrawItemEncoder::Encode(services()->pipelineStateCache(), drawCall, { renderObj->_group, defaults });
 }
 
 const gfx::DrawItem* TextRenderer::CreateCursorDrawItem(TextRenderObj* renderObj, const gfx::StateGroup* defaults) {
@@ -351,7 +351,7 @@ const gfx::DrawItem* TextRenderer::CreateCursorDrawItem(TextRenderObj* renderObj
     drawCall.primitiveCount = 2;
     drawCall.startOffset = 0;
 
-    return gfx::DrawItemEncoder::Encode(device(), drawCall, { renderObj->_cursorGroup, defaults });
+    return gfx::DrawItemEncoder::Encode(services()->pipelineStateCache(), drawCall, { renderObj->_cursorGroup, defaults });
 }
 
 void TextRenderer::Submit(RenderQueue* queue, const FrameView* view) {
@@ -369,16 +369,20 @@ void TextRenderer::Submit(RenderQueue* queue, const FrameView* view) {
     _vertexBufferOffsetCheck = _vertexBufferOffset;
 
     for (auto& text : _objs) {
-        text->_constantBuffer->Map<TextConstants>()->textColor = text->_textColor;
-        text->_constantBuffer->Unmap();
+        uint32_t       constantsOffset;
+        TextConstants* constants = services()->transientConstants()->Allocate<TextConstants>(&constantsOffset);
+        if (constants == nullptr) {
+            continue;
+        }
+        constants->textColor = text->_textColor;
 
         text->_drawItem.reset(CreateDrawItem(text, queue->defaults));
-        queue->AddDrawItem(3, text->_drawItem.get()); // TODO:: sortkeys based on pass....text needs to be rendered after sky
+        queue->AddDrawItem(SortKey::Ordered(RenderLayer::Text), text->_drawItem.get(), constantsOffset);
         if (text->_cursorEnabled) {
             if (drewCursor)
                 LOG_D("[Text] Multiple Cursors detected and unsupported.");
             text->_cursorDrawItem.reset(CreateCursorDrawItem(text, queue->defaults));
-            queue->AddDrawItem(2, text->_cursorDrawItem.get());
+            queue->AddDrawItem(SortKey::Ordered(RenderLayer::TextCursor), text->_cursorDrawItem.get(), constantsOffset);
             drewCursor = true;
         }
     }
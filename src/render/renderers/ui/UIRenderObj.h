@@ -1,7 +1,6 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include "ConstantBuffer.h"
 #include "DrawItemEncoder.h"
 #include "RenderObj.h"
 #include "VertexStream.h"
@@ -49,7 +48,6 @@ private:
     glm::vec4         _borderColor;
     glm::vec2         _borderSize;
 
-    ConstantBuffer*        _frameData{nullptr};
     const gfx::StateGroup* _group{nullptr};
     const gfx::DrawItem*   _item{nullptr};
 };
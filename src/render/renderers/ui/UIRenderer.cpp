@@ -1,4 +1,5 @@
 #include "UIRenderer.h"
+#include "TransientBufferRing.h"
 
 struct UIViewConstants {
     glm::mat4 projection;
@@ -123,14 +124,12 @@ void UIRenderer::Register(UIFrameRenderObj* uiRenderObj) {
     device()->UnmapMemory(_vertexBuffer);
     _bufferOffset += verticesSize;
 
-    uiRenderObj->_frameData = services()->constantBufferManager()->GetConstantBuffer(sizeof(UIFrameConstants), "uiFrameConstants");
-
     gfx::StateGroupEncoder encoder;
     if (uiRenderObj->_usePerspective)
         encoder.Begin(_base3D);
     else
         encoder.Begin(_base);
-    encoder.BindResource(uiRenderObj->_frameData->GetBinding(2));
+    encoder.BindDynamicConstantBuffer(2, services()->transientConstants()->buffer());
     uiRenderObj->_group = encoder.End();
 
     _objs.push_back(uiRenderObj);
@@ -165,16 +164,19 @@ void UIRenderer::Submit(RenderQueue* renderQueue, const FrameView* view) {
         }
         
         if (uiRenderObj->_item == nullptr) {
-            uiRenderObj->_item = gfx::DrawItemEncoder::Encode(device(), uiRenderObj->_drawCall, { uiRenderObj->_group, renderQueue->defaults });
+            uiRenderObj->_item = gfx::DrawItemEncoder::Encode(services()->pipelineStateCache(), uiRenderObj->_drawCall, { uiRenderObj->_group, renderQueue->defaults });
         }
         
-        UIFrameConstants* frameConstants = uiRenderObj->_frameData->Map<UIFrameConstants>();
-        frameConstants->bgColor          = uiRenderObj->_bgColor;
-        frameConstants->borderColor      = uiRenderObj->_borderColor;
-        frameConstants->borderSize       = uiRenderObj->_borderSize;
-        frameConstants->position         = { uiRenderObj->_x, uiRenderObj->_y, uiRenderObj->_z};
-        uiRenderObj->_frameData->Unmap();
-
-        renderQueue->AddDrawItem(1, uiRenderObj->_item);
+        uint32_t          constantsOffset;
+        UIFrameConstants* frameConstants = services()->transientConstants()->Allocate<UIFrameConstants>(&constantsOffset);
+        if (frameConstants == nullptr) {
+            continue;
+        }
+        frameConstants->bgColor     = uiRenderObj->_bgColor;
+        frameConstants->borderColor = uiRenderObj->_borderColor;
+        frameConstants->borderSize  = uiRenderObj->_borderSize;
+        frameConstants->position    = { uiRenderObj->_x, uiRenderObj->_y, uiRenderObj->_z};
+
+        renderQueue->AddDrawItem(SortKey::Ordered(RenderLayer::UI), uiRenderObj->_item, constantsOffset);
     }
 }
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <atomic>
-#include <functional>
-#include <memory>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "DGAssert.h"
+#include "TaskAllocator.h"
 
 enum class TaskState : uint8_t {
     Pending,
@@ -12,40 +16,206 @@ enum class TaskState : uint8_t {
     Canceled
 };
 
+// Workers always drain higher priority work first (ex. visible terrain tiles before prefetched ones)
+enum class TaskPriority : uint8_t {
+    High = 0,
+    Normal,
+    Low,
+    Count
+};
+
+class TaskScheduler;
+class Task;
+
+// Intrusive handle to a task. Copying is a single relaxed increment, no control block and no allocation.
+// Doubles as the cancellation handle: hang on to it and call tryCancel() whenever.
+template <class T>
+class TaskRef {
+private:
+    template <class U>
+    friend class TaskRef;
+
+    T* _ptr{nullptr};
+
+public:
+    TaskRef() {}
+    TaskRef(std::nullptr_t) {}
+    explicit TaskRef(T* ptr) : _ptr(ptr) {
+        if (_ptr) {
+            _ptr->addRef();
+        }
+    }
+    TaskRef(const TaskRef& other) : TaskRef(other._ptr) {}
+    TaskRef(TaskRef&& other) : _ptr(other._ptr) { other._ptr = nullptr; }
+
+    template <class U, class = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+    TaskRef(const TaskRef<U>& other) : TaskRef(static_cast<T*>(other._ptr)) {}
+
+    template <class U, class = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+    TaskRef(TaskRef<U>&& other) : _ptr(other._ptr) {
+        other._ptr = nullptr;
+    }
+
+    ~TaskRef() { reset(); }
+
+    TaskRef& operator=(const TaskRef& other) {
+        TaskRef(other).swap(*this);
+        return *this;
+    }
+
+    TaskRef& operator=(TaskRef&& other) {
+        TaskRef(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void reset() {
+        if (_ptr) {
+            _ptr->release();
+            _ptr = nullptr;
+        }
+    }
+
+    void swap(TaskRef& other) { std::swap(_ptr, other._ptr); }
+
+    T* get() const { return _ptr; }
+    T* operator->() const { return _ptr; }
+    T& operator*() const { return *_ptr; }
+
+    explicit operator bool() const { return _ptr != nullptr; }
+    bool     operator==(std::nullptr_t) const { return _ptr == nullptr; }
+    bool     operator!=(std::nullptr_t) const { return _ptr != nullptr; }
+    template <class U>
+    bool operator==(const TaskRef<U>& other) const {
+        return _ptr == other._ptr;
+    }
+    template <class U>
+    bool operator!=(const TaskRef<U>& other) const {
+        return _ptr != other._ptr;
+    }
+};
+
+using TaskPtr = TaskRef<Task>;
+
+// Tasks are allocated from TaskAllocator's per-thread pools and freed when the last TaskRef goes away
+template <class T, class... Args>
+TaskRef<T> makeTask(Args&&... args) {
+    static_assert(std::is_base_of<Task, T>::value, "makeTask only makes tasks");
+    return TaskRef<T>(new T(std::forward<Args>(args)...));
+}
+
 class Task {
 private:
+    friend TaskScheduler;
+    template <class U>
+    friend class TaskRef;
+
     std::atomic<TaskState> _state{TaskState::Pending};
+    std::atomic<int32_t>   _unfinished{1}; // this task + children that havent finished yet
+    std::atomic<int32_t>   _refCount{0};   // TaskRefs + 1 while queued in the scheduler
+    TaskPriority           _priority{TaskPriority::Normal};
+    TaskPtr                _parent;
 
 public:
+    static void* operator new(size_t size) { return TaskAllocator::allocate(size); }
+    static void  operator delete(void* ptr) { TaskAllocator::deallocate(ptr); }
+
+    Task() {}
+    virtual ~Task() {}
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
     void run() {
-        if (!isCanceled()) {
-            _state = TaskState::Running;
+        TaskState expected = TaskState::Pending;
+        if (_state.compare_exchange_strong(expected, TaskState::Running, std::memory_order_acquire, std::memory_order_relaxed)) {
             execute();
         }
 
-        _state = _state == TaskState::Canceling ? TaskState::Canceled : TaskState::Completed;
+        finish();
+    }
+
+    void tryCancel() {
+        TaskState expected = TaskState::Pending;
+        if (!_state.compare_exchange_strong(expected, TaskState::Canceling, std::memory_order_relaxed) && expected == TaskState::Running) {
+            _state.compare_exchange_strong(expected, TaskState::Canceling, std::memory_order_relaxed);
+        }
+    };
+
+    // parent wont be finished until this task is. both tasks must not have been enqueued yet
+    void setParent(const TaskPtr& parent) {
+        dg_assert_nm(parent != nullptr && _parent == nullptr);
+        dg_assert_nm(parent->state() == TaskState::Pending);
+        parent->_unfinished.fetch_add(1, std::memory_order_relaxed);
+        _parent = parent;
     }
 
-    void tryCancel() { _state = TaskState::Canceling; };
+    void         setPriority(TaskPriority priority) { _priority = priority; }
+    TaskPriority priority() const { return _priority; }
 
-    TaskState state() const { return _state; }
-    bool      isRunning() const { return _state == TaskState::Running; }
-    bool      isCanceled() const { return _state == TaskState::Canceling; }
+    TaskState state() const { return _state.load(std::memory_order_acquire); }
+    bool      isRunning() const { return _state.load(std::memory_order_relaxed) == TaskState::Running; }
+    // polled from inside execute(), only a hint so relaxed is enough
+    bool isCanceled() const { return _state.load(std::memory_order_relaxed) == TaskState::Canceling; }
+    // acquire pairs with the release in finish() so results written by execute() are visible to the waiter
+    bool isFinished() const {
+        TaskState state = _state.load(std::memory_order_acquire);
+        return state == TaskState::Completed || state == TaskState::Canceled;
+    }
 
 protected:
     virtual void execute() = 0;
+
+private:
+    void addRef() { _refCount.fetch_add(1, std::memory_order_relaxed); }
+
+    void release() {
+        if (_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    void finish() {
+        if (_unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        TaskState expected = TaskState::Running;
+        if (!_state.compare_exchange_strong(expected, TaskState::Completed, std::memory_order_release, std::memory_order_relaxed)) {
+            _state.store(TaskState::Canceled, std::memory_order_release);
+        }
+
+        if (_parent) {
+            TaskPtr parent = std::move(_parent);
+            parent->finish();
+        }
+    }
 };
 
+// Stores the closure inline instead of going through std::function, so a LambdaTask is exactly one pooled block.
+// Captures bigger than kInlineSize don't compile, capture a pointer to the big thing instead.
 class LambdaTask : public Task {
+public:
+    static constexpr size_t kInlineSize = 64;
+
 private:
-    std::function<void(void)> _lambda;
+    alignas(std::max_align_t) unsigned char _storage[kInlineSize];
+    void (*_invoke)(void*);
+    void (*_destroy)(void*);
 
 public:
-    LambdaTask(std::function<void(void)> lambda)
-        : _lambda(lambda) {}
+    template <class F>
+    LambdaTask(F&& lambda) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= kInlineSize, "LambdaTask capture too big");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "LambdaTask capture over aligned");
+
+        new (_storage) Fn(std::forward<F>(lambda));
+        _invoke  = [](void* fn) { (*static_cast<Fn*>(fn))(); };
+        _destroy = [](void* fn) { static_cast<Fn*>(fn)->~Fn(); };
+    }
+
+    ~LambdaTask() { _destroy(_storage); }
 
 protected:
-    virtual void execute() final { _lambda(); }
+    virtual void execute() final { _invoke(_storage); }
 };
-
-using TaskPtr = std::shared_ptr<Task>;
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <new>
+#include <stdint.h>
+
+// Size-classed free-list allocator for tasks. Every thread gets its own free lists so the common alloc/free path never
+// touches shared state. A block freed on a different thread than the one that allocated it (ex. created on the frame
+// thread, last reference dropped by a worker) is pushed onto the owner's lock-free remote list and reclaimed by the owner
+// the next time its own lists run dry. Each list keeps at most kMaxFreeBlocks blocks, past that freed blocks go back to
+// the system, so a burst of tasks (or a thread that only ever frees) doesn't pin its peak forever.
+class TaskAllocator {
+private:
+    static constexpr uint32_t                            kSizeClassCount = 4;
+    static constexpr std::array<size_t, kSizeClassCount> kSizeClasses    = {{128, 256, 512, 1024}};
+    static constexpr uint32_t                            kUnpooled       = kSizeClassCount;
+    // per size class per thread, 512 of the largest class is 512k
+    static constexpr uint32_t                            kMaxFreeBlocks  = 512;
+
+    struct alignas(16) BlockHeader {
+        TaskAllocator* owner{nullptr};
+        BlockHeader*   next{nullptr};
+        uint32_t       sizeClass{kUnpooled};
+    };
+
+    std::array<BlockHeader*, kSizeClassCount> _freeLists{};
+    std::array<uint32_t, kSizeClassCount>     _freeCounts{};
+    std::atomic<BlockHeader*>                 _remoteFrees{nullptr};
+
+public:
+    static void* allocate(size_t size) {
+        uint32_t sizeClass = sizeClassFor(size);
+        if (sizeClass == kUnpooled) {
+            BlockHeader* header = new (::operator new(sizeof(BlockHeader) + size)) BlockHeader();
+            return header + 1;
+        }
+        return local().allocateFromClass(sizeClass);
+    }
+
+    static void deallocate(void* ptr) {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+        if (header->owner == nullptr) {
+            header->~BlockHeader();
+            ::operator delete(header);
+            return;
+        }
+
+        TaskAllocator& allocator = local();
+        if (header->owner == &allocator) {
+            allocator.pushFree(header);
+        } else {
+            header->owner->pushRemote(header);
+        }
+    }
+
+private:
+    TaskAllocator() {}
+
+    // Intentionally never destroyed, blocks handed out by a thread can outlive it
+    static TaskAllocator& local() {
+        static thread_local TaskAllocator* allocator = new TaskAllocator();
+        return *allocator;
+    }
+
+    static uint32_t sizeClassFor(size_t size) {
+        for (uint32_t idx = 0; idx < kSizeClassCount; ++idx) {
+            if (size <= kSizeClasses[idx]) {
+                return idx;
+            }
+        }
+        return kUnpooled;
+    }
+
+    void* allocateFromClass(uint32_t sizeClass) {
+        if (_freeLists[sizeClass] == nullptr) {
+            reclaimRemoteFrees();
+        }
+
+        BlockHeader* header = _freeLists[sizeClass];
+        if (header != nullptr) {
+            _freeLists[sizeClass] = header->next;
+            --_freeCounts[sizeClass];
+        } else {
+            header            = new (::operator new(sizeof(BlockHeader) + kSizeClasses[sizeClass])) BlockHeader();
+            header->owner     = this;
+            header->sizeClass = sizeClass;
+        }
+        header->next = nullptr;
+        return header + 1;
+    }
+
+    void pushFree(BlockHeader* header) {
+        if (_freeCounts[header->sizeClass] >= kMaxFreeBlocks) {
+            header->~BlockHeader();
+            ::operator delete(header);
+            return;
+        }
+        header->next                  = _freeLists[header->sizeClass];
+        _freeLists[header->sizeClass] = header;
+        ++_freeCounts[header->sizeClass];
+    }
+
+    void pushRemote(BlockHeader* header) {
+        header->next = _remoteFrees.load(std::memory_order_relaxed);
+        while (!_remoteFrees.compare_exchange_weak(header->next, header, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reclaimRemoteFrees() {
+        // only the owner ever takes from the remote list and it takes everything at once, so no ABA
+        BlockHeader* header = _remoteFrees.exchange(nullptr, std::memory_order_acquire);
+        while (header != nullptr) {
+            BlockHeader* next = header->next;
+            pushFree(header);
+            header = next;
+        }
+    }
+};
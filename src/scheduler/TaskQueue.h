@@ -1,32 +1,56 @@
 #pragma once
 
-#include "BlockingQueue.h"
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include "Task.h"
 
 class TaskScheduler;
 
+// Tasks submitted from threads that aren't scheduler workers (ex. the frame thread) land here, bucketed by priority.
+// Workers prefer their own deques and only fall back to this when theirs are empty.
 class TaskQueue {
 private:
-    BlockingQueue<TaskPtr> _queue;
+    static constexpr size_t kPriorityCount = static_cast<size_t>(TaskPriority::Count);
 
-public:
-    ~TaskQueue() {
-        _queue.shutdown();
-    }
-    void enqueue(TaskPtr task) { _queue.enqueue(task); }
+    std::mutex                                  _lock;
+    std::array<std::deque<Task*>, kPriorityCount> _queues;
+    std::array<std::atomic<int32_t>, kPriorityCount> _sizes{};
 
-    void enqueueAll(const std::vector<TaskPtr>& tasks) { _queue.enqueueAll(tasks); }
+private:
+    friend TaskScheduler;
 
-    TaskPtr enqueue(std::function<void(void)> function) {
-        TaskPtr task = std::make_shared<LambdaTask>(function);
-        enqueue(task);
-        return task;
+    void enqueue(Task* task) {
+        size_t                      p = static_cast<size_t>(task->priority());
+        std::lock_guard<std::mutex> lk(_lock);
+        _queues[p].push_back(task);
+        _sizes[p].fetch_add(1, std::memory_order_release);
     }
 
-private:
-    friend TaskScheduler;
+    void enqueueAll(const std::vector<TaskPtr>& tasks) {
+        std::lock_guard<std::mutex> lk(_lock);
+        for (const TaskPtr& task : tasks) {
+            size_t p = static_cast<size_t>(task->priority());
+            _queues[p].push_back(task.get());
+            _sizes[p].fetch_add(1, std::memory_order_release);
+        }
+    }
 
-    bool dequeue(TaskPtr* task) {        
-        return _queue.dequeue(task);        
+    bool tryDequeue(TaskPriority priority, Task** task) {
+        size_t p = static_cast<size_t>(priority);
+        // skip taking the lock when there's obviously nothing to take
+        if (_sizes[p].load(std::memory_order_acquire) <= 0) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lk(_lock);
+        if (_queues[p].empty()) {
+            return false;
+        }
+        *task = _queues[p].front();
+        _queues[p].pop_front();
+        _sizes[p].fetch_sub(1, std::memory_order_relaxed);
+        return true;
     }
 };
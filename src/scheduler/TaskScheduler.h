@@ -1,46 +1,274 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <vector>
+#include "Config.h"
+#include "DGAssert.h"
 #include "Task.h"
 #include "TaskQueue.h"
+#include "WorkStealingDeque.h"
 
 class TaskScheduler {
 private:
-    std::unique_ptr<TaskQueue> _queue;
-    std::thread                _worker;
-    std::atomic<bool>          _interruptWorkers{false};
+    static constexpr size_t kPriorityCount = static_cast<size_t>(TaskPriority::Count);
+
+    struct Worker {
+        TaskScheduler*                                       scheduler{nullptr};
+        uint32_t                                             index{0};
+        std::array<WorkStealingDeque<Task*>, kPriorityCount> deques;
+        std::thread                                          thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    TaskQueue                            _queue;
+    std::atomic<bool>                    _interruptWorkers{false};
+    std::atomic<int32_t>                 _queuedCount{0};
+    std::mutex                           _sleepLock;
+    std::condition_variable              _sleepCond;
 
 private:
-    void workerThreadFunc() {
+    static Worker*& currentWorker() {
+        static thread_local Worker* worker = nullptr;
+        return worker;
+    }
+
+    Worker* currentWorkerForScheduler() {
+        Worker* worker = currentWorker();
+        return worker != nullptr && worker->scheduler == this ? worker : nullptr;
+    }
+
+    void workerThreadFunc(Worker* worker) {
+        currentWorker() = worker;
+
         while (!_interruptWorkers) {
-            TaskPtr task;
-            if (_queue->dequeue(&task) == false)
+            Task* task = nullptr;
+            if (tryGetTask(worker, &task)) {
+                runTask(task);
                 continue;
-            dg_assert_nm(task != nullptr);
+            }
+
+            std::unique_lock<std::mutex> lk(_sleepLock);
+            _sleepCond.wait(lk, [&]() { return _interruptWorkers || _queuedCount.load() > 0; });
+        }
+
+        currentWorker() = nullptr;
+    }
+
+    // own deque first, then anything submitted from outside, then steal. higher priority always wins, priorities from
+    // priorityCount on are left for someone else
+    bool tryGetTask(Worker* worker, Task** task, size_t priorityCount = kPriorityCount) {
+        for (size_t p = 0; p < priorityCount; ++p) {
+            if ((worker && worker->deques[p].pop(task)) || _queue.tryDequeue(static_cast<TaskPriority>(p), task) || trySteal(worker, p, task)) {
+                _queuedCount.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool trySteal(Worker* thief, size_t priority, Task** task) {
+        uint32_t workerCount = static_cast<uint32_t>(_workers.size());
+        uint32_t start       = thief ? thief->index + 1 : 0;
+        for (uint32_t i = 0; i < workerCount; ++i) {
+            Worker* victim = _workers[(start + i) % workerCount].get();
+            if (victim != thief && victim->deques[priority].steal(task)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void runTask(Task* task) {
+        dg_assert_nm(task != nullptr);
+
+        task->run();
+        task->release();
+    }
+
+    // queued tasks hold a reference so they stay alive if the owner drops its handle
+    void push(const TaskPtr& task, Worker* worker) {
+        dg_assert_nm(task != nullptr);
+        dg_assert(!task->isFinished(), "Task has already finished");
+
+        task->addRef();
+        if (worker) {
+            worker->deques[static_cast<size_t>(task->priority())].push(task.get());
+        }
+    }
 
-            task->run();
+    void wakeWorkers(int32_t taskCount) {
+        _queuedCount.fetch_add(taskCount);
+        {
+            // make sure a worker that just checked _queuedCount is actually waiting before we notify
+            std::lock_guard<std::mutex> lk(_sleepLock);
+        }
+        if (taskCount == 1) {
+            _sleepCond.notify_one();
+        } else {
+            _sleepCond.notify_all();
         }
     }
 
 public:
-    TaskScheduler() {
-        _queue.reset(new TaskQueue());
-        _worker = std::thread(std::bind(&TaskScheduler::workerThreadFunc, this));
+    static uint32_t defaultWorkerCount() {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        return std::max<uint32_t>(1, hardwareThreads > 0 ? hardwareThreads - 1 : 1);
+    }
+
+    TaskScheduler(uint32_t workerCount = defaultWorkerCount()) {
+        dg_assert(workerCount > 0, "TaskScheduler needs at least one worker");
+
+        _workers.reserve(workerCount);
+        for (uint32_t idx = 0; idx < workerCount; ++idx) {
+            _workers.emplace_back(new Worker());
+            _workers.back()->scheduler = this;
+            _workers.back()->index     = idx;
+        }
+        // start threads only after every worker exists so stealing never sees a partially built list
+        for (std::unique_ptr<Worker>& worker : _workers) {
+            worker->thread = std::thread(&TaskScheduler::workerThreadFunc, this, worker.get());
+        }
     }
 
     ~TaskScheduler() {
         _interruptWorkers = true;
-        _queue.reset();
-        _worker.join();
+        {
+            std::lock_guard<std::mutex> lk(_sleepLock);
+        }
+        _sleepCond.notify_all();
+        for (std::unique_ptr<Worker>& worker : _workers) {
+            worker->thread.join();
+        }
+
+        // release whatever never got to run
+        Task* task = nullptr;
+        while (tryGetTask(nullptr, &task)) {
+            task->release();
+        }
+    }
+
+    uint32_t workerCount() const { return static_cast<uint32_t>(_workers.size()); }
+
+    // 0 on any thread that isn't one of this scheduler's workers, worker index + 1 on workers. Lets callers keep per
+    // thread state in a flat array of workerCount() + 1 without locking
+    uint32_t threadSlot() {
+        Worker* worker = currentWorkerForScheduler();
+        return worker ? worker->index + 1 : 0;
+    }
+
+    void enqueue(const TaskPtr& task) {
+        Worker* worker = currentWorkerForScheduler();
+        push(task, worker);
+        if (!worker) {
+            _queue.enqueue(task.get());
+        }
+        wakeWorkers(1);
+    }
+
+    void enqueueAll(const std::vector<TaskPtr>& tasks) {
+        if (tasks.size() == 0) {
+            return;
+        }
+
+        Worker* worker = currentWorkerForScheduler();
+        for (const TaskPtr& task : tasks) {
+            push(task, worker);
+        }
+        if (!worker) {
+            _queue.enqueueAll(tasks);
+        }
+        wakeWorkers(static_cast<int32_t>(tasks.size()));
+    }
+
+    // the closure is stored inline in a pooled LambdaTask, no allocation once the pools are warm
+    template <class F, class = std::enable_if_t<std::is_invocable<F&>::value>>
+    TaskPtr enqueue(F&& function, TaskPriority priority = TaskPriority::Normal) {
+        TaskPtr task = makeTask<LambdaTask>(std::forward<F>(function));
+        task->setPriority(priority);
+        enqueue(task);
+        return task;
     }
 
-    TaskQueue* queue() { return _queue.get(); }
+    // Blocks until task (and all its children) are finished. The calling thread runs other queued tasks while it waits,
+    // so this is safe to call from the frame thread as well as from inside a task. Threads that aren't workers only help
+    // with High priority tasks: a frame thread waiting on a few ms of work shouldn't end up inside a long noise task.
+    // Workers still get to everything else, so this only costs the waiter some idle time.
+    void wait(const TaskPtr& task) {
+        dg_assert_nm(task != nullptr);
+        waitUntil([&task]() { return task->isFinished(); });
+    }
+
+    // same as wait() but for conditions that aren't a single task, ex. a counter other tasks decrement
+    template <class Pred>
+    void waitUntil(Pred&& done) {
+        Worker* worker        = currentWorkerForScheduler();
+        size_t  priorityCount = worker ? kPriorityCount : static_cast<size_t>(TaskPriority::High) + 1;
+        while (!done()) {
+            Task* other = nullptr;
+            if (tryGetTask(worker, &other, priorityCount)) {
+                runTask(other);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void wait(const std::vector<TaskPtr>& tasks) {
+        for (const TaskPtr& task : tasks) {
+            wait(task);
+        }
+    }
+
+    // Calls func(begin, end) over [0, count) split in chunks of at least minChunkSize and returns once every chunk is
+    // done. The calling thread takes the first chunk and then helps with the rest. func must be safe to call
+    // concurrently on disjoint ranges. Chunks are High priority, someone is blocked on them.
+    template <class Func>
+    void parallelFor(size_t count, size_t minChunkSize, const Func& func) {
+        dg_assert_nm(minChunkSize > 0);
+
+        // a few chunks per thread is enough to even out uneven work, more is just queue traffic
+        size_t maxChunks = (workerCount() + 1) * 4;
+        size_t chunkSize = std::max(minChunkSize, (count + maxChunks - 1) / maxChunks);
+        if (count <= chunkSize) {
+            func(size_t(0), count);
+            return;
+        }
+
+        // children keep the root unfinished, so one wait covers every chunk without collecting them in a vector
+        TaskPtr root = makeTask<LambdaTask>([]() {});
+        for (size_t begin = chunkSize; begin < count; begin += chunkSize) {
+            size_t  end   = std::min(count, begin + chunkSize);
+            TaskPtr chunk = makeTask<LambdaTask>([&func, begin, end]() { func(begin, end); });
+            chunk->setParent(root);
+            chunk->setPriority(TaskPriority::High);
+            enqueue(chunk);
+        }
+
+        func(size_t(0), chunkSize);
+        root->run();
+        wait(root);
+    }
 };
 
-static TaskScheduler* scheduler() {
+// Worker count comes from [TaskSchedulerSettings] WorkerCount, defaults to hardware threads - 1 when it's empty or
+// not a positive number
+inline TaskScheduler* scheduler() {
     static std::unique_ptr<TaskScheduler> scheduler;
-    if (scheduler == nullptr)
-        scheduler.reset(new TaskScheduler());
+    if (scheduler == nullptr) {
+        std::string workerCountStr = config::Config::getInstance().GetConfigString("TaskSchedulerSettings", "WorkerCount");
+        char*       end            = nullptr;
+        long        parsed         = std::strtol(workerCountStr.c_str(), &end, 10);
+        bool        valid          = end != workerCountStr.c_str() && *end == '\0' && parsed > 0;
+        uint32_t    workerCount    = valid ? static_cast<uint32_t>(parsed) : TaskScheduler::defaultWorkerCount();
+        scheduler.reset(new TaskScheduler(workerCount));
+    }
     return scheduler.get();
 }
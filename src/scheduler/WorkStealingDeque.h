@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+#include "DGAssert.h"
+
+// Chase-Lev work stealing deque (see "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013)
+// The owning thread pushes and pops at the bottom, any other thread may steal from the top.
+template <class T>
+class WorkStealingDeque {
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque items must be trivially copyable");
+
+    struct Buffer {
+        const int64_t                  capacity;
+        const int64_t                  mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        Buffer(int64_t capacity) : capacity(capacity), mask(capacity - 1), items(new std::atomic<T>[capacity]) {}
+
+        T    get(int64_t idx) const { return items[idx & mask].load(std::memory_order_relaxed); }
+        void put(int64_t idx, T item) { items[idx & mask].store(item, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t> _top{0};
+    alignas(64) std::atomic<int64_t> _bottom{0};
+    alignas(64) std::atomic<Buffer*> _buffer{nullptr};
+
+    // buffers we've grown out of. thieves may still be reading from them so they live as long as the deque does
+    std::vector<std::unique_ptr<Buffer>> _retired;
+
+public:
+    WorkStealingDeque(int64_t capacity = 256) {
+        dg_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of 2");
+        _retired.emplace_back(new Buffer(capacity));
+        _buffer.store(_retired.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // owner only
+    void push(T item) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        Buffer* a = _buffer.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only
+    bool pop(T* item) {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* a = _buffer.load(std::memory_order_relaxed);
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // empty
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        T x = a->get(b);
+        if (t == b) {
+            // last item, race against thieves for it
+            bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            if (!won) {
+                return false;
+            }
+        }
+        *item = x;
+        return true;
+    }
+
+    // any thread
+    bool steal(T* item) {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+
+        Buffer* a = _buffer.load(std::memory_order_acquire);
+        T       x = a->get(t);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        *item = x;
+        return true;
+    }
+
+    // approximate, only useful as a hint
+    bool empty() const { return _bottom.load(std::memory_order_relaxed) <= _top.load(std::memory_order_relaxed); }
+
+private:
+    Buffer* grow(Buffer* a, int64_t t, int64_t b) {
+        Buffer* grown = new Buffer(a->capacity * 2);
+        for (int64_t idx = t; idx < b; ++idx) {
+            grown->put(idx, a->get(idx));
+        }
+        _retired.emplace_back(grown);
+        _buffer.store(grown, std::memory_order_release);
+        return grown;
+    }
+};
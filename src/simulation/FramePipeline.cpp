@@ -0,0 +1,73 @@
+#include "FramePipeline.h"
+#include "Camera.h"
+#include "Config.h"
+#include "MeshRenderObj.h"
+#include "MeshRenderer.h"
+#include "TaskScheduler.h"
+
+FramePipeline::FramePipeline(bool pipelined, MeshRenderer* meshRenderer, Camera* simCamera, Camera* renderCamera)
+    : _pipelined(pipelined), _meshRenderer(meshRenderer), _simCamera(simCamera), _renderCamera(renderCamera) {
+    dg_assert_nm(_meshRenderer != nullptr && _simCamera != nullptr && _renderCamera != nullptr);
+    *_renderCamera = *_simCamera;
+    _simSnapshot   = &_snapshots[0];
+}
+
+FramePipeline::~FramePipeline() { Flush(); }
+
+bool FramePipeline::PipelinedFromConfig() {
+    return config::Config::getInstance().GetConfigString("FrameSettings", "Pipelined") == "y";
+}
+
+void FramePipeline::BeginFrame() {
+    if (_simTask == nullptr) {
+        return;
+    }
+
+    scheduler()->wait(_simTask);
+    _simTask.reset();
+    Apply(*_simSnapshot);
+}
+
+void FramePipeline::Simulate(std::function<void(void)> simulate) {
+    dg_assert(_simTask == nullptr, "BeginFrame wasn't called");
+
+    _simSnapshot = &_snapshots[_frame % kSnapshotCount];
+    _simSnapshot->Reset(_frame);
+    ++_frame;
+
+    if (!_pipelined) {
+        simulate();
+        _simSnapshot->camera = *_simCamera;
+        Apply(*_simSnapshot);
+        return;
+    }
+
+    _simulate = std::move(simulate);
+    _simTask  = scheduler()->enqueue([this]() {
+        _simulate();
+        _simSnapshot->camera = *_simCamera;
+    }, TaskPriority::High);
+}
+
+void FramePipeline::Flush() {
+    if (_simTask != nullptr) {
+        scheduler()->wait(_simTask);
+    }
+}
+
+void FramePipeline::Apply(const FrameSnapshot& snapshot) {
+    for (MeshRenderObj* renderObj : snapshot.newMeshRenderObjs) {
+        _meshRenderer->Register(renderObj);
+    }
+    for (const std::unique_ptr<MeshRenderObj>& renderObj : snapshot.retiredMeshRenderObjs) {
+        _meshRenderer->Unregister(renderObj.get());
+    }
+
+    // palettes are referenced, not copied. the slot stays untouched until the frame after next
+    for (const FrameSnapshot::MeshInstance& instance : snapshot.meshInstances) {
+        *instance.renderObj->transform() = instance.transform;
+        instance.renderObj->bonePalette(snapshot.bonePalette.data() + instance.boneOffset, instance.boneCount);
+    }
+
+    *_renderCamera = snapshot.camera;
+}
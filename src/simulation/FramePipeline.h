@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include "FrameSnapshot.h"
+#include "Task.h"
+
+class MeshRenderer;
+
+// Hands simulation results to the renderer through FrameSnapshots.
+//
+// Single threaded (default): simulate and render run back to back on the frame thread, the snapshot is consumed the
+// same frame it was produced.
+// Pipelined ([FrameSettings] Pipelined=y): simulation of frame N runs on a worker while the frame thread renders the
+// snapshot of frame N-1, so the renderer sees everything one frame late. The frame thread keeps the device, input and
+// anything that touches render objects directly (ex. ui), the worker only ever writes its own snapshot slot.
+class FramePipeline {
+private:
+    // renderer reads one slot while the simulation writes the other. render submission consumes its snapshot before
+    // the frame returns, so a third slot would only add latency
+    static constexpr uint32_t kSnapshotCount = 2;
+
+    std::array<FrameSnapshot, kSnapshotCount> _snapshots;
+    uint64_t                                  _frame{0};
+    FrameSnapshot*                            _simSnapshot{nullptr};
+    bool                                      _pipelined{false};
+    TaskPtr                                   _simTask;
+    std::function<void(void)>                 _simulate;
+    MeshRenderer*                             _meshRenderer{nullptr};
+    Camera*                                   _simCamera{nullptr};
+    Camera*                                   _renderCamera{nullptr};
+
+public:
+    FramePipeline(bool pipelined, MeshRenderer* meshRenderer, Camera* simCamera, Camera* renderCamera);
+    ~FramePipeline();
+
+    static bool PipelinedFromConfig();
+
+    bool IsPipelined() const { return _pipelined; }
+
+    // slot the current simulation step writes into. only valid from inside the simulate function
+    FrameSnapshot* SimSnapshot() { return _simSnapshot; }
+
+    // waits for last frame's simulation and hands its snapshot to the renderer. call before touching any sim state
+    void BeginFrame();
+
+    // runs simulate for this frame, on a worker when pipelined
+    void Simulate(std::function<void(void)> simulate);
+
+    // waits for any in flight simulation without consuming it
+    void Flush();
+
+private:
+    void Apply(const FrameSnapshot& snapshot);
+};
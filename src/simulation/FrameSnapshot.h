@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "Camera.h"
+#include "DMath.h"
+#include "MeshRenderObj.h"
+
+// Everything the render side needs out of one simulation step. The simulation fills it in, after that it's read only
+// until the slot comes around again.
+struct FrameSnapshot {
+    struct MeshInstance {
+        MeshRenderObj* renderObj{nullptr};
+        dm::Transform  transform;
+        uint32_t       boneOffset{0}; // into bonePalette
+        uint32_t       boneCount{0};
+    };
+
+    uint64_t                    frame{0};
+    Camera                      camera;
+    std::vector<MeshInstance>   meshInstances;
+    std::vector<glm::mat4>      bonePalette;       // every instance's bones back to back
+    std::vector<MeshRenderObj*> newMeshRenderObjs; // created this step, need registering before they can draw
+    // dropped by the simulation this step. unregistered when the snapshot is applied, freed when the slot is reused
+    std::vector<std::unique_ptr<MeshRenderObj>> retiredMeshRenderObjs;
+
+    // clears but keeps capacity so steady state frames dont allocate
+    void Reset(uint64_t frameIdx) {
+        frame = frameIdx;
+        meshInstances.clear();
+        bonePalette.clear();
+        newMeshRenderObjs.clear();
+        retiredMeshRenderObjs.clear();
+    }
+
+    // returns the offset of count contiguous matrices in bonePalette
+    uint32_t AllocateBones(uint32_t count) {
+        uint32_t offset = static_cast<uint32_t>(bonePalette.size());
+        bonePalette.resize(offset + count);
+        return offset;
+    }
+};
@@ -26,7 +26,7 @@ public:
 
     template <typename T>
     T* GetComponent() {
-        return manager->GetComponent(_id, T::type());
+        return manager->GetComponent<T>(_id);
     }
 
     template <typename T>
@@ -1,97 +1,195 @@
 #include "SimulationManager.h"
 #include "SimObj.h"
+#include "TaskScheduler.h"
 
-#include <type_traits>
+#include <array>
+#include <optional>
+
+static constexpr uint32_t kSimObjPageShift = 10;
+static constexpr uint32_t kSimObjPageSize = 1u << kSimObjPageShift;
+
+struct SimObjPage {
+    std::array<std::optional<SimObj>, kSimObjPageSize> objs;
+};
 
 SimulationManager::SimulationManager(EventManager* em)
     : eventManager(em)
-{}
+{
+    _components.RegisterPool<Spatial>();
+    _components.RegisterPool<UI>();
+    _components.RegisterPool<SkinnedMesh>();
+    _components.RegisterPool<AnimationComponent>();
+    _components.RegisterPool<PlayerControlled>();
+}
 
 SimulationManager::~SimulationManager() = default;
 
 SimObj* SimulationManager::CreateSimObj() {
-    dg_assert(nextObjId < MAX_SIM_OBJECTS, "Max simobjects reached");
-    _simObjs[nextObjId] = std::make_unique<SimObj>(nextObjId, this);
-    return _simObjs[nextObjId++].get();
+    EntityId index;
+    if (!_freeIndices.empty()) {
+        index = _freeIndices.back();
+        _freeIndices.pop_back();
+    }
+    else {
+        index = static_cast<EntityId>(_generations.size());
+        _generations.push_back(0);
+        if ((index >> kSimObjPageShift) >= _simObjPages.size()) {
+            _simObjPages.emplace_back(std::make_unique<SimObjPage>());
+        }
+    }
+
+    std::optional<SimObj>& slot = _simObjPages[index >> kSimObjPageShift]->objs[index & (kSimObjPageSize - 1)];
+    slot.emplace(MakeEntityHandle(index, _generations[index]), this);
+    ++_liveCount;
+    return &*slot;
+}
+
+void SimulationManager::DestroySimObj(SimObj* obj) {
+    dg_assert_nm(obj != nullptr);
+    dg_assert(IsAlive(obj->_id), "SimObj already destroyed");
+
+    EntityId index = EntityIndex(obj->_id);
+    _components.RemoveAll(index);
+    _simObjPages[index >> kSimObjPageShift]->objs[index & (kSimObjPageSize - 1)].reset();
+    ++_generations[index];
+    _destroyedIndices.push_back(index);
+    --_liveCount;
+}
+
+SimObj* SimulationManager::GetSimObj(uint64_t id) {
+    if (!IsAlive(id)) {
+        return nullptr;
+    }
+    EntityId index = EntityIndex(id);
+    return &*_simObjPages[index >> kSimObjPageShift]->objs[index & (kSimObjPageSize - 1)];
+}
+
+bool SimulationManager::IsAlive(uint64_t id) const {
+    EntityId index = EntityIndex(id);
+    return index < _generations.size() && _generations[index] == EntityGeneration(id);
 }
 
 void SimulationManager::UpdateViewport(const Viewport& vp) {
-    for (auto& p: managers) {
-        p.first->UpdateViewport(vp);
+    for (ManagerNode& node : managers) {
+        node.manager->UpdateViewport(vp);
     }
 }
 
+void SimulationManager::AddManagerNode(std::unique_ptr<ComponentManager> manager, const ComponentAccess& access) {
+    uint32_t idx = static_cast<uint32_t>(managers.size());
+    for (ManagerNode& node : managers) {
+        if (node.access.ConflictsWith(access)) {
+            node.successors.push_back(idx);
+        }
+    }
+    managers.push_back({std::move(manager), access, {}});
+
+    _pendingDeps.reset(new std::atomic<uint32_t>[managers.size()]);
+    _managerTasks.resize(managers.size());
+    _managerIncluded.resize(managers.size());
+}
+
 void SimulationManager::DoUpdate(float ms) {
-    for (auto& p : managers) {
-        auto types = p.second;
-        std::map<ComponentType, const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*> components;
-        for (int i = 0; i < (int)ComponentType::COUNT; ++i) {
-            switch ((ComponentType)i) {
-            case ComponentType::Spatial:
-				components[ComponentType::Spatial] = reinterpret_cast<const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>(&spatials);
-				break;
-            case ComponentType::UI:
-				components[ComponentType::UI] = reinterpret_cast<const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>(&uis);
-				break;
-            case ComponentType::SkinnedMesh:
-				components[ComponentType::SkinnedMesh] = reinterpret_cast<const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>(&skinnedMeshs);
-				break;
-            case ComponentType::Animation:
-				components[ComponentType::Animation] = reinterpret_cast<const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>(&animations);
-				break;
-            case ComponentType::PlayerControlled:
-                components[ComponentType::PlayerControlled] = reinterpret_cast<const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>(&playerControlled);
-                break;
-            default:
-                dg_assert_fail("Unhandled ComponentType");
-                break;
+    BeginUpdate();
+    RunManagers(ManagerFilter::All, ms);
+}
+
+void SimulationManager::DoFrameThreadUpdate(float ms) {
+    // first thing each frame in pipelined mode, nothing else is touching components yet
+    BeginUpdate();
+    RunManagers(ManagerFilter::FrameThread, ms);
+}
+
+void SimulationManager::DoWorkerUpdate(float ms) {
+    RunManagers(ManagerFilter::Worker, ms);
+}
+
+void SimulationManager::BeginUpdate() {
+    _components.SortPools();
+
+    // managers have now had a full update without these, safe to hand them out again
+    _freeIndices.insert(_freeIndices.end(), _retiringIndices.begin(), _retiringIndices.end());
+    _retiringIndices.swap(_destroyedIndices);
+    _destroyedIndices.clear();
+}
+
+void SimulationManager::RunManagers(ManagerFilter filter, float ms) {
+    uint32_t count = static_cast<uint32_t>(managers.size());
+    _updateMs      = ms;
+
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        bool frameThread      = managers[idx].manager->RunsOnFrameThread();
+        _managerIncluded[idx] = filter == ManagerFilter::All || (filter == ManagerFilter::FrameThread) == frameThread;
+        _pendingDeps[idx].store(0, std::memory_order_relaxed);
+    }
+
+    // only dependencies inside this run count, in pipelined mode the other half of the update has already happened
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        if (!_managerIncluded[idx]) {
+            continue;
+        }
+        for (uint32_t succ : managers[idx].successors) {
+            if (_managerIncluded[succ]) {
+                _pendingDeps[succ].fetch_add(1, std::memory_order_relaxed);
             }
         }
-		p.first->DoUpdate(components, ms);
+    }
+
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        if (_managerIncluded[idx] && !managers[idx].manager->RunsOnFrameThread()) {
+            _managerTasks[idx] = makeTask<LambdaTask>([this, idx]() { RunManagerNode(idx); });
+            _managerTasks[idx]->setPriority(TaskPriority::High); // the frame waits on these
+        }
+    }
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        if (_managerTasks[idx] != nullptr && _pendingDeps[idx].load(std::memory_order_relaxed) == 0) {
+            scheduler()->enqueue(_managerTasks[idx]);
+        }
+    }
+
+    // frame thread managers run right here in registration order, the rest get kicked off by whatever they wait on.
+    // dependencies only ever point at earlier managers, so this can't wait on something that waits on it
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        if (_managerIncluded[idx] && _managerTasks[idx] == nullptr) {
+            std::atomic<uint32_t>& pending = _pendingDeps[idx];
+            scheduler()->waitUntil([&pending]() { return pending.load(std::memory_order_acquire) == 0; });
+            RunManagerNode(idx);
+        }
+    }
+
+    for (TaskPtr& task : _managerTasks) {
+        if (task != nullptr) {
+            scheduler()->wait(task);
+            task.reset();
+        }
     }
 }
 
-bool SimulationManager::HasComponent(uint64_t key, ComponentType t) {
-    dg_assert_nm(key < MAX_SIM_OBJECTS);
-    switch (t) {
-        case ComponentType::Spatial: return spatials[key] != nullptr;
-        case ComponentType::UI: return uis[key] != nullptr;
-        case ComponentType::SkinnedMesh: return skinnedMeshs[key] != nullptr;
-        case ComponentType::Animation: return animations[key] != nullptr;
-        case ComponentType::PlayerControlled: return playerControlled[key] != nullptr;
-        default: dg_assert_fail("type not accounted for."); break;
+void SimulationManager::RunManagerNode(uint32_t idx) {
+    UpdateManager(managers[idx].manager.get(), _updateMs);
+
+    for (uint32_t succ : managers[idx].successors) {
+        if (_managerIncluded[succ] && _pendingDeps[succ].fetch_sub(1, std::memory_order_acq_rel) == 1 && _managerTasks[succ] != nullptr) {
+            scheduler()->enqueue(_managerTasks[succ]);
+        }
     }
-    return false;
+}
+
+void SimulationManager::UpdateManager(ComponentManager* manager, float ms) {
+    manager->DoUpdate(_components, ms);
+}
+
+bool SimulationManager::HasComponent(uint64_t key, ComponentType t) {
+    dg_assert(IsAlive(key), "SimObj has been destroyed");
+    return _components.Pool(t)->Has(EntityIndex(key));
 }
 
 Component* SimulationManager::AddComponent(uint64_t key, ComponentType t) {
-    dg_assert_nm(key < MAX_SIM_OBJECTS);
-
-    auto checkAddComp = [](auto& cs, uint64_t key) {
-        dg_assert_nm(!cs[key]);
-        cs[key] = std::make_unique<std::remove_pointer_t<decltype(cs[key].get())>>();
-        return cs[key].get();
-    };
-
-    switch (t) {
-        case ComponentType::Spatial: return checkAddComp(spatials, key);
-        case ComponentType::UI: return checkAddComp(uis, key);
-        case ComponentType::SkinnedMesh: return checkAddComp(skinnedMeshs, key);
-        case ComponentType::Animation: return checkAddComp(animations, key);
-        case ComponentType::PlayerControlled: return checkAddComp(playerControlled, key);
-        default: dg_assert_fail("type not accounted for."); break;
-    }
-    return nullptr;
+    dg_assert(IsAlive(key), "SimObj has been destroyed");
+    return _components.Pool(t)->AddDefault(EntityIndex(key));
 }
 
 void SimulationManager::RemoveComponent(uint64_t key, ComponentType t) {
-    dg_assert_nm(key < MAX_SIM_OBJECTS);
-    switch (t) {
-        case ComponentType::Spatial: return spatials[key].reset();
-        case ComponentType::UI: return uis[key].reset();
-        case ComponentType::SkinnedMesh: return skinnedMeshs[key].reset();
-        case ComponentType::Animation: return animations[key].reset();
-        case ComponentType::PlayerControlled: return playerControlled[key].reset();
-        default: dg_assert_fail("type not accounted for."); break;
-    }
-}
\ No newline at end of file
+    dg_assert(IsAlive(key), "SimObj has been destroyed");
+    _components.Pool(t)->Remove(EntityIndex(key));
+}
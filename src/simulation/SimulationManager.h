@@ -4,32 +4,50 @@
 #include "UI.h"
 #include "SkinnedMesh.h"
 #include "AnimationComponent.h"
+#include "ComponentAccess.h"
 #include "ComponentManager.h"
+#include "ComponentStore.h"
 #include "EventManager.h"
 #include "PlayerControlled.h"
+#include "Task.h"
 
+#include <atomic>
 #include <vector>
-#include <array>
 #include <memory>
 
-// this is manually set in componentManager also, yey hardcodes
-constexpr uint32_t MAX_SIM_OBJECTS = 1024;
-
 class SimObj;
+struct SimObjPage;
+
 class SimulationManager {
 private:
     friend class SimObj;
-    std::array<std::unique_ptr<Spatial>, MAX_SIM_OBJECTS> spatials;
-    std::array<std::unique_ptr<UI>, MAX_SIM_OBJECTS> uis;
-    std::array<std::unique_ptr<SkinnedMesh>, MAX_SIM_OBJECTS> skinnedMeshs;
-    std::array<std::unique_ptr<AnimationComponent>, MAX_SIM_OBJECTS> animations;
-    std::array<std::unique_ptr<PlayerControlled>, MAX_SIM_OBJECTS> playerControlled;
+    ComponentStore _components;
 
-    std::array<std::unique_ptr<SimObj>, MAX_SIM_OBJECTS> _simObjs;
+    // SimObjs live in fixed size pages so handing out pointers is safe while the entity count grows
+    std::vector<std::unique_ptr<SimObjPage>> _simObjPages;
+    std::vector<uint32_t> _generations;     // per entity index, bumped on destroy
+    std::vector<EntityId> _freeIndices;
+    // destroyed indices sit out one full update before reuse, so managers see the entity go away
+    // before a new one shows up under the same index
+    std::vector<EntityId> _destroyedIndices;
+    std::vector<EntityId> _retiringIndices;
+    uint32_t _liveCount{0};
 
-    std::vector<std::pair<std::unique_ptr<ComponentManager>, std::vector<ComponentType>>> managers;
+    // Managers run as a graph: a manager waits only for earlier registered managers whose access conflicts with its own,
+    // everything else runs at the same time on the scheduler. State outside of components (camera, snapshot, ...) isn't
+    // tracked, managers sharing it need to declare a common write
+    struct ManagerNode {
+        std::unique_ptr<ComponentManager> manager;
+        ComponentAccess                   access;
+        std::vector<uint32_t>             successors; // later managers that conflict with this one
+    };
+    std::vector<ManagerNode> managers;
 
-    uint64_t nextObjId{0};
+    // per update scratch, sized on registration so running the graph doesn't allocate
+    std::unique_ptr<std::atomic<uint32_t>[]> _pendingDeps;
+    std::vector<TaskPtr>                     _managerTasks;
+    std::vector<uint8_t>                     _managerIncluded;
+    float                                    _updateMs{0.f};
 
     EventManager* eventManager;
 
@@ -37,34 +55,43 @@ public:
     SimulationManager(EventManager* em);
     ~SimulationManager();
     template <class T, typename... Args>
-    void RegisterManager(const std::vector<ComponentType>& types, Args&&... args) {
-        managers.emplace_back(std::make_unique<T>(std::forward<Args>(args)...), types);
+    void RegisterManager(const ComponentAccess& access, Args&&... args) {
+        AddManagerNode(std::make_unique<T>(std::forward<Args>(args)...), access);
     }
 
     SimObj* CreateSimObj();
+    // removes all of the object's components, obj is invalid afterwards
+    void DestroySimObj(SimObj* obj);
+    // nullptr if the object has been destroyed
+    SimObj* GetSimObj(uint64_t id);
+    bool IsAlive(uint64_t id) const;
+    uint32_t LiveSimObjCount() const { return _liveCount; }
+
     void DoUpdate(float ms);
 
+    // split of DoUpdate for pipelined frames, see ComponentManager::RunsOnFrameThread
+    void DoFrameThreadUpdate(float ms);
+    void DoWorkerUpdate(float ms);
+
     // todo: this is mostly a hack for ui manager
     void UpdateViewport(const Viewport& vp);
 
 private:
+    enum class ManagerFilter { All, FrameThread, Worker };
+
+    void AddManagerNode(std::unique_ptr<ComponentManager> manager, const ComponentAccess& access);
+    void BeginUpdate();
+    void RunManagers(ManagerFilter filter, float ms);
+    void RunManagerNode(uint32_t idx);
+    void UpdateManager(ComponentManager* manager, float ms);
+
     bool HasComponent(uint64_t key, ComponentType t);
     Component* AddComponent(uint64_t key, ComponentType t);
     void RemoveComponent(uint64_t key, ComponentType t);
 
     template <typename T>
-    T* GetComponent(uint64_t key, ComponentType t) {
-        dg_assert_nm(key < MAX_SIM_OBJECTS);
-        switch(t) {
-            case ComponentType::Spatial:     return spatials[key];
-            case ComponentType::UI:          return uis[key];
-            case ComponentType::SkinnedMesh: return skinnedMeshs[key];
-            case ComponentType::Animation:   return animations[key];
-            case ComponentType::PlayerControlled: return playerControlled[key];
-            default:
-                dg_assert_fail("type not accounted for.");
-            break;
-        }
-        return nullptr;
+    T* GetComponent(uint64_t key) {
+        dg_assert(IsAlive(key), "SimObj has been destroyed");
+        return _components.TryGet<T>(EntityIndex(key));
     }
 };
\ No newline at end of file
@@ -0,0 +1,30 @@
+// planet-replay <capture> [frames]
+// Plays a frame captured with '/capture' back on the null backend, so CPU side backend changes can be timed against
+// the exact same command stream without a window or GPU. Use '/replay' in game for the real backends.
+
+#include <cstdio>
+#include <string>
+#include "CaptureCommands.h"
+#include "NullBackend.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s <capture> [frames]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t frames = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1000;
+
+    gfx::NullBackend backend;
+    gfx::NullDevice* device = static_cast<gfx::NullDevice*>(backend.getRenderDevice());
+    device->SetRecording(false);
+
+    std::string summary = gfx::capture::ReplayCapture(device, argv[1], frames);
+    printf("%s\n", summary.c_str());
+
+    // totals over load, warm up and every replayed frame
+    const gfx::TraceStats& stats = device->Stats();
+    printf("passes %u, draws %u (%u instances), pipeline changes %u, vb changes %u, buffer maps %u, texture updates %u\n", stats.renderPasses,
+           stats.drawCalls, stats.instances, stats.pipelineStateChanges, stats.vertexBufferChanges, stats.bufferMaps, stats.textureUpdates);
+    return 0;
+}
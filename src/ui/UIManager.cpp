@@ -205,20 +205,12 @@ void UIManager::PostProcess(float ms) {
     }
 }
 
-void UIManager::DoUpdate(std::map<ComponentType, const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>& components, float ms) {
-    assert(components[ComponentType::UI] != nullptr);
-    assert(components[ComponentType::Spatial] != nullptr);
-    auto& uis = *reinterpret_cast<const std::array<std::unique_ptr<UI>, MAX_SIM_OBJECTS>*>(components[ComponentType::UI]);
-    auto& spatials = *reinterpret_cast<const std::array<std::unique_ptr<Spatial>, MAX_SIM_OBJECTS>*>(components[ComponentType::Spatial]);
-    for (size_t i = 0; i < MAX_SIM_OBJECTS; ++i) {
-        UI* ui = uis[i].get();
-        Spatial* spatial = spatials[i].get();
-        if (ui != nullptr && spatial != nullptr) {
-            // todo: handle updates from components
-            if (m_uiFrames.find(i) == m_uiFrames.end())
-                AddFrameObj((uint64_t)i, ui, spatial);
-        }
-    }
+void UIManager::DoUpdate(ComponentStore& components, float ms) {
+    components.view<UI, Spatial>().each([&](EntityId entity, UI& ui, Spatial& spatial) {
+        // todo: handle updates from components
+        if (m_uiFrames.find(entity) == m_uiFrames.end())
+            AddFrameObj((uint64_t)entity, &ui, &spatial);
+    });
 
     PreProcess();
 
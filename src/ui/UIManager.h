@@ -60,7 +60,10 @@ public:
 
     void UpdateViewport(const Viewport& vp) override;
 
-    void DoUpdate(std::map<ComponentType, const std::array<std::unique_ptr<Component>, MAX_SIM_OBJECTS>*>& components, float ms) override;
+    void DoUpdate(ComponentStore& components, float ms) override;
+
+    // dom trees register and update text/ui render objects in place
+    bool RunsOnFrameThread() const override { return true; }
 
     UIFrame* GetFrame(const std::string& name);
 
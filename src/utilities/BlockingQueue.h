@@ -1,9 +1,11 @@
 #pragma once
 
+#include <condition_variable>
 #include <deque>
 #include <iterator>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 template <class T>
 class BlockingQueue {
@@ -29,4 +29,31 @@ public:
     const uint32_t &EBX() const { return regs[1]; }
     const uint32_t &ECX() const { return regs[2]; }
     const uint32_t &EDX() const { return regs[3]; }
-};
\ No newline at end of file
+};
+
+// xcr0, which register state the os saves across context switches. only ask when cpuid 1 reports OSXSAVE
+inline unsigned long long XGetBv() {
+#ifdef _WIN32
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    asm volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+inline bool CpuHasSSE41() { return (CpuId(1).ECX() & (1u << 19)) != 0; }
+
+inline bool CpuHasAVX2() {
+    if (CpuId(0).EAX() < 7) {
+        return false;
+    }
+    // avx needs the os to save ymm state too, OSXSAVE says xgetbv can be asked about it
+    CpuId leaf1(1);
+    bool  osxsave = (leaf1.ECX() & (1u << 27)) != 0;
+    bool  avx     = (leaf1.ECX() & (1u << 28)) != 0;
+    if (!osxsave || !avx || (XGetBv() & 0x6) != 0x6) {
+        return false;
+    }
+    return (CpuId(7).EBX() & (1u << 5)) != 0;
+}
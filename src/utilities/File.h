@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -52,4 +54,31 @@ bool IsPathDirectory(const std::string& path);
 
 bool exists(const std::string& path);
 bool mkdir(const std::string& path);
+
+/**
+ * Read only view of a whole file, mapped rather than read so big files cost nothing until they're touched.
+ * Unmapped on Close or destruction, pointers into data() die with it. Other handles can keep writing to the file while
+ * it's mapped, the view stays the size it was opened at
+**/
+class MappedFile {
+private:
+    const uint8_t* _data{nullptr};
+    size_t         _size{0};
+    void*          _mapping{nullptr}; // win32 mapping handle, unused on posix
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // fails on missing or empty files
+    bool Open(const std::string& path);
+    void Close();
+
+    const uint8_t* data() const { return _data; }
+    size_t         size() const { return _size; }
+    bool           isOpen() const { return _data != nullptr; }
+};
 }
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "DGAssert.h"
+
+// Bump allocator over a list of chunks. Reset rewinds to the first chunk and keeps every chunk it has, so once the
+// arena has grown to a frame's worth a frame allocates nothing. Nothing is freed on its own and no destructors run,
+// only put trivially destructible things in here. Not thread safe
+class LinearArena {
+private:
+    struct Chunk {
+        std::unique_ptr<uint8_t[]> data;
+        size_t                     size;
+    };
+
+    size_t             _chunkSize;
+    std::vector<Chunk> _chunks;
+    size_t             _chunkIdx{0};
+    size_t             _offset{0};
+    size_t             _bytesUsed{0};
+
+public:
+    explicit LinearArena(size_t chunkSize = 64 * 1024) : _chunkSize(chunkSize) {}
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        dg_assert(align <= alignof(std::max_align_t) && (align & (align - 1)) == 0, "unsupported alignment %zu", align);
+        while (true) {
+            if (_chunkIdx == _chunks.size()) {
+                size_t chunkSize = std::max(_chunkSize, size);
+                _chunks.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[chunkSize]), chunkSize});
+            }
+
+            Chunk& chunk = _chunks[_chunkIdx];
+            size_t start = (_offset + align - 1) & ~(align - 1);
+            if (start + size <= chunk.size) {
+                _offset = start + size;
+                _bytesUsed += size;
+                return chunk.data.get() + start;
+            }
+            ++_chunkIdx;
+            _offset = 0;
+        }
+    }
+
+    void Reset() {
+        _chunkIdx  = 0;
+        _offset    = 0;
+        _bytesUsed = 0;
+    }
+
+    size_t BytesUsed() const { return _bytesUsed; }
+    size_t BytesReserved() const {
+        size_t total = 0;
+        for (const Chunk& chunk : _chunks) {
+            total += chunk.size;
+        }
+        return total;
+    }
+};
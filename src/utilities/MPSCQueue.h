@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdint.h>
+#include <vector>
+#include "DGAssert.h"
+
+// Bounded lock-free multi producer / single consumer ring (Vyukov's bounded queue, single consumer side).
+// Items are moved in and out, never copied. Only one thread may call tryDequeue/drain.
+// Nothing ever waits for space: the consumer can be running producer tasks itself (frame thread helping in a wait), so a
+// producer spinning on a full ring could livelock. Producers either handle tryEnqueue failing, or cap how many items
+// they can have outstanding below capacity() and use enqueue.
+template <class T>
+class MPSCQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    const size_t            _mask;
+    std::unique_ptr<Cell[]> _cells;
+
+    alignas(64) std::atomic<size_t> _enqueuePos{0};
+    alignas(64) size_t _dequeuePos{0};
+
+public:
+    MPSCQueue(size_t capacity = 1024) : _mask(capacity - 1), _cells(new Cell[capacity]) {
+        dg_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0, "capacity must be a power of 2");
+        for (size_t idx = 0; idx < capacity; ++idx) {
+            _cells[idx].sequence.store(idx, std::memory_order_relaxed);
+        }
+    }
+
+    ~MPSCQueue() {
+        Cell* cell = nullptr;
+        while ((cell = readyCell()) != nullptr) {
+            cell->item()->~T();
+            release(cell);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    // returns false if the queue is full. item is left untouched in that case
+    bool tryEnqueue(T&& item) {
+        Cell*  cell = nullptr;
+        size_t pos  = _enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell         = &_cells[pos & _mask];
+            size_t   seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (cell->storage) T(std::move(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // for producers that keep what they have outstanding under capacity(), a full ring means that cap is broken
+    void enqueue(T&& item) {
+        if (!tryEnqueue(std::move(item))) {
+            dg_assert(false, "MPSCQueue full, more items outstanding than its capacity of %zu", capacity());
+        }
+    }
+
+    // consumer only
+    bool tryDequeue(T* item) {
+        Cell* cell = readyCell();
+        if (cell == nullptr) {
+            return false;
+        }
+        *item = std::move(*cell->item());
+        cell->item()->~T();
+        release(cell);
+        return true;
+    }
+
+    // consumer only. moves up to maxItems into dst, returns how many were moved
+    size_t drain(std::vector<T>* dst, size_t maxItems = std::numeric_limits<size_t>::max()) {
+        size_t count = 0;
+        Cell*  cell  = nullptr;
+        while (count < maxItems && (cell = readyCell()) != nullptr) {
+            dst->emplace_back(std::move(*cell->item()));
+            cell->item()->~T();
+            release(cell);
+            ++count;
+        }
+        return count;
+    }
+
+    size_t capacity() const { return _mask + 1; }
+
+private:
+    Cell* readyCell() {
+        Cell*    cell = &_cells[_dequeuePos & _mask];
+        size_t   seq  = cell->sequence.load(std::memory_order_acquire);
+        intptr_t dif  = static_cast<intptr_t>(seq) - static_cast<intptr_t>(_dequeuePos + 1);
+        return dif < 0 ? nullptr : cell;
+    }
+
+    void release(Cell* cell) {
+        cell->sequence.store(_dequeuePos + _mask + 1, std::memory_order_release);
+        ++_dequeuePos;
+    }
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Stable LSD radix sort on a 64 bit key, one byte per pass. All eight histograms come out of a single read of the
+// keys and any byte that is the same for every item skips its pass, so keys that only vary in a few bytes (sort keys
+// do) cost a few linear passes. scratch is only working space, it comes back holding whatever.
+template <typename T, typename KeyFunc>
+void RadixSort64(std::vector<T>& items, std::vector<T>& scratch, KeyFunc key) {
+    constexpr uint32_t kPasses  = 8;
+    constexpr uint32_t kBuckets = 256;
+
+    const size_t count = items.size();
+    if (count < 2) {
+        return;
+    }
+
+    uint32_t histograms[kPasses][kBuckets];
+    memset(histograms, 0, sizeof(histograms));
+    for (const T& item : items) {
+        uint64_t k = key(item);
+        for (uint32_t pass = 0; pass < kPasses; ++pass) {
+            ++histograms[pass][(k >> (pass * 8)) & 0xff];
+        }
+    }
+
+    scratch.resize(count);
+    std::vector<T>* src = &items;
+    std::vector<T>* dst = &scratch;
+    for (uint32_t pass = 0; pass < kPasses; ++pass) {
+        uint32_t* histogram = histograms[pass];
+        uint64_t  firstKey  = key((*src)[0]);
+        if (histogram[(firstKey >> (pass * 8)) & 0xff] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < kBuckets; ++bucket) {
+            uint32_t bucketCount = histogram[bucket];
+            histogram[bucket]    = offset;
+            offset += bucketCount;
+        }
+
+        for (const T& item : *src) {
+            (*dst)[histogram[(key(item) >> (pass * 8)) & 0xff]++] = item;
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != &items) {
+        items.swap(scratch);
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdint.h>
+#include <vector>
+#include "DGAssert.h"
+
+// Bounded lock-free single producer / single consumer ring. Items are moved in and out, never copied.
+// Same rule as MPSCQueue: nothing waits for space, enqueue is for producers that keep under capacity()
+template <class T>
+class SPSCQueue {
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    const size_t            _mask;
+    std::unique_ptr<Slot[]> _slots;
+
+    // producer side
+    alignas(64) std::atomic<size_t> _tail{0};
+    size_t _cachedHead{0};
+
+    // consumer side
+    alignas(64) std::atomic<size_t> _head{0};
+    size_t _cachedTail{0};
+
+public:
+    SPSCQueue(size_t capacity = 1024) : _mask(capacity - 1), _slots(new Slot[capacity]) {
+        dg_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0, "capacity must be a power of 2");
+    }
+
+    ~SPSCQueue() {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        for (; head != tail; ++head) {
+            _slots[head & _mask].item()->~T();
+        }
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    // producer only. returns false if the queue is full, item is left untouched in that case
+    bool tryEnqueue(T&& item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cachedHead > _mask) {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if (tail - _cachedHead > _mask) {
+                return false;
+            }
+        }
+
+        new (_slots[tail & _mask].storage) T(std::move(item));
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // producer only
+    void enqueue(T&& item) {
+        if (!tryEnqueue(std::move(item))) {
+            dg_assert(false, "SPSCQueue full, more items outstanding than its capacity of %zu", capacity());
+        }
+    }
+
+    // consumer only
+    bool tryDequeue(T* item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _cachedTail) {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            if (head == _cachedTail) {
+                return false;
+            }
+        }
+
+        T* src = _slots[head & _mask].item();
+        *item  = std::move(*src);
+        src->~T();
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only. moves up to maxItems into dst, returns how many were moved
+    size_t drain(std::vector<T>* dst, size_t maxItems = std::numeric_limits<size_t>::max()) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        _cachedTail = _tail.load(std::memory_order_acquire);
+
+        size_t count = 0;
+        for (; head != _cachedTail && count < maxItems; ++head, ++count) {
+            T* src = _slots[head & _mask].item();
+            dst->emplace_back(std::move(*src));
+            src->~T();
+        }
+        _head.store(head, std::memory_order_release);
+        return count;
+    }
+
+    size_t capacity() const { return _mask + 1; }
+};
@@ -1,9 +1,12 @@
 #include "File.h"
 #include <cassert>
+#include <cstring>
 #include <dirent.h>
 #include <fstream>
 #include <iostream>
+#include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include "Log.h"
@@ -80,3 +83,39 @@ std::vector<std::string> fs::ListFilesInDirectory(const std::string& path) {
     }
     return fnames;
 }
+
+bool fs::MappedFile::Open(const std::string& path) {
+    Close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_E("Couldnt open file %s\n", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // the mapping keeps its own reference to the file
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        LOG_E("Couldnt map file %s\n", path.c_str());
+        return false;
+    }
+
+    _data = static_cast<const uint8_t*>(data);
+    _size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void fs::MappedFile::Close() {
+    if (_data != nullptr) {
+        munmap(const_cast<uint8_t*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+}
@@ -55,4 +55,52 @@ namespace fs {
         BOOL rtn = CreateDirectory(dutil::utf8_to_wstring(path).c_str(), NULL);
         return (rtn == 0 || rtn == ERROR_ALREADY_EXISTS);
     }
-}
\ No newline at end of file
+
+    bool MappedFile::Open(const std::string& path) {
+        Close();
+
+        // share write both ways: files still being appended to (tile packs) get remapped, and the mapping holds the file
+        // open with this share mode for as long as it lives, so anything opening it for writing later needs it too
+        HANDLE file = CreateFile(dutil::utf8_to_wstring(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            LOG_E("Couldnt open file %s\n", path.c_str());
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+
+        // the mapping keeps its own reference to the file
+        HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(file);
+        if (mapping == NULL) {
+            LOG_E("Couldnt map file %s\n", path.c_str());
+            return false;
+        }
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == NULL) {
+            CloseHandle(mapping);
+            LOG_E("Couldnt map file %s\n", path.c_str());
+            return false;
+        }
+
+        _data    = static_cast<const uint8_t*>(data);
+        _size    = static_cast<size_t>(fileSize.QuadPart);
+        _mapping = mapping;
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (_data != nullptr) {
+            UnmapViewOfFile(_data);
+            CloseHandle(_mapping);
+        }
+        _data    = nullptr;
+        _size    = 0;
+        _mapping = nullptr;
+    }
+}